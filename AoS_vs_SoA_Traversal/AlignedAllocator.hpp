@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// std::allocator replacement whose blocks start on an Align-byte boundary,
+// so SoA columns can be streamed with aligned vector loads/stores.
+//
+// resize() default-initialises new elements instead of zeroing them: for
+// arithmetic types the memory is left untouched, so the pages are first
+// touched (and, on NUMA systems, placed) by whichever thread writes them.
+template <class T, std::size_t Align = 64>
+struct AlignedAllocator
+{
+    static_assert((Align & (Align - 1)) == 0 && Align >= alignof(T), "Align must be a power of two >= alignof(T)");
+
+    using value_type = T;
+
+    template <class U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Align>;
+    };
+
+    AlignedAllocator() noexcept = default;
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U, Align> &) noexcept {}
+
+    T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+    void deallocate(T *p, std::size_t) noexcept
+    {
+        ::operator delete(p, std::align_val_t(Align));
+    }
+
+    template <class U>
+    void construct(U *p) noexcept(noexcept(::new (static_cast<void *>(p)) U))
+    {
+        ::new (static_cast<void *>(p)) U;
+    }
+    template <class U, class... Args>
+    void construct(U *p, Args &&...args)
+    {
+        ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <class U>
+    bool operator==(const AlignedAllocator<U, Align> &) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const AlignedAllocator<U, Align> &) const noexcept { return false; }
+};
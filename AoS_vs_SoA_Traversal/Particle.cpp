@@ -1,9 +1,20 @@
 #include <vector>
 #include <iostream>
-#include <chrono>
 #include <cstddef>
 #include <algorithm>
 #include <numeric>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "AlignedAllocator.hpp"
+#include "ParticleAoSoA.hpp"
+#include "PassFusion.hpp"
+#include "SimdKernels.hpp"
+#include "ThreadPool.hpp"
+
+#include "bench/PerfCounters.hpp"
 
 static constexpr std::size_t N = 20000000; // tune if RAM is tight
 static constexpr int REPS = 5;             // timing repetitions (median)
@@ -14,26 +25,34 @@ struct ParticleAoS
     float x, y, z;    // Position
     float vx, vy, vz; // Velocity
 };
+// 64-byte aligned columns so the SIMD kernels can use aligned loads.
+template <class T>
+using AlignedVec = std::vector<T, AlignedAllocator<T, 64>>;
+
 struct ParticleSoA
 {
-    std::vector<float> x, y, z;
-    std::vector<float> vx, vy, vz;
+    AlignedVec<float> x, y, z;
+    AlignedVec<float> vx, vy, vz;
 };
 
-inline void init_data(std::vector<ParticleAoS> &aos, ParticleSoA &soa)
+// Allocates the columns; AlignedAllocator leaves the new elements untouched.
+inline void resize_soa(ParticleSoA &soa)
 {
-    aos.resize(N);
     soa.x.resize(N);
     soa.y.resize(N);
     soa.z.resize(N);
     soa.vx.resize(N);
     soa.vy.resize(N);
     soa.vz.resize(N);
+}
+
+inline void init_soa(ParticleSoA &soa)
+{
+    resize_soa(soa);
     for (std::size_t i = 0; i < N; ++i)
     {
         float p = static_cast<float>(i);
         float v = p * 0.1f;
-        aos[i] = {p, p, p, v, v, v};
         soa.x[i] = p;
         soa.y[i] = p;
         soa.z[i] = p;
@@ -43,22 +62,47 @@ inline void init_data(std::vector<ParticleAoS> &aos, ParticleSoA &soa)
     }
 }
 
-template <typename F>
-inline long long median_time_ms(F &&f)
+inline void init_data(std::vector<ParticleAoS> &aos, ParticleSoA &soa)
 {
-    std::vector<long long> times;
-    times.reserve(REPS);
-    // one warm-up (not timed)
-    f();
-    for (int r = 0; r < REPS; ++r)
+    aos.resize(N);
+    for (std::size_t i = 0; i < N; ++i)
     {
-        auto t0 = std::chrono::steady_clock::now();
-        f();
-        auto t1 = std::chrono::steady_clock::now();
-        times.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count());
+        float p = static_cast<float>(i);
+        float v = p * 0.1f;
+        aos[i] = {p, p, p, v, v, v};
     }
-    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
-    return times[times.size() / 2];
+    init_soa(soa);
+}
+
+// Median of REPS timed runs after exactly one warm-up, recorded under name for
+// BENCH_FORMAT=json|csv. The passes update the particles in place, so every
+// layout must run the same number of times for the checksums to agree.
+// With BENCH_PERF_COUNTERS, the hardware events per particle are printed
+// (ahead of the case's result line) and recorded too, unless with_perf is
+// false.
+template <typename F>
+inline double median_time_ms(const std::string &name, F &&f, bool with_perf = true)
+{
+    bench::Options opt = bench::Options::from_env(REPS, 1);
+    opt.until_stable = false;
+    bench::PerfSample pmc;
+    const bench::Stats s = with_perf ? bench::measure(f, opt, pmc) : bench::measure(f, opt);
+    const std::string perf = pmc.format("particle", static_cast<double>(N));
+    if (with_perf && !perf.empty())
+        std::cout << "  " << name << perf << "\n";
+    bench::record(name, s, pmc.metrics(static_cast<double>(N)));
+    return s.median_ms();
+}
+
+// "12.3 ms (4.5 GB/s)". bytes is the memory traffic of one pass: every cache
+// line the loop touches is read once, and written back if it was modified.
+// AoS passes pay for whole structs even when they use one field.
+inline std::string ms_gbps(double ms, double bytes)
+{
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(1) << ms << " ms ("
+       << std::setprecision(2) << (ms > 0.0 ? bytes / (ms * 1e6) : 0.0) << " GB/s)";
+    return os.str();
 }
 
 inline double checksum_xyz(const std::vector<ParticleAoS> &aos)
@@ -94,20 +138,187 @@ inline double checksum_x(const ParticleSoA &soa)
     return s;
 }
 
+// Initial state of particle i, as in init_data: position i, velocity 0.1 * i.
+template <class T>
+inline void set_initial(ParticleRef<T> p, std::size_t i)
+{
+    T pos = static_cast<T>(i);
+    T v = pos * static_cast<T>(0.1);
+    p.x = p.y = p.z = pos;
+    p.vx = p.vy = p.vz = v;
+}
+
+template <class L>
+inline void init_particles(L &layout)
+{
+    std::size_t i = 0;
+    for_each_particle(layout, [&](auto p)
+                      { set_initial(p, i++); });
+}
+
+// Partition boundaries for the parallel runs: a multiple of every AoSoA width,
+// and a few pages per field so neighbouring workers rarely share a page.
+static constexpr std::size_t kGrain = 1024;
+
+// First-touch initialisation: each worker writes, and so places, the range it
+// will later update (the memory must not have been touched before).
+template <class L>
+inline void init_particles(L &layout, ThreadPool &pool)
+{
+    pool.run([&](unsigned tid)
+             {
+        auto r = pool.partition(tid, particle_count(layout), kGrain);
+        std::size_t i = r.first;
+        for_each_particle(layout, r.first, r.second, [&](auto p)
+                          { set_initial(p, i++); }); });
+}
+
+inline void init_data(AlignedVec<ParticleAoS> &aos, ParticleSoA &soa, ThreadPool &pool)
+{
+    aos.resize(N); // allocated, not yet touched
+    resize_soa(soa);
+    init_particles(aos, pool);
+    init_particles(soa, pool);
+}
+
+// Layout-generic checksums (same summation order as the SoA versions above).
+template <class Acc = double, class L>
+inline double checksum_x_of(L &layout)
+{
+    Acc s = 0;
+    for_each_particle(layout, [&](auto p)
+                      { s += p.x; });
+    return static_cast<double>(s);
+}
+template <class Acc = double, class L>
+inline double checksum_xyz_of(L &layout)
+{
+    Acc sx = 0, sy = 0, sz = 0;
+    for_each_particle(layout, [&](auto p)
+                      { sx += p.x; sy += p.y; sz += p.z; });
+    return static_cast<double>(sx + sy + sz);
+}
+
+struct LayoutRun
+{
+    double ms;
+    double bytes;
+    double checksum;
+};
+
+// One AoSoA<T, W> run: build and initialise the container, time pass(container),
+// checksum the result. Scoped so at most one extra copy of the data is alive.
+template <class T, std::size_t W, class Pass, class Check>
+inline LayoutRun run_aosoa(const std::string &name, Pass &&pass, Check &&check, unsigned read_mask, unsigned write_mask)
+{
+    ParticleAoSoA<T, W> a(N);
+    init_particles(a);
+    double ms = median_time_ms(name + "/AoSoA<" + std::to_string(W) + ">", [&]()
+                               { pass(a); });
+    return LayoutRun{ms, a.traffic_bytes(read_mask, write_mask), check(a)};
+}
+
+// Times kernel over layout with the range split across pool's workers. No
+// perf counts: the workers predate the counters, which would see only main.
+template <class L, class K>
+inline double parallel_time_ms(const std::string &name, ThreadPool &pool, L &layout, K &&kernel)
+{
+    return median_time_ms(name, [&]()
+                          { pool.run([&](unsigned tid)
+                                     {
+        auto r = pool.partition(tid, particle_count(layout), kGrain);
+        for_each_particle(layout, r.first, r.second, kernel); }); }, false);
+}
+
+// Unfused vs L2-tiled vs fused runs of the same passes over one layout.
+// footprint: bytes per particle the passes touch (sizes the tile);
+// unfused_bpp / fused_bpp: modelled DRAM bytes per particle for each schedule.
+template <class L, class... P>
+inline void print_fusion(const char *name, L &layout, std::size_t footprint,
+                         double unfused_bpp, double fused_bpp, P &...passes)
+{
+    const double n = static_cast<double>(N);
+    const std::size_t tile = l2_tile(footprint);
+
+    init_particles(layout);
+    double unfused_ms = median_time_ms(std::string("case7/") + name + "/unfused", [&]()
+                                       { run_unfused(layout, passes...); });
+    double cs_unfused = checksum_xyz_of(layout);
+
+    init_particles(layout);
+    double tiled_ms = median_time_ms(std::string("case7/") + name + "/tiled", [&]()
+                                     { run_tiled(layout, tile, passes...); });
+    double cs_tiled = checksum_xyz_of(layout);
+
+    init_particles(layout);
+    double fused_ms = median_time_ms(std::string("case7/") + name + "/fused", [&]()
+                                     { run_fused(layout, passes...); });
+    double cs_fused = checksum_xyz_of(layout);
+
+    std::cout << "  " << name << ": "
+              << "unfused=" << ms_gbps(unfused_ms, n * unfused_bpp) << ", "
+              << "tiled[" << tile << "]=" << ms_gbps(tiled_ms, n * fused_bpp) << ", "
+              << "fused=" << ms_gbps(fused_ms, n * fused_bpp) << ", "
+              << "DRAM B/particle " << unfused_bpp << " -> " << fused_bpp << ", "
+              << "checksum(unfused)=" << cs_unfused << ", "
+              << "checksum(tiled)=" << cs_tiled << ", "
+              << "checksum(fused)=" << cs_fused << "\n";
+}
+
+// Out-of-place x_out = x + vx * dt with normal vs non-temporal stores.
+template <class T, class S>
+inline void print_write_once(const char *name, S &soa, T step)
+{
+    const double n = static_cast<double>(N);
+    AlignedVec<T> out(N);
+    double plain_ms = median_time_ms(std::string("case7/") + name + "/store", [&]()
+                                     { integrate_to(out.data(), soa.x.data(), soa.vx.data(), step, N); });
+    double cs_plain = std::accumulate(out.begin(), out.end(), 0.0);
+    double nt_ms = median_time_ms(std::string("case7/") + name + "/stream", [&]()
+                                  { integrate_to_nt(out.data(), soa.x.data(), soa.vx.data(), step, N); });
+    double cs_nt = std::accumulate(out.begin(), out.end(), 0.0);
+
+    // Plain: read x, v, read-for-ownership of out, write out. Streaming: no RFO.
+    std::cout << "  " << name << " write-once: "
+              << "store=" << ms_gbps(plain_ms, n * 4 * sizeof(T)) << ", "
+              << "stream=" << ms_gbps(nt_ms, n * 3 * sizeof(T)) << ", "
+              << "DRAM B/particle " << 4 * sizeof(T) << " -> " << 3 * sizeof(T) << ", "
+              << "checksum(store)=" << cs_plain << ", "
+              << "checksum(stream)=" << cs_nt << "\n";
+}
+
+inline std::string aosoa_cols(const LayoutRun &r8, const LayoutRun &r16)
+{
+    return "AoSoA<8>=" + ms_gbps(r8.ms, r8.bytes) + ", AoSoA<16>=" + ms_gbps(r16.ms, r16.bytes) + ", ";
+}
+
+inline std::string aosoa_sums(const char *what, const LayoutRun &r8, const LayoutRun &r16)
+{
+    std::ostringstream os;
+    os << ", " << what << "(AoSoA<8>)=" << r8.checksum << ", " << what << "(AoSoA<16>)=" << r16.checksum;
+    return os.str();
+}
+
 int main()
 {
+    // AOS_SOA_SIMD=scalar|sse2|avx2|avx512|neon forces a kernel set.
+    const SimdKernels &simd = select_simd_kernels(std::getenv("AOS_SOA_SIMD"));
+    const std::string simd_label = std::string("SIMD[") + simd.name + "]=";
+    const double n = static_cast<double>(N);
+    std::cout << "SIMD kernels: " << simd.name << "\n";
+
     // ===== Case 1: Single-axis update (x only) =====
     {
         std::vector<ParticleAoS> aos;
         ParticleSoA soa;
         init_data(aos, soa);
 
-        auto aos_ms = median_time_ms([&]()
+        auto aos_ms = median_time_ms("case1/AoS", [&]()
                                      {
             for (std::size_t i = 0; i < N; ++i) {
                 aos[i].x += aos[i].vx * dt;
             } });
-        auto soa_ms = median_time_ms([&]()
+        auto soa_ms = median_time_ms("case1/SoA", [&]()
                                      {
             for (std::size_t i = 0; i < N; ++i) {
                 soa.x[i] += soa.vx[i] * dt;
@@ -116,11 +327,28 @@ int main()
         double cs_aos = checksum_x(aos);
         double cs_soa = checksum_x(soa);
 
+        init_soa(soa); // same starting state for the SIMD run
+        auto simd_ms = median_time_ms("case1/SIMD", [&]()
+                                      { simd.integrate(soa.x.data(), soa.vx.data(), dt, N); });
+        double cs_simd = checksum_x(soa);
+
+        auto pass = [](auto &l)
+        { for_each_particle(l, [](auto p)
+                            { p.x += p.vx * dt; }); };
+        auto check = [](auto &l)
+        { return checksum_x_of(l); };
+        auto r8 = run_aosoa<float, 8>("case1", pass, check, kFieldX | kFieldVX, kFieldX);
+        auto r16 = run_aosoa<float, 16>("case1", pass, check, kFieldX | kFieldVX, kFieldX);
+
         std::cout << "[Case 1] Single-axis update (x only): "
-                  << "AoS=" << aos_ms << " ms, "
-                  << "SoA=" << soa_ms << " ms, "
+                  << "AoS=" << ms_gbps(aos_ms, n * 2 * sizeof(ParticleAoS)) << ", "
+                  << "SoA=" << ms_gbps(soa_ms, n * 3 * sizeof(float)) << ", "
+                  << simd_label << ms_gbps(simd_ms, n * 3 * sizeof(float)) << ", "
+                  << aosoa_cols(r8, r16)
                   << "checksum(AoS)=" << cs_aos << ", "
-                  << "checksum(SoA)=" << cs_soa << "\n";
+                  << "checksum(SoA)=" << cs_soa << ", "
+                  << "checksum(SIMD)=" << cs_simd
+                  << aosoa_sums("checksum", r8, r16) << "\n";
     }
 
     // ===== Case 2: Field-wise loops (x pass, then y pass, then z pass) =====
@@ -129,12 +357,12 @@ int main()
         ParticleSoA soa;
         init_data(aos, soa);
 
-        auto aos_ms = median_time_ms([&]()
+        auto aos_ms = median_time_ms("case2/AoS", [&]()
                                      {
             for (std::size_t i = 0; i < N; ++i) aos[i].x += aos[i].vx * dt;
             for (std::size_t i = 0; i < N; ++i) aos[i].y += aos[i].vy * dt;
             for (std::size_t i = 0; i < N; ++i) aos[i].z += aos[i].vz * dt; });
-        auto soa_ms = median_time_ms([&]()
+        auto soa_ms = median_time_ms("case2/SoA", [&]()
                                      {
             for (std::size_t i = 0; i < N; ++i) soa.x[i] += soa.vx[i] * dt;
             for (std::size_t i = 0; i < N; ++i) soa.y[i] += soa.vy[i] * dt;
@@ -143,11 +371,39 @@ int main()
         double cs_aos = checksum_xyz(aos);
         double cs_soa = checksum_xyz(soa);
 
+        init_soa(soa);
+        auto simd_ms = median_time_ms("case2/SIMD", [&]()
+                                      {
+            simd.integrate(soa.x.data(), soa.vx.data(), dt, N);
+            simd.integrate(soa.y.data(), soa.vy.data(), dt, N);
+            simd.integrate(soa.z.data(), soa.vz.data(), dt, N); });
+        double cs_simd = checksum_xyz(soa);
+
+        auto pass = [](auto &l)
+        {
+            for_each_particle(l, [](auto p)
+                              { p.x += p.vx * dt; });
+            for_each_particle(l, [](auto p)
+                              { p.y += p.vy * dt; });
+            for_each_particle(l, [](auto p)
+                              { p.z += p.vz * dt; });
+        };
+        auto check = [](auto &l)
+        { return checksum_xyz_of(l); };
+        auto r8 = run_aosoa<float, 8>("case2", pass, check, kFieldX | kFieldVX, kFieldX);
+        auto r16 = run_aosoa<float, 16>("case2", pass, check, kFieldX | kFieldVX, kFieldX);
+        r8.bytes *= 3; // three sweeps, each moving what the x sweep moves
+        r16.bytes *= 3;
+
         std::cout << "[Case 2] Field-wise loops (x pass, y pass, z pass): "
-                  << "AoS=" << aos_ms << " ms, "
-                  << "SoA=" << soa_ms << " ms, "
+                  << "AoS=" << ms_gbps(aos_ms, n * 3 * 2 * sizeof(ParticleAoS)) << ", "
+                  << "SoA=" << ms_gbps(soa_ms, n * 3 * 3 * sizeof(float)) << ", "
+                  << simd_label << ms_gbps(simd_ms, n * 3 * 3 * sizeof(float)) << ", "
+                  << aosoa_cols(r8, r16)
                   << "checksum(AoS)=" << cs_aos << ", "
-                  << "checksum(SoA)=" << cs_soa << "\n";
+                  << "checksum(SoA)=" << cs_soa << ", "
+                  << "checksum(SIMD)=" << cs_simd
+                  << aosoa_sums("checksum", r8, r16) << "\n";
     }
 
     // ===== Case 3: Read-only sweep of x (no writes) =====
@@ -156,27 +412,46 @@ int main()
         ParticleSoA soa;
         init_data(aos, soa);
 
-        volatile double sink = 0.0; // ensure the sum is used
-        auto aos_ms = median_time_ms([&]()
+        auto aos_ms = median_time_ms("case3/AoS", [&]()
                                      {
             double s = 0.0;
             for (std::size_t i = 0; i < N; ++i) s += aos[i].x;
-            sink = s; });
-        auto soa_ms = median_time_ms([&]()
+            bench::do_not_optimize(s); });
+        auto soa_ms = median_time_ms("case3/SoA", [&]()
                                      {
             double s = 0.0;
             for (std::size_t i = 0; i < N; ++i) s += soa.x[i];
-            sink = s; });
+            bench::do_not_optimize(s); });
+
+        double sum_simd = 0.0;
+        auto simd_ms = median_time_ms("case3/SIMD", [&]()
+                                      { sum_simd = simd.checksum(soa.x.data(), N); });
 
         // compute and print final sums outside timed region
         double sum_aos = checksum_x(aos);
         double sum_soa = checksum_x(soa);
 
+        auto pass = [&](auto &l)
+        {
+            double s = 0.0;
+            for_each_particle(l, [&](auto p)
+                              { s += p.x; });
+            bench::do_not_optimize(s);
+        };
+        auto check = [](auto &l)
+        { return checksum_x_of(l); };
+        auto r8 = run_aosoa<float, 8>("case3", pass, check, kFieldX, 0);
+        auto r16 = run_aosoa<float, 16>("case3", pass, check, kFieldX, 0);
+
         std::cout << "[Case 3] Read-only sweep of x: "
-                  << "AoS=" << aos_ms << " ms, "
-                  << "SoA=" << soa_ms << " ms, "
+                  << "AoS=" << ms_gbps(aos_ms, n * sizeof(ParticleAoS)) << ", "
+                  << "SoA=" << ms_gbps(soa_ms, n * sizeof(float)) << ", "
+                  << simd_label << ms_gbps(simd_ms, n * sizeof(float)) << ", "
+                  << aosoa_cols(r8, r16)
                   << "sum(AoS)=" << sum_aos << ", "
-                  << "sum(SoA)=" << sum_soa << "\n";
+                  << "sum(SoA)=" << sum_soa << ", "
+                  << "sum(SIMD)=" << sum_simd
+                  << aosoa_sums("sum", r8, r16) << "\n";
     }
 
     // ===== Case 4: Double precision (update all axes in one loop) =====
@@ -187,7 +462,7 @@ int main()
         };
         struct ParticleSoAD
         {
-            std::vector<double> x, y, z, vx, vy, vz;
+            AlignedVec<double> x, y, z, vx, vy, vz;
         };
 
         std::vector<ParticleD> aos;
@@ -200,28 +475,37 @@ int main()
         soa.vy.resize(N);
         soa.vz.resize(N);
 
+        auto init_soa_d = [&]()
+        {
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                double p = static_cast<double>(i);
+                double v = p * 0.1;
+                soa.x[i] = p;
+                soa.y[i] = p;
+                soa.z[i] = p;
+                soa.vx[i] = v;
+                soa.vy[i] = v;
+                soa.vz[i] = v;
+            }
+        };
         for (std::size_t i = 0; i < N; ++i)
         {
             double p = static_cast<double>(i);
             double v = p * 0.1;
             aos[i] = {p, p, p, v, v, v};
-            soa.x[i] = p;
-            soa.y[i] = p;
-            soa.z[i] = p;
-            soa.vx[i] = v;
-            soa.vy[i] = v;
-            soa.vz[i] = v;
         }
+        init_soa_d();
         const double dtd = 0.005;
 
-        auto aos_ms = median_time_ms([&]()
+        auto aos_ms = median_time_ms("case4/AoS", [&]()
                                      {
             for (std::size_t i = 0; i < N; ++i) {
                 aos[i].x += aos[i].vx * dtd;
                 aos[i].y += aos[i].vy * dtd;
                 aos[i].z += aos[i].vz * dtd;
             } });
-        auto soa_ms = median_time_ms([&]()
+        auto soa_ms = median_time_ms("case4/SoA", [&]()
                                      {
             for (std::size_t i = 0; i < N; ++i) {
                 soa.x[i] += soa.vx[i] * dtd;
@@ -252,11 +536,180 @@ int main()
         double cs_aos = checksum_xyz_aos_d();
         double cs_soa = checksum_xyz_soa_d();
 
+        init_soa_d();
+        auto simd_ms = median_time_ms("case4/SIMD", [&]()
+                                      { simd.integrate3_d(soa.x.data(), soa.y.data(), soa.z.data(),
+                                                          soa.vx.data(), soa.vy.data(), soa.vz.data(), dtd, N); });
+        double cs_simd = checksum_xyz_soa_d();
+
+        // Free the AoS copy first: four 960 MB double layouts don't fit everywhere.
+        std::vector<ParticleD>().swap(aos);
+        auto pass = [dtd](auto &l)
+        { for_each_particle(l, [dtd](auto p)
+                            {
+            p.x += p.vx * dtd;
+            p.y += p.vy * dtd;
+            p.z += p.vz * dtd; }); };
+        auto check = [](auto &l)
+        { return checksum_xyz_of<long double>(l); };
+        auto r8 = run_aosoa<double, 8>("case4", pass, check, kFieldsAll, kFieldsPos);
+        auto r16 = run_aosoa<double, 16>("case4", pass, check, kFieldsAll, kFieldsPos);
+
         std::cout << "[Case 4] Double precision (update x,y,z): "
-                  << "AoS=" << aos_ms << " ms, "
-                  << "SoA=" << soa_ms << " ms, "
+                  << "AoS=" << ms_gbps(aos_ms, n * 2 * sizeof(ParticleD)) << ", "
+                  << "SoA=" << ms_gbps(soa_ms, n * 9 * sizeof(double)) << ", "
+                  << simd_label << ms_gbps(simd_ms, n * 9 * sizeof(double)) << ", "
+                  << aosoa_cols(r8, r16)
                   << "checksum(AoS)=" << cs_aos << ", "
-                  << "checksum(SoA)=" << cs_soa << "\n";
+                  << "checksum(SoA)=" << cs_soa << ", "
+                  << "checksum(SIMD)=" << cs_simd
+                  << aosoa_sums("checksum", r8, r16) << "\n";
+    }
+
+    // ===== Case 5: Float, update all axes in one loop (one kernel, every layout) =====
+    {
+        auto step = [](auto p)
+        {
+            p.x += p.vx * dt;
+            p.y += p.vy * dt;
+            p.z += p.vz * dt;
+        };
+        auto pass = [&](auto &l)
+        { for_each_particle(l, step); };
+        auto check = [](auto &l)
+        { return checksum_xyz_of(l); };
+
+        double aos_ms, soa_ms, cs_aos, cs_soa;
+        {
+            std::vector<ParticleAoS> aos;
+            ParticleSoA soa;
+            init_data(aos, soa);
+            aos_ms = median_time_ms("case5/AoS", [&]()
+                                    { pass(aos); });
+            soa_ms = median_time_ms("case5/SoA", [&]()
+                                    { pass(soa); });
+            cs_aos = checksum_xyz(aos);
+            cs_soa = checksum_xyz(soa);
+        }
+        auto r8 = run_aosoa<float, 8>("case5", pass, check, kFieldsAll, kFieldsPos);
+        auto r16 = run_aosoa<float, 16>("case5", pass, check, kFieldsAll, kFieldsPos);
+
+        std::cout << "[Case 5] Float, all axes in one loop: "
+                  << "AoS=" << ms_gbps(aos_ms, n * 2 * sizeof(ParticleAoS)) << ", "
+                  << "SoA=" << ms_gbps(soa_ms, n * 9 * sizeof(float)) << ", "
+                  << aosoa_cols(r8, r16)
+                  << "checksum(AoS)=" << cs_aos << ", "
+                  << "checksum(SoA)=" << cs_soa
+                  << aosoa_sums("checksum", r8, r16) << "\n";
+    }
+
+    // ===== Case 6: Parallel all-axes update, scaling over pinned threads =====
+    {
+        auto step = [](auto p)
+        {
+            p.x += p.vx * dt;
+            p.y += p.vy * dt;
+            p.z += p.vz * dt;
+        };
+        const std::vector<int> cpus = bench::allowed_cpus();
+        const unsigned max_threads = cpus.empty() ? std::max(1u, std::thread::hardware_concurrency())
+                                                  : static_cast<unsigned>(cpus.size());
+        std::vector<unsigned> counts;
+        for (unsigned t = 1; t < max_threads; t *= 2)
+            counts.push_back(t);
+        counts.push_back(max_threads);
+
+        std::cout << "[Case 6] Parallel all-axes update (float), pinned threads, first-touch init, "
+                  << ThreadPool::numa_nodes() << " NUMA node(s):\n";
+        double base_aos = 0, base_soa = 0, base_aosoa = 0;
+        for (unsigned t : counts)
+        {
+            ThreadPool pool(t);
+            const std::string tag = "case6/threads=" + std::to_string(t);
+            double aos_ms, soa_ms, aosoa_ms, cs_soa;
+            {
+                AlignedVec<ParticleAoS> aos;
+                ParticleSoA soa;
+                init_data(aos, soa, pool);
+                aos_ms = parallel_time_ms(tag + "/AoS", pool, aos, step);
+                soa_ms = parallel_time_ms(tag + "/SoA", pool, soa, step);
+                cs_soa = checksum_xyz(soa);
+            }
+            ParticleAoSoA<float, 16> aosoa(N);
+            init_particles(aosoa, pool);
+            aosoa_ms = parallel_time_ms(tag + "/AoSoA<16>", pool, aosoa, step);
+            const double aosoa_bytes = aosoa.traffic_bytes(kFieldsAll, kFieldsPos);
+
+            if (t == 1)
+            {
+                base_aos = aos_ms;
+                base_soa = soa_ms;
+                base_aosoa = aosoa_ms;
+            }
+            auto speedup = [](double base, double ms)
+            {
+                std::ostringstream os;
+                os << " x" << std::fixed << std::setprecision(2) << (ms > 0.0 ? base / ms : 0.0);
+                return os.str();
+            };
+            std::cout << "  threads=" << std::setw(3) << t << ": "
+                      << "AoS=" << ms_gbps(aos_ms, n * 2 * sizeof(ParticleAoS)) << speedup(base_aos, aos_ms) << ", "
+                      << "SoA=" << ms_gbps(soa_ms, n * 9 * sizeof(float)) << speedup(base_soa, soa_ms) << ", "
+                      << "AoSoA<16>=" << ms_gbps(aosoa_ms, aosoa_bytes) << speedup(base_aosoa, aosoa_ms) << ", "
+                      << "checksum(SoA)=" << cs_soa << ", "
+                      << "checksum(AoSoA<16>)=" << checksum_xyz_of(aosoa) << "\n";
+        }
+    }
+
+    // ===== Case 7: Multi-pass field-wise update: unfused vs L2-tiled vs fused =====
+    // Six per-field passes: drift (x += vx*dt, y, z), then drag (vx *= k, vy, vz).
+    // Unfused, every pass streams its fields from DRAM; tiled/fused, each
+    // cache line is loaded and written back once.
+    {
+        auto drift_x = [](auto p)
+        { p.x += p.vx * dt; };
+        auto drift_y = [](auto p)
+        { p.y += p.vy * dt; };
+        auto drift_z = [](auto p)
+        { p.z += p.vz * dt; };
+        auto drag_x = [](auto p)
+        { p.vx *= 0.999f; };
+        auto drag_y = [](auto p)
+        { p.vy *= 0.999f; };
+        auto drag_z = [](auto p)
+        { p.vz *= 0.999f; };
+
+        std::cout << "[Case 7] Six-pass drift+drag, L2=" << l2_cache_bytes() / 1024 << " KiB:\n";
+        {
+            std::vector<ParticleAoS> aos(N);
+            // AoS: every pass reads and writes back whole structs.
+            const double s = sizeof(ParticleAoS);
+            print_fusion("AoS (float)", aos, sizeof(ParticleAoS), 6 * 2 * s, 2 * s,
+                         drift_x, drift_y, drift_z, drag_x, drag_y, drag_z);
+        }
+        {
+            ParticleSoA soa;
+            resize_soa(soa);
+            // SoA: drift reads 2 fields, writes 1; drag reads and writes 1.
+            const double f = sizeof(float);
+            print_fusion("SoA (float)", soa, 6 * sizeof(float), 3 * 3 * f + 3 * 2 * f, 12 * f,
+                         drift_x, drift_y, drift_z, drag_x, drag_y, drag_z);
+            init_soa(soa);
+            print_write_once("SoA (float)", soa, dt);
+        }
+        {
+            struct ParticleSoAD
+            {
+                AlignedVec<double> x, y, z, vx, vy, vz;
+            } soa;
+            for (auto *c : {&soa.x, &soa.y, &soa.z, &soa.vx, &soa.vy, &soa.vz})
+                c->resize(N);
+            const double f = sizeof(double);
+            print_fusion("SoA (double)", soa, 6 * sizeof(double), 3 * 3 * f + 3 * 2 * f, 12 * f,
+                         drift_x, drift_y, drift_z, drag_x, drag_y, drag_z);
+            init_particles(soa);
+            print_write_once("SoA (double)", soa, 0.005);
+        }
     }
 
     return 0;
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "AlignedAllocator.hpp"
+
+// Array-of-Struct-of-Arrays: particles grouped in blocks of W, each block
+// holding W x's, then W y's, ... So a loop over one block touches every field
+// of W particles in a few cache lines (like AoS), while each field is still a
+// short contiguous run the compiler can vectorise (like SoA).
+//
+// ParticleRef is the common accessor: for_each_particle(layout, kernel) calls
+// kernel(ParticleRef<T>) for every particle in index order, whatever the
+// layout, so one kernel source runs over AoS, SoA and AoSoA alike:
+//   for_each_particle(particles, [](auto p) { p.x += p.vx * dt; });
+
+// Field bits for ParticleAoSoA::traffic_bytes().
+enum ParticleField : unsigned
+{
+    kFieldX = 1,
+    kFieldY = 2,
+    kFieldZ = 4,
+    kFieldVX = 8,
+    kFieldVY = 16,
+    kFieldVZ = 32,
+    kFieldsPos = kFieldX | kFieldY | kFieldZ,
+    kFieldsAll = 63,
+};
+
+template <class T>
+struct ParticleRef
+{
+    T &x, &y, &z;
+    T &vx, &vy, &vz;
+};
+
+template <class T, std::size_t W>
+class ParticleAoSoA
+{
+public:
+    static_assert(W > 0, "block width must be greater than 0");
+    static constexpr std::size_t kWidth = W;
+
+    struct alignas(64) Block
+    {
+        T x[W], y[W], z[W];
+        T vx[W], vy[W], vz[W];
+    };
+
+    explicit ParticleAoSoA(std::size_t n = 0) { resize(n); }
+
+    void resize(std::size_t n)
+    {
+        _n = n;
+        _blocks.resize((n + W - 1) / W);
+    }
+
+    std::size_t size() const noexcept { return _n; }
+    std::size_t block_count() const noexcept { return _blocks.size(); }
+    Block *blocks() noexcept { return _blocks.data(); }
+
+    ParticleRef<T> operator[](std::size_t i) noexcept
+    {
+        Block &b = _blocks[i / W];
+        const std::size_t l = i % W;
+        return ParticleRef<T>{b.x[l], b.y[l], b.z[l], b.vx[l], b.vy[l], b.vz[l]};
+    }
+
+    // Block-major, lane-minor; the inner loop has a constant trip count W.
+    template <class K>
+    void for_each(K &&kernel)
+    {
+        for_each(0, _n, std::forward<K>(kernel));
+    }
+
+    // Particles [begin, end); begin must be a multiple of W (end may be size()).
+    template <class K>
+    void for_each(std::size_t begin, std::size_t end, K &&kernel)
+    {
+        assert(begin % W == 0 && end <= _n);
+        const std::size_t full = end / W;
+        for (std::size_t bi = begin / W; bi < full; ++bi)
+        {
+            Block &b = _blocks[bi];
+            for (std::size_t l = 0; l < W; ++l)
+                kernel(ParticleRef<T>{b.x[l], b.y[l], b.z[l], b.vx[l], b.vy[l], b.vz[l]});
+        }
+        if (end % W != 0)
+        {
+            Block &b = _blocks[full];
+            for (std::size_t l = 0; l < end % W; ++l)
+                kernel(ParticleRef<T>{b.x[l], b.y[l], b.z[l], b.vx[l], b.vy[l], b.vz[l]});
+        }
+    }
+
+    // Memory traffic of one pass over all blocks: each 64-byte line holding a
+    // field in (read_mask | write_mask) is read, lines holding a field in
+    // write_mask are written back (masks are ParticleField bits).
+    static constexpr std::size_t traffic_per_block(unsigned read_mask, unsigned write_mask) noexcept
+    {
+        constexpr std::size_t kField = W * sizeof(T);
+        constexpr std::size_t kLines = sizeof(Block) / 64;
+        std::size_t bytes = 0;
+        for (std::size_t line = 0; line < kLines; ++line)
+        {
+            bool touched = false, dirty = false;
+            for (unsigned f = 0; f < 6; ++f)
+            {
+                const std::size_t lo = f * kField, hi = lo + kField; // field f's bytes
+                if (lo < (line + 1) * 64 && hi > line * 64)
+                {
+                    touched = touched || ((read_mask | write_mask) >> f & 1u);
+                    dirty = dirty || (write_mask >> f & 1u);
+                }
+            }
+            bytes += (touched ? 64 : 0) + (dirty ? 64 : 0);
+        }
+        return bytes;
+    }
+
+    double traffic_bytes(unsigned read_mask, unsigned write_mask) const noexcept
+    {
+        return static_cast<double>(traffic_per_block(read_mask, write_mask)) * static_cast<double>(block_count());
+    }
+
+private:
+    static_assert(sizeof(Block) % 64 == 0, "blocks must be whole cache lines");
+
+    std::vector<Block, AlignedAllocator<Block, 64>> _blocks;
+    std::size_t _n = 0;
+};
+
+// Each layout also takes a [begin, end) sub-range (for AoSoA, begin on a block
+// boundary) so a range can be split across threads.
+
+// AoS: a vector of structs with x, y, z, vx, vy, vz members.
+template <class P, class A, class K>
+void for_each_particle(std::vector<P, A> &aos, std::size_t begin, std::size_t end, K &&kernel)
+{
+    using T = typename std::decay<decltype(std::declval<P &>().x)>::type;
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        P &p = aos[i];
+        kernel(ParticleRef<T>{p.x, p.y, p.z, p.vx, p.vy, p.vz});
+    }
+}
+
+template <class T, std::size_t W, class K>
+void for_each_particle(ParticleAoSoA<T, W> &aosoa, std::size_t begin, std::size_t end, K &&kernel)
+{
+    aosoa.for_each(begin, end, std::forward<K>(kernel));
+}
+
+// SoA: a struct of containers named x, y, z, vx, vy, vz.
+template <class S, class K>
+void for_each_particle(S &soa, std::size_t begin, std::size_t end, K &&kernel)
+{
+    using T = typename std::decay<decltype(soa.x[0])>::type;
+    for (std::size_t i = begin; i < end; ++i)
+        kernel(ParticleRef<T>{soa.x[i], soa.y[i], soa.z[i], soa.vx[i], soa.vy[i], soa.vz[i]});
+}
+
+template <class P, class A>
+std::size_t particle_count(const std::vector<P, A> &aos) noexcept { return aos.size(); }
+template <class T, std::size_t W>
+std::size_t particle_count(const ParticleAoSoA<T, W> &aosoa) noexcept { return aosoa.size(); }
+template <class S>
+std::size_t particle_count(const S &soa) noexcept { return soa.x.size(); }
+
+template <class L, class K>
+void for_each_particle(L &layout, K &&kernel)
+{
+    for_each_particle(layout, 0, particle_count(layout), std::forward<K>(kernel));
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ParticleAoSoA.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PASS_FUSION_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+// Running several per-field passes over the same particles. Each pass is a
+// kernel for for_each_particle (takes a ParticleRef). Three schedules:
+//   run_unfused  one full sweep per pass: every pass streams the data again;
+//   run_tiled    all passes over one L2-sized tile, then the next tile: later
+//                passes find the tile still in cache;
+//   run_fused    one sweep calling every pass on each particle in turn.
+// All three apply the passes to each particle in the same order, so results
+// are bit-identical.
+
+template <class L, class... Passes>
+void run_unfused(L &layout, Passes &...passes)
+{
+    (for_each_particle(layout, passes), ...);
+}
+
+template <class L, class... Passes>
+void run_tiled(L &layout, std::size_t tile, Passes &...passes)
+{
+    const std::size_t n = particle_count(layout);
+    for (std::size_t b = 0; b < n; b += tile)
+    {
+        const std::size_t e = (n - b < tile) ? n : b + tile;
+        (for_each_particle(layout, b, e, passes), ...);
+    }
+}
+
+template <class L, class... Passes>
+void run_fused(L &layout, Passes &...passes)
+{
+    for_each_particle(layout, [&](auto p)
+                      { (passes(p), ...); });
+}
+
+// L2 size as reported by the OS (1 MiB when unknown).
+inline std::size_t l2_cache_bytes()
+{
+#if defined(__linux__) && defined(_SC_LEVEL2_CACHE_SIZE)
+    long v = ::sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (v > 0)
+        return static_cast<std::size_t>(v);
+#endif
+    return std::size_t(1) << 20;
+}
+
+// Particles per tile so a tile's working set fills about half of L2; a
+// multiple of 16 so tiles start on AoSoA block boundaries.
+inline std::size_t l2_tile(std::size_t bytes_per_particle)
+{
+    std::size_t t = l2_cache_bytes() / 2 / bytes_per_particle;
+    t -= t % 16;
+    return t < 16 ? 16 : t;
+}
+
+// --------------------------- write-once output ---------------------------
+// out[i] = x[i] + v[i] * dt, where out is not read again soon. A normal store
+// first reads each output line into cache (read-for-ownership); the
+// non-temporal version writes full lines straight to memory, saving that read
+// and leaving the cache to x and v. Without SSE2 it falls back to plain stores.
+
+template <class T>
+void integrate_to(T *out, const T *x, const T *v, T dt, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = x[i] + v[i] * dt;
+}
+
+#if defined(PASS_FUSION_SSE2)
+inline void stream_axpy(float *out, const float *x, const float *v, __m128 d) noexcept
+{
+    _mm_stream_ps(out, _mm_add_ps(_mm_loadu_ps(x), _mm_mul_ps(_mm_loadu_ps(v), d)));
+}
+inline void stream_axpy(double *out, const double *x, const double *v, __m128d d) noexcept
+{
+    _mm_stream_pd(out, _mm_add_pd(_mm_loadu_pd(x), _mm_mul_pd(_mm_loadu_pd(v), d)));
+}
+inline __m128 splat(float dt) noexcept { return _mm_set1_ps(dt); }
+inline __m128d splat(double dt) noexcept { return _mm_set1_pd(dt); }
+#endif
+
+template <class T>
+void integrate_to_nt(T *out, const T *x, const T *v, T dt, std::size_t n)
+{
+#if defined(PASS_FUSION_SSE2)
+    constexpr std::size_t kLanes = 16 / sizeof(T);
+    std::size_t i = 0;
+    for (; i < n && (reinterpret_cast<std::uintptr_t>(out + i) & 15u) != 0; ++i)
+        out[i] = x[i] + v[i] * dt; // scalar until out is 16-byte aligned
+    const auto d = splat(dt);
+    for (; i + kLanes <= n; i += kLanes)
+        stream_axpy(out + i, x + i, v + i, d);
+    for (; i < n; ++i)
+        out[i] = x[i] + v[i] * dt;
+    _mm_sfence(); // make the streamed lines visible before anyone reads out
+#else
+    integrate_to(out, x, v, dt, n);
+#endif
+}
@@ -0,0 +1,367 @@
+#include "SimdKernels.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Per-function ISA selection: the TU is built with the project's baseline
+// flags and each kernel asks for what it needs, so one binary carries every
+// variant. MSVC exposes all intrinsics without flags.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SIMD_TARGET(isa)
+#else
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// Keep the scalar baseline scalar even when -march=native is on.
+#if defined(__clang__)
+#define SCALAR_FN
+#define SCALAR_LOOP _Pragma("clang loop vectorize(disable) interleave(disable)")
+#elif defined(__GNUC__)
+#define SCALAR_FN __attribute__((optimize("no-tree-vectorize")))
+#define SCALAR_LOOP
+#elif defined(_MSC_VER)
+#define SCALAR_FN
+#define SCALAR_LOOP __pragma(loop(no_vector))
+#else
+#define SCALAR_FN
+#define SCALAR_LOOP
+#endif
+
+static inline bool aligned64(const void *p) noexcept
+{
+    return (reinterpret_cast<std::uintptr_t>(p) & 63u) == 0;
+}
+
+// --------------------------- scalar ---------------------------
+SCALAR_FN static void integrate_scalar(float *x, const float *v, float dt, std::size_t n)
+{
+    SCALAR_LOOP
+    for (std::size_t i = 0; i < n; ++i)
+        x[i] += v[i] * dt;
+}
+
+SCALAR_FN static void integrate3_d_scalar(double *x, double *y, double *z,
+                                          const double *vx, const double *vy, const double *vz,
+                                          double dt, std::size_t n)
+{
+    SCALAR_LOOP
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        z[i] += vz[i] * dt;
+    }
+}
+
+SCALAR_FN static double checksum_scalar(const float *x, std::size_t n)
+{
+    double s = 0.0;
+    SCALAR_LOOP
+    for (std::size_t i = 0; i < n; ++i)
+        s += x[i];
+    return s;
+}
+
+#if defined(SIMD_X86)
+// --------------------------- SSE2 ---------------------------
+SIMD_TARGET("sse2") static void integrate_sse2(float *x, const float *v, float dt, std::size_t n)
+{
+    assert(aligned64(x) && aligned64(v));
+    const __m128 d = _mm_set1_ps(dt);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm_store_ps(x + i, _mm_add_ps(_mm_load_ps(x + i), _mm_mul_ps(_mm_load_ps(v + i), d)));
+    for (; i < n; ++i)
+        x[i] += v[i] * dt;
+}
+
+SIMD_TARGET("sse2") static void integrate3_d_sse2(double *x, double *y, double *z,
+                                                  const double *vx, const double *vy, const double *vz,
+                                                  double dt, std::size_t n)
+{
+    assert(aligned64(x) && aligned64(y) && aligned64(z));
+    assert(aligned64(vx) && aligned64(vy) && aligned64(vz));
+    const __m128d d = _mm_set1_pd(dt);
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        _mm_store_pd(x + i, _mm_add_pd(_mm_load_pd(x + i), _mm_mul_pd(_mm_load_pd(vx + i), d)));
+        _mm_store_pd(y + i, _mm_add_pd(_mm_load_pd(y + i), _mm_mul_pd(_mm_load_pd(vy + i), d)));
+        _mm_store_pd(z + i, _mm_add_pd(_mm_load_pd(z + i), _mm_mul_pd(_mm_load_pd(vz + i), d)));
+    }
+    for (; i < n; ++i)
+    {
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        z[i] += vz[i] * dt;
+    }
+}
+
+SIMD_TARGET("sse2") static double checksum_sse2(const float *x, std::size_t n)
+{
+    assert(aligned64(x));
+    __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 f = _mm_load_ps(x + i);
+        a0 = _mm_add_pd(a0, _mm_cvtps_pd(f));
+        a1 = _mm_add_pd(a1, _mm_cvtps_pd(_mm_movehl_ps(f, f)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(a0, a1));
+    double s = lanes[0] + lanes[1];
+    for (; i < n; ++i)
+        s += x[i];
+    return s;
+}
+
+// --------------------------- AVX2 ---------------------------
+SIMD_TARGET("avx2") static void integrate_avx2(float *x, const float *v, float dt, std::size_t n)
+{
+    assert(aligned64(x) && aligned64(v));
+    const __m256 d = _mm256_set1_ps(dt);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_store_ps(x + i, _mm256_add_ps(_mm256_load_ps(x + i), _mm256_mul_ps(_mm256_load_ps(v + i), d)));
+    for (; i < n; ++i)
+        x[i] += v[i] * dt;
+}
+
+SIMD_TARGET("avx2") static void integrate3_d_avx2(double *x, double *y, double *z,
+                                                  const double *vx, const double *vy, const double *vz,
+                                                  double dt, std::size_t n)
+{
+    assert(aligned64(x) && aligned64(y) && aligned64(z));
+    assert(aligned64(vx) && aligned64(vy) && aligned64(vz));
+    const __m256d d = _mm256_set1_pd(dt);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm256_store_pd(x + i, _mm256_add_pd(_mm256_load_pd(x + i), _mm256_mul_pd(_mm256_load_pd(vx + i), d)));
+        _mm256_store_pd(y + i, _mm256_add_pd(_mm256_load_pd(y + i), _mm256_mul_pd(_mm256_load_pd(vy + i), d)));
+        _mm256_store_pd(z + i, _mm256_add_pd(_mm256_load_pd(z + i), _mm256_mul_pd(_mm256_load_pd(vz + i), d)));
+    }
+    for (; i < n; ++i)
+    {
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        z[i] += vz[i] * dt;
+    }
+}
+
+SIMD_TARGET("avx2") static double checksum_avx2(const float *x, std::size_t n)
+{
+    assert(aligned64(x));
+    __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 f = _mm256_load_ps(x + i);
+        a0 = _mm256_add_pd(a0, _mm256_cvtps_pd(_mm256_castps256_ps128(f)));
+        a1 = _mm256_add_pd(a1, _mm256_cvtps_pd(_mm256_extractf128_ps(f, 1)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(a0, a1));
+    double s = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < n; ++i)
+        s += x[i];
+    return s;
+}
+
+// --------------------------- AVX-512 ---------------------------
+SIMD_TARGET("avx512f") static void integrate_avx512(float *x, const float *v, float dt, std::size_t n)
+{
+    assert(aligned64(x) && aligned64(v));
+    const __m512 d = _mm512_set1_ps(dt);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+        _mm512_store_ps(x + i, _mm512_add_ps(_mm512_load_ps(x + i), _mm512_mul_ps(_mm512_load_ps(v + i), d)));
+    for (; i < n; ++i)
+        x[i] += v[i] * dt;
+}
+
+SIMD_TARGET("avx512f") static void integrate3_d_avx512(double *x, double *y, double *z,
+                                                       const double *vx, const double *vy, const double *vz,
+                                                       double dt, std::size_t n)
+{
+    assert(aligned64(x) && aligned64(y) && aligned64(z));
+    assert(aligned64(vx) && aligned64(vy) && aligned64(vz));
+    const __m512d d = _mm512_set1_pd(dt);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm512_store_pd(x + i, _mm512_add_pd(_mm512_load_pd(x + i), _mm512_mul_pd(_mm512_load_pd(vx + i), d)));
+        _mm512_store_pd(y + i, _mm512_add_pd(_mm512_load_pd(y + i), _mm512_mul_pd(_mm512_load_pd(vy + i), d)));
+        _mm512_store_pd(z + i, _mm512_add_pd(_mm512_load_pd(z + i), _mm512_mul_pd(_mm512_load_pd(vz + i), d)));
+    }
+    for (; i < n; ++i)
+    {
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        z[i] += vz[i] * dt;
+    }
+}
+
+SIMD_TARGET("avx512f") static double checksum_avx512(const float *x, std::size_t n)
+{
+    assert(aligned64(x));
+    __m512d a0 = _mm512_setzero_pd(), a1 = _mm512_setzero_pd();
+    std::size_t i = 0;
+    // maskz_ forms with an all-ones mask: same instruction as the unmasked
+    // intrinsics, minus GCC 12's bogus -Wuninitialized on their _undefined_ operand.
+    const __mmask8 all = 0xFF;
+    for (; i + 16 <= n; i += 16)
+    {
+        a0 = _mm512_add_pd(a0, _mm512_maskz_cvtps_pd(all, _mm256_load_ps(x + i)));
+        a1 = _mm512_add_pd(a1, _mm512_maskz_cvtps_pd(all, _mm256_load_ps(x + i + 8)));
+    }
+    double lanes[8];
+    _mm512_storeu_pd(lanes, _mm512_add_pd(a0, a1));
+    double s = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    for (; i < n; ++i)
+        s += x[i];
+    return s;
+}
+
+static bool cpu_has(const char *isa)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int r[4];
+    __cpuid(r, 0);
+    const int max_leaf = r[0];
+    __cpuid(r, 1);
+    const bool osxsave = (r[2] & (1 << 27)) != 0;
+    const bool avx = (r[2] & (1 << 28)) != 0;
+    const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    int ebx7 = 0;
+    if (max_leaf >= 7)
+    {
+        __cpuidex(r, 7, 0);
+        ebx7 = r[1];
+    }
+    if (std::strcmp(isa, "sse2") == 0)
+        return true; // x64 baseline
+    if (std::strcmp(isa, "avx2") == 0)
+        return avx && (xcr0 & 0x6) == 0x6 && (ebx7 & (1 << 5)) != 0;
+    if (std::strcmp(isa, "avx512f") == 0)
+        return (xcr0 & 0xE6) == 0xE6 && (ebx7 & (1 << 16)) != 0;
+    return false;
+#else
+    __builtin_cpu_init();
+    if (std::strcmp(isa, "sse2") == 0)
+        return __builtin_cpu_supports("sse2");
+    if (std::strcmp(isa, "avx2") == 0)
+        return __builtin_cpu_supports("avx2");
+    if (std::strcmp(isa, "avx512f") == 0)
+        return __builtin_cpu_supports("avx512f");
+    return false;
+#endif
+}
+#endif // SIMD_X86
+
+#if defined(SIMD_NEON)
+// --------------------------- NEON ---------------------------
+static void integrate_neon(float *x, const float *v, float dt, std::size_t n)
+{
+    assert(aligned64(x) && aligned64(v));
+    const float32x4_t d = vdupq_n_f32(dt);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(x + i, vaddq_f32(vld1q_f32(x + i), vmulq_f32(vld1q_f32(v + i), d)));
+    for (; i < n; ++i)
+        x[i] += v[i] * dt;
+}
+
+static void integrate3_d_neon(double *x, double *y, double *z,
+                              const double *vx, const double *vy, const double *vz,
+                              double dt, std::size_t n)
+{
+    assert(aligned64(x) && aligned64(y) && aligned64(z));
+    assert(aligned64(vx) && aligned64(vy) && aligned64(vz));
+    const float64x2_t d = vdupq_n_f64(dt);
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        vst1q_f64(x + i, vaddq_f64(vld1q_f64(x + i), vmulq_f64(vld1q_f64(vx + i), d)));
+        vst1q_f64(y + i, vaddq_f64(vld1q_f64(y + i), vmulq_f64(vld1q_f64(vy + i), d)));
+        vst1q_f64(z + i, vaddq_f64(vld1q_f64(z + i), vmulq_f64(vld1q_f64(vz + i), d)));
+    }
+    for (; i < n; ++i)
+    {
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        z[i] += vz[i] * dt;
+    }
+}
+
+static double checksum_neon(const float *x, std::size_t n)
+{
+    assert(aligned64(x));
+    float64x2_t a0 = vdupq_n_f64(0.0), a1 = vdupq_n_f64(0.0);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        float32x4_t f = vld1q_f32(x + i);
+        a0 = vaddq_f64(a0, vcvt_f64_f32(vget_low_f32(f)));
+        a1 = vaddq_f64(a1, vcvt_high_f64_f32(f));
+    }
+    double s = vaddvq_f64(vaddq_f64(a0, a1));
+    for (; i < n; ++i)
+        s += x[i];
+    return s;
+}
+#endif // SIMD_NEON
+
+// Best first; the scalar set is always last and always supported.
+static const SimdKernels kTable[] = {
+#if defined(SIMD_X86)
+    {"avx512", integrate_avx512, integrate3_d_avx512, checksum_avx512},
+    {"avx2", integrate_avx2, integrate3_d_avx2, checksum_avx2},
+    {"sse2", integrate_sse2, integrate3_d_sse2, checksum_sse2},
+#endif
+#if defined(SIMD_NEON)
+    {"neon", integrate_neon, integrate3_d_neon, checksum_neon},
+#endif
+    {"scalar", integrate_scalar, integrate3_d_scalar, checksum_scalar},
+};
+
+static bool supported(const SimdKernels &k)
+{
+#if defined(SIMD_X86)
+    if (std::strcmp(k.name, "avx512") == 0)
+        return cpu_has("avx512f");
+    if (std::strcmp(k.name, "avx2") == 0)
+        return cpu_has("avx2");
+    if (std::strcmp(k.name, "sse2") == 0)
+        return cpu_has("sse2");
+#endif
+    (void)k;
+    return true; // NEON is mandatory on AArch64; scalar runs anywhere
+}
+
+const SimdKernels &select_simd_kernels(const char *force)
+{
+    if (force != nullptr)
+    {
+        for (const SimdKernels &k : kTable)
+            if (std::strcmp(k.name, force) == 0 && supported(k))
+                return k;
+    }
+    for (const SimdKernels &k : kTable)
+        if (supported(k))
+            return k;
+    return kTable[sizeof(kTable) / sizeof(kTable[0]) - 1];
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+// Hand-written SIMD versions of the SoA passes, one set per instruction set,
+// picked at runtime from what the CPU reports. All pointers must be 64-byte
+// aligned (ParticleSoA's AlignedAllocator guarantees it); the main loops use
+// aligned loads/stores and finish the last few elements in scalar code.
+//
+// The "scalar" set is compiled with auto-vectorisation disabled, so it is a
+// true one-element-at-a-time baseline even under -march=native.
+struct SimdKernels
+{
+    const char *name;
+    // x[i] += v[i] * dt
+    void (*integrate)(float *x, const float *v, float dt, std::size_t n);
+    // x[i] += vx[i] * dt, likewise y and z, in one loop
+    void (*integrate3_d)(double *x, double *y, double *z,
+                         const double *vx, const double *vy, const double *vz,
+                         double dt, std::size_t n);
+    // sum of x[i], accumulated in double
+    double (*checksum)(const float *x, std::size_t n);
+};
+
+// Best set this CPU supports. If 'force' names a set (scalar, sse2, avx2,
+// avx512, neon) that is compiled in and supported, that one is returned
+// instead; unknown or unsupported names fall back to the best set.
+const SimdKernels &select_simd_kernels(const char *force = nullptr);
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <dirent.h>
+#endif
+
+#include "bench/Harness.hpp"
+
+// Fixed set of worker threads, each pinned to its own CPU, that all run the
+// same job: run(f) calls f(tid) on every worker and returns when all are done.
+// Work is split with partition(), which hands worker tid the same contiguous
+// range every time. Initialising data through the pool therefore first-touches
+// each range from the thread (and, with Linux's default local allocation
+// policy, the NUMA node) that will later process it.
+//
+// CPUs are taken in order from the process's affinity mask, so thread counts
+// below the core count fill one socket before the next.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned threads)
+    {
+        const std::vector<int> cpus = bench::allowed_cpus();
+        _workers.reserve(threads);
+        for (unsigned t = 0; t < threads; ++t)
+        {
+            const int cpu = cpus.empty() ? -1 : cpus[t % cpus.size()];
+            _workers.emplace_back([this, t, cpu]
+                                  { worker(t, cpu); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lk(_mu);
+            _stop = true;
+        }
+        _start.notify_all();
+        for (auto &w : _workers)
+            w.join();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    unsigned size() const noexcept { return static_cast<unsigned>(_workers.size()); }
+
+    // f(tid) on every worker; blocks until all of them return.
+    template <class F>
+    void run(F &&f)
+    {
+        std::unique_lock<std::mutex> lk(_mu);
+        _job = [&f](unsigned tid)
+        { f(tid); };
+        _pending = size();
+        ++_generation;
+        _start.notify_all();
+        _done.wait(lk, [this]
+                   { return _pending == 0; });
+        _job = nullptr;
+    }
+
+    // Worker tid's share of [0, n): contiguous, boundaries on multiples of grain.
+    std::pair<std::size_t, std::size_t> partition(unsigned tid, std::size_t n, std::size_t grain) const noexcept
+    {
+        const std::size_t units = (n + grain - 1) / grain;
+        const std::size_t t = size();
+        const std::size_t lo = units * tid / t * grain;
+        const std::size_t hi = units * (tid + 1) / t * grain;
+        return {lo < n ? lo : n, hi < n ? hi : n};
+    }
+
+    // NUMA nodes the kernel reports (1 when unknown).
+    static unsigned numa_nodes()
+    {
+        unsigned n = 0;
+#if defined(__linux__)
+        if (DIR *d = opendir("/sys/devices/system/node"))
+        {
+            while (dirent *e = readdir(d))
+            {
+                const std::string name = e->d_name;
+                if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+                    name.find_first_not_of("0123456789", 4) == std::string::npos)
+                    ++n;
+            }
+            closedir(d);
+        }
+#endif
+        return n == 0 ? 1 : n;
+    }
+
+private:
+    void worker(unsigned tid, int cpu)
+    {
+        bench::pin_this_thread(cpu);
+        std::uint64_t seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lk(_mu);
+                _start.wait(lk, [&]
+                            { return _stop || _generation != seen; });
+                if (_stop)
+                    return;
+                seen = _generation;
+            }
+            _job(tid); // stays valid until every worker has reported back
+            {
+                std::lock_guard<std::mutex> lk(_mu);
+                if (--_pending == 0)
+                    _done.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> _workers;
+    std::mutex _mu;
+    std::condition_variable _start, _done;
+    std::function<void(unsigned)> _job;
+    std::uint64_t _generation = 0;
+    unsigned _pending = 0;
+    bool _stop = false;
+};
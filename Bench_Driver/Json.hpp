@@ -0,0 +1,263 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Just enough JSON for the result files written by bench::Results (and the
+// merged files the driver writes in the same shape): parse a whole document,
+// look members up by name, and write scalars back out. Objects keep their
+// members in file order so a rewritten row reads like the original.
+
+struct JsonValue
+{
+    enum Kind
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    Kind kind = Null;
+    bool boolean = false;
+    double number = 0;
+    std::string text;
+    std::vector<JsonValue> items;                              // Array
+    std::vector<std::pair<std::string, JsonValue>> members;    // Object
+
+    const JsonValue *find(const std::string &key) const
+    {
+        for (const auto &m : members)
+            if (m.first == key)
+                return &m.second;
+        return nullptr;
+    }
+
+    // The member's number, or `fallback` when it is missing or not a number.
+    double number_or(const std::string &key, double fallback) const
+    {
+        const JsonValue *v = find(key);
+        return (v != nullptr && v->kind == Number) ? v->number : fallback;
+    }
+
+    std::string string_or(const std::string &key, const std::string &fallback) const
+    {
+        const JsonValue *v = find(key);
+        return (v != nullptr && v->kind == String) ? v->text : fallback;
+    }
+};
+
+class JsonParser
+{
+public:
+    // Throws std::runtime_error naming the byte offset of the first problem.
+    static JsonValue parse(const std::string &s)
+    {
+        JsonParser p(s);
+        JsonValue v = p.value();
+        p.skip_ws();
+        if (p.i_ != s.size())
+            p.fail("trailing characters");
+        return v;
+    }
+
+private:
+    explicit JsonParser(const std::string &s) : s_(s) {}
+
+    [[noreturn]] void fail(const char *what) const
+    {
+        throw std::runtime_error(std::string("json: ") + what + " at offset " + std::to_string(i_));
+    }
+
+    void skip_ws()
+    {
+        while (i_ < s_.size() && (s_[i_] == ' ' || s_[i_] == '\t' || s_[i_] == '\n' || s_[i_] == '\r'))
+            ++i_;
+    }
+
+    bool eat(char c)
+    {
+        skip_ws();
+        if (i_ < s_.size() && s_[i_] == c)
+        {
+            ++i_;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c)
+    {
+        if (!eat(c))
+            fail(c == ':' ? "expected ':'" : c == ',' ? "expected ','" : "unexpected character");
+    }
+
+    bool literal(const char *word)
+    {
+        const std::size_t n = std::char_traits<char>::length(word);
+        if (s_.compare(i_, n, word) != 0)
+            return false;
+        i_ += n;
+        return true;
+    }
+
+    JsonValue value()
+    {
+        skip_ws();
+        if (i_ >= s_.size())
+            fail("unexpected end");
+        JsonValue v;
+        const char c = s_[i_];
+        if (c == '{')
+        {
+            ++i_;
+            v.kind = JsonValue::Object;
+            if (eat('}'))
+                return v;
+            do
+            {
+                skip_ws();
+                if (i_ >= s_.size() || s_[i_] != '"')
+                    fail("expected a member name");
+                std::string key = string();
+                expect(':');
+                v.members.emplace_back(std::move(key), value());
+            } while (eat(','));
+            expect('}');
+        }
+        else if (c == '[')
+        {
+            ++i_;
+            v.kind = JsonValue::Array;
+            if (eat(']'))
+                return v;
+            do
+                v.items.push_back(value());
+            while (eat(','));
+            expect(']');
+        }
+        else if (c == '"')
+        {
+            v.kind = JsonValue::String;
+            v.text = string();
+        }
+        else if (literal("true") || literal("false"))
+        {
+            v.kind = JsonValue::Bool;
+            v.boolean = (c == 't');
+        }
+        else if (literal("null"))
+        {
+        }
+        else
+        {
+            const char *begin = s_.c_str() + i_;
+            char *end = nullptr;
+            v.kind = JsonValue::Number;
+            v.number = std::strtod(begin, &end);
+            if (end == begin)
+                fail("unexpected character");
+            i_ += static_cast<std::size_t>(end - begin);
+        }
+        return v;
+    }
+
+    // At the opening quote. \uXXXX escapes outside ASCII become '?': result
+    // names and metric keys are ASCII.
+    std::string string()
+    {
+        std::string out;
+        ++i_;
+        while (i_ < s_.size() && s_[i_] != '"')
+        {
+            char c = s_[i_++];
+            if (c == '\\')
+            {
+                if (i_ >= s_.size())
+                    break;
+                c = s_[i_++];
+                switch (c)
+                {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'u':
+                {
+                    if (i_ + 4 > s_.size())
+                        fail("bad \\u escape");
+                    const unsigned long u = std::strtoul(s_.substr(i_, 4).c_str(), nullptr, 16);
+                    i_ += 4;
+                    c = u < 0x80 ? static_cast<char>(u) : '?';
+                    break;
+                }
+                default: break; // '"', '\\', '/'
+                }
+            }
+            out += c;
+        }
+        if (i_ >= s_.size())
+            fail("unterminated string");
+        ++i_;
+        return out;
+    }
+
+    const std::string &s_;
+    std::size_t i_ = 0;
+};
+
+inline std::string json_quote(const std::string &s)
+{
+    std::string out = "\"";
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if (c == '\n')
+            out += "\\n";
+        else
+            out += c;
+    }
+    return out + '"';
+}
+
+// Numbers to 10 significant digits; arrays and objects on one line, the way
+// the harness writes a result row.
+inline std::string json_text(const JsonValue &v)
+{
+    switch (v.kind)
+    {
+    case JsonValue::Null: return "null";
+    case JsonValue::Bool: return v.boolean ? "true" : "false";
+    case JsonValue::String: return json_quote(v.text);
+    case JsonValue::Number:
+    {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.10g", v.number);
+        return buf;
+    }
+    case JsonValue::Array:
+    {
+        std::string out = "[";
+        for (std::size_t i = 0; i < v.items.size(); ++i)
+            out += (i ? ", " : "") + json_text(v.items[i]);
+        return out + "]";
+    }
+    case JsonValue::Object:
+    {
+        std::string out = "{";
+        for (std::size_t i = 0; i < v.members.size(); ++i)
+            out += (i ? ", " : "") + json_quote(v.members[i].first) + ": " + json_text(v.members[i].second);
+        return out + "}";
+    }
+    }
+    return "null";
+}
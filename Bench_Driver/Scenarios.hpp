@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Every benchmark the driver knows: which demo executable to run, in which
+// folder, with which arguments. Sizes are picked so the whole set finishes in
+// a few minutes on a laptop; run a demo directly for its full default sweep.
+// The scenario name is the executable, plus the mode for multi-mode demos,
+// i.e. the prefix of the result names it records.
+
+struct Scenario
+{
+    const char *name;
+    const char *folder; // relative to the build (or repo) root
+    const char *exe;
+    std::vector<std::string> args;
+    const char *what;
+};
+
+inline const std::vector<Scenario> &scenarios()
+{
+    static const std::vector<Scenario> all = {
+        {"aos_soa", "AoS_vs_SoA_Traversal", "aos_soa", {}, "AoS vs SoA vs AoSoA traversal, SIMD, threads, fusion"},
+        {"false_sharing", "False_Sharing_Demo", "false_sharing", {"4", "2000000"}, "shared vs padded vs sharded counters"},
+        {"false_sharing/contention", "False_Sharing_Demo", "false_sharing", {"contention", "16", "2000000"},
+         "one hot counter: atomics, CAS, mutex, spin lock, batching"},
+        {"false_sharing/layout", "False_Sharing_Demo", "false_sharing", {"layout"}, "struct layouts, shared vs private copies"},
+        {"spsc", "Lock_Free_Ring_Buffer", "spsc", {"65536", "2000000"}, "SPSC ring, per-item vs batched"},
+        {"spsc/payload", "Lock_Free_Ring_Buffer", "spsc", {"payload", "200000"}, "SPSC/MPMC dequeue paths, 256-byte message"},
+        {"spsc/wait", "Lock_Free_Ring_Buffer", "spsc", {"wait", "500"}, "spin / yield / park wake-up latency"},
+        {"spsc/spacing", "Lock_Free_Ring_Buffer", "spsc", {"spacing", "2000000"}, "SPSC index padding 8..256 bytes"},
+        {"mpmc", "Lock_Free_Ring_Buffer", "mpmc", {"200000", "4096", "4"}, "MPSC/MPMC vs SPSC lanes, throughput and latency"},
+        {"pool_bench", "Pool_Allocator_w_Placement_New", "pool_bench", {"2000", "256"},
+         "ConcurrentObjectPool vs new/delete vs pmr::synchronized"},
+        {"pool_pmr", "Pool_Allocator_w_Placement_New", "pool_pmr", {"100000", "3"}, "map/unordered_map on PoolResource"},
+        {"pool_layout", "Pool_Allocator_w_Placement_New", "pool_layout", {}, "ObjectPool freelist layouts, single vs bulk"},
+        {"pool_iter", "Pool_Allocator_w_Placement_New", "pool_iter", {}, "SlotMap / DenseSlotMap vs vector<T*> iteration"},
+        {"arena_probe", "Pool_Allocator_w_Placement_New", "arena_probe", {}, "Arena vs malloc per request"},
+        {"serialize_nodes/bench", "LP64_vs_LLP64", "serialize_nodes", {"bench", "1000000"}, "v1 stream vs v2 mmap load"},
+        {"serialize_nodes/io", "LP64_vs_LLP64", "serialize_nodes", {"io", "1000000"}, "per-field vs bulk v1 I/O"},
+        {"serialize_nodes/graph", "LP64_vs_LLP64", "serialize_nodes", {"graph", "1000000"}, "v3 graph pointer index"},
+        {"serialize_nodes/stream", "LP64_vs_LLP64", "serialize_nodes", {"stream", "1000000"}, "streaming v1 readers"},
+        {"serialize_nodes/compact", "LP64_vs_LLP64", "serialize_nodes", {"compact", "1000000"}, "v4 varint size and decode"},
+        {"serialize_nodes/parallel", "LP64_vs_LLP64", "serialize_nodes", {"parallel", "1000000"},
+         "v5 chunked encode/verify/decode"},
+        {"vector_moves", "Vector_Reallocation_&_noexcept_Move", "vector_moves", {}, "vector growth, move vs copy, latency"},
+    };
+    return all;
+}
@@ -0,0 +1,470 @@
+#include "Json.hpp"
+#include "Scenarios.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bench/Harness.hpp"
+
+#if !defined(_WIN32)
+#include <sys/wait.h>
+#endif
+
+// One entry point for every demo's benchmarks. Each scenario (Scenarios.hpp)
+// runs its demo executable as a child process with BENCH_FORMAT=json, so the
+// demos keep their own main() and output; the driver collects the results
+// into one file and can compare it with an earlier one.
+//
+// Usage: bench [--list] [--filter a,b] [--exclude a,b] [--reps n] [--out file|-]
+//              [--baseline file] [--threshold pct] [--stat median|min|mean|p99]
+//              [--bin-dir dir] [--verbose]
+//        bench --compare baseline.json current.json [--threshold pct] [--stat ...]
+//
+// --filter/--exclude match substrings of the scenario name. With --baseline
+// (or --compare) every result found in both files is compared on --stat
+// (default median) and one more than --threshold percent (default 10) slower
+// is a regression. Exit status: 0 ok, 1 regression, 2 usage error or a
+// scenario that failed.
+
+namespace fs = std::filesystem;
+
+#ifndef BENCH_DRIVER_BUILD_DIR
+#define BENCH_DRIVER_BUILD_DIR ""
+#endif
+#ifndef BENCH_DRIVER_REPO_DIR
+#define BENCH_DRIVER_REPO_DIR ""
+#endif
+
+struct Options
+{
+    bool list = false, verbose = false;
+    std::vector<std::string> filter, exclude;
+    std::string reps, out, baseline, bin_dir, compare_base, compare_cur;
+    double threshold = 10.0;
+    std::string stat = "median";
+};
+
+struct Result
+{
+    std::string scenario;
+    std::string name;
+    JsonValue row; // every member as the harness wrote it
+};
+
+struct ResultFile
+{
+    JsonValue context;
+    std::vector<Result> results;
+};
+
+static std::vector<std::string> split_list(const std::string &s)
+{
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    for (std::string item; std::getline(ss, item, ',');)
+        if (!item.empty())
+            out.push_back(item);
+    return out;
+}
+
+static bool contains_any(const std::string &name, const std::vector<std::string> &parts)
+{
+    for (const std::string &p : parts)
+        if (name.find(p) != std::string::npos)
+            return true;
+    return false;
+}
+
+static bool selected(const Scenario &sc, const Options &o)
+{
+    return (o.filter.empty() || contains_any(sc.name, o.filter)) && !contains_any(sc.name, o.exclude);
+}
+
+// "812 ns", "12.3 us", "4.56 ms", "1.23 s".
+static std::string time_text(double ns)
+{
+    char buf[32];
+    if (ns < 1e3)
+        std::snprintf(buf, sizeof(buf), "%.0f ns", ns);
+    else if (ns < 1e6)
+        std::snprintf(buf, sizeof(buf), "%.3g us", ns / 1e3);
+    else if (ns < 1e9)
+        std::snprintf(buf, sizeof(buf), "%.3g ms", ns / 1e6);
+    else
+        std::snprintf(buf, sizeof(buf), "%.3g s", ns / 1e9);
+    return buf;
+}
+
+// ------------------------------- result files -------------------------------
+
+static std::string read_text(const std::string &path)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f)
+        throw std::runtime_error("cannot open " + path);
+    std::ostringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+// A harness file or a merged one; rows without a "scenario" get `scenario`.
+static ResultFile load_results(const std::string &path, const std::string &scenario = std::string())
+{
+    const JsonValue doc = JsonParser::parse(read_text(path));
+    const JsonValue *results = doc.find("results");
+    if (doc.kind != JsonValue::Object || results == nullptr || results->kind != JsonValue::Array)
+        throw std::runtime_error(path + ": not a bench result file (no \"results\" array)");
+    ResultFile f;
+    if (const JsonValue *c = doc.find("context"))
+        f.context = *c;
+    for (const JsonValue &row : results->items)
+    {
+        if (row.kind != JsonValue::Object || row.find("name") == nullptr)
+            throw std::runtime_error(path + ": result without a name");
+        f.results.push_back(Result{row.string_or("scenario", scenario), row.string_or("name", ""), row});
+    }
+    return f;
+}
+
+// Same layout as the harness output (one result per line), with the
+// scenario after each name.
+static void write_results(std::ostream &os, const ResultFile &f)
+{
+    os << "{\n  \"context\": " << json_text(f.context) << ",\n  \"results\": [\n";
+    for (std::size_t i = 0; i < f.results.size(); ++i)
+    {
+        const Result &r = f.results[i];
+        os << "    {\"name\": " << json_quote(r.name) << ", \"scenario\": " << json_quote(r.scenario);
+        for (const auto &m : r.row.members)
+            if (m.first != "name" && m.first != "scenario")
+                os << ", " << json_quote(m.first) << ": " << json_text(m.second);
+        os << "}" << (i + 1 < f.results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+// --------------------------------- running ---------------------------------
+
+static void set_env(const char *key, const std::string &value)
+{
+#if defined(_WIN32)
+    _putenv_s(key, value.c_str());
+#else
+    setenv(key, value.c_str(), 1);
+#endif
+}
+
+static std::string shell_quote(const std::string &s)
+{
+#if defined(_WIN32)
+    return "\"" + s + "\"";
+#else
+    std::string out = "'";
+    for (char c : s)
+        out += (c == '\'') ? std::string("'\\''") : std::string(1, c);
+    return out + "'";
+#endif
+}
+
+static int exit_code(int status)
+{
+#if defined(_WIN32)
+    return status;
+#else
+    if (status == -1 || !WIFEXITED(status))
+        return -1;
+    return WEXITSTATUS(status);
+#endif
+}
+
+// Where a demo executable may be: <root>/<folder>/ as laid out by the top-level
+// build, a multi-config subdirectory, or scripts/build_one.sh's build-<type>/.
+static std::string find_exe(const Scenario &sc, const std::vector<fs::path> &roots)
+{
+#if defined(_WIN32)
+    const std::string exe = std::string(sc.exe) + ".exe";
+#else
+    const std::string exe = sc.exe;
+#endif
+    static const char *const subdirs[] = {"", "Release", "RelWithDebInfo", "Debug", "build-Release",
+                                          "build-Release/Release", "build-Debug", "build-Debug/Debug"};
+    std::error_code ec;
+    for (const fs::path &root : roots)
+        for (const char *sub : subdirs)
+        {
+            const fs::path p = root / sc.folder / sub / exe;
+            if (fs::is_regular_file(p, ec))
+                return p.string();
+        }
+    return std::string();
+}
+
+// The demo's exit code; its results are in `json` afterwards. It runs in
+// `work` since some demos write scratch files to the current directory.
+static int run_scenario(const Scenario &sc, const std::string &exe, const fs::path &work, const fs::path &json,
+                        bool verbose)
+{
+    set_env("BENCH_FORMAT", "json");
+    set_env("BENCH_OUT", json.string());
+#if defined(_WIN32)
+    std::string cmd = "cd /d " + shell_quote(work.string()) + " && " + shell_quote(exe);
+#else
+    std::string cmd = "cd " + shell_quote(work.string()) + " && " + shell_quote(exe);
+#endif
+    for (const std::string &a : sc.args)
+        cmd += " " + shell_quote(a);
+#if defined(_WIN32)
+    cmd += verbose ? " 1>&2" : " > NUL";
+#else
+    cmd += verbose ? " 1>&2" : " > /dev/null";
+#endif
+    std::fflush(nullptr);
+    return exit_code(std::system(cmd.c_str()));
+}
+
+// -------------------------------- comparing --------------------------------
+
+static const char *const kStats[] = {"median", "min", "mean", "p99"};
+
+// Number of results more than `threshold` percent slower than the baseline;
+// the report goes to `out`.
+static std::size_t compare(const ResultFile &base, const ResultFile &cur, const Options &o, std::FILE *out)
+{
+    const std::string field = o.stat + "_ns";
+    const char *const ctx_keys[] = {"compiler", "build", "cpus"};
+    for (const char *k : ctx_keys)
+    {
+        const JsonValue *a = base.context.find(k), *b = cur.context.find(k);
+        if (a != nullptr && b != nullptr && json_text(*a) != json_text(*b))
+            std::fprintf(out, "note: %s differs: %s (baseline) vs %s\n", k, json_text(*a).c_str(),
+                         json_text(*b).c_str());
+    }
+
+    std::map<std::string, const Result *> by_name;
+    for (const Result &r : base.results)
+        by_name.emplace(r.name, &r);
+
+    std::size_t matched = 0, regressed = 0, improved = 0, fresh = 0;
+    const double limit = o.threshold / 100.0;
+    for (const Result &r : cur.results)
+    {
+        auto it = by_name.find(r.name);
+        if (it == by_name.end())
+        {
+            ++fresh;
+            if (o.verbose)
+                std::fprintf(out, "  %-9s %8s  %s\n", "new", "", r.name.c_str());
+            continue;
+        }
+        const double b = it->second->row.number_or(field, 0), c = r.row.number_or(field, 0);
+        by_name.erase(it); // what is left at the end ran only in the baseline
+        ++matched;
+        // null (written for inf/nan) reads as 0: nothing to compare.
+        if (!(b > 0 && c > 0) || !std::isfinite(b) || !std::isfinite(c))
+            continue;
+        const double delta = c / b - 1.0;
+        const char *tag = nullptr;
+        if (delta > limit)
+        {
+            tag = "REGRESSED";
+            ++regressed;
+        }
+        else if (delta < -limit)
+        {
+            tag = "improved";
+            ++improved;
+        }
+        else if (o.verbose)
+            tag = "same";
+        if (tag != nullptr)
+            std::fprintf(out, "  %-9s %+7.1f%%  %s  %s -> %s\n", tag, 100.0 * delta, r.name.c_str(),
+                         time_text(b).c_str(), time_text(c).c_str());
+    }
+    std::fprintf(out, "compare (%s, threshold %g%%): %zu matched, %zu regressed, %zu improved, %zu new, %zu baseline-only\n",
+                 o.stat.c_str(), o.threshold, matched, regressed, improved, fresh, by_name.size());
+    return regressed;
+}
+
+// ----------------------------------- main -----------------------------------
+
+static void usage()
+{
+    std::cerr << "Usage: bench [--list] [--filter a,b] [--exclude a,b] [--reps n] [--out file|-]\n"
+                 "             [--baseline file] [--threshold pct] [--stat median|min|mean|p99]\n"
+                 "             [--bin-dir dir] [--verbose]\n"
+                 "       bench --compare baseline.json current.json [--threshold pct] [--stat ...]\n";
+}
+
+static bool parse_args(int argc, char **argv, Options &o)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string a = argv[i];
+        auto value = [&](std::string &dst)
+        {
+            if (i + 1 >= argc)
+                return false;
+            dst = argv[++i];
+            return true;
+        };
+        std::string v;
+        if (a == "--list")
+            o.list = true;
+        else if (a == "--verbose")
+            o.verbose = true;
+        else if (a == "--filter" && value(v))
+            o.filter = split_list(v);
+        else if (a == "--exclude" && value(v))
+            o.exclude = split_list(v);
+        else if (a == "--threshold" && value(v))
+        {
+            char *end = nullptr;
+            o.threshold = std::strtod(v.c_str(), &end);
+            if (end == v.c_str() || o.threshold < 0)
+                return false;
+        }
+        else if (a == "--stat" && value(o.stat))
+        {
+            bool known = false;
+            for (const char *s : kStats)
+                known = known || o.stat == s;
+            if (!known)
+                return false;
+        }
+        else if (a == "--compare" && value(o.compare_base) && value(o.compare_cur))
+        {
+        }
+        else if (!(a == "--reps" && value(o.reps)) && !(a == "--out" && value(o.out)) &&
+                 !(a == "--baseline" && value(o.baseline)) && !(a == "--bin-dir" && value(o.bin_dir)))
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    Options o;
+    if (!parse_args(argc, argv, o))
+    {
+        usage();
+        return 2;
+    }
+
+    try
+    {
+        if (!o.compare_base.empty())
+            return compare(load_results(o.compare_base), load_results(o.compare_cur), o, stdout) ? 1 : 0;
+
+        std::vector<const Scenario *> chosen;
+        for (const Scenario &sc : scenarios())
+            if (selected(sc, o))
+                chosen.push_back(&sc);
+        if (o.list)
+        {
+            for (const Scenario *sc : chosen)
+                std::printf("%-26s %s\n", sc->name, sc->what);
+            return 0;
+        }
+        if (chosen.empty())
+        {
+            std::cerr << "bench: no scenario matches the filter (see --list)\n";
+            return 2;
+        }
+
+        std::vector<fs::path> roots;
+        if (!o.bin_dir.empty())
+            roots.push_back(o.bin_dir);
+        else
+        {
+            roots.push_back(fs::absolute(argv[0]).parent_path().parent_path());
+            roots.push_back(BENCH_DRIVER_BUILD_DIR);
+            roots.push_back(BENCH_DRIVER_REPO_DIR);
+        }
+        if (!o.reps.empty())
+            set_env("BENCH_REPS", o.reps);
+        // Read before running, so a bad file fails fast.
+        ResultFile base;
+        if (!o.baseline.empty())
+            base = load_results(o.baseline);
+
+        const fs::path work = fs::temp_directory_path() / ("bench_driver." + std::to_string(bench::now_ns()));
+        fs::create_directories(work);
+        ResultFile all;
+        std::size_t failed = 0;
+        for (std::size_t k = 0; k < chosen.size(); ++k)
+        {
+            const Scenario &sc = *chosen[k];
+            std::fprintf(stderr, "[%zu/%zu] %-26s ", k + 1, chosen.size(), sc.name);
+            const std::string exe = find_exe(sc, roots);
+            if (exe.empty())
+            {
+                std::fprintf(stderr, "skipped: %s not built\n", sc.exe);
+                continue;
+            }
+            const fs::path json = work / ("results_" + std::to_string(k) + ".json");
+            const std::int64_t t0 = bench::now_ns();
+            const int rc = run_scenario(sc, exe, work, json, o.verbose);
+            const double secs = static_cast<double>(bench::now_ns() - t0) * 1e-9;
+            std::error_code ec;
+            if (rc != 0 || !fs::exists(json, ec))
+            {
+                std::fprintf(stderr, "FAILED (exit %d%s)\n", rc, rc == 0 ? ", no results" : "");
+                ++failed;
+                continue;
+            }
+            ResultFile f = load_results(json.string(), sc.name);
+            if (all.context.kind == JsonValue::Null)
+                all.context = f.context;
+            std::fprintf(stderr, "%zu results in %.1f s\n", f.results.size(), secs);
+            for (Result &r : f.results)
+                all.results.push_back(std::move(r));
+        }
+        std::error_code ec;
+        fs::remove_all(work, ec);
+        if (all.results.empty() && failed == 0)
+        {
+            std::cerr << "bench: nothing ran; build the demos or point --bin-dir at their build tree\n";
+            return 2;
+        }
+
+        if (o.out == "-")
+            write_results(std::cout, all);
+        else if (!o.out.empty())
+        {
+            std::ofstream f(o.out);
+            write_results(f, all);
+            if (!f)
+                throw std::runtime_error("cannot write " + o.out);
+            std::cerr << "wrote " << all.results.size() << " results to " << o.out << "\n";
+        }
+        else if (o.baseline.empty())
+            for (const Result &r : all.results)
+                std::printf("%-64s %12s  p99 %12s\n", r.name.c_str(), time_text(r.row.number_or("median_ns", 0)).c_str(),
+                            time_text(r.row.number_or("p99_ns", 0)).c_str());
+
+        const std::size_t regressed = o.baseline.empty() ? 0 : compare(base, all, o, o.out == "-" ? stderr : stdout);
+        if (failed > 0)
+        {
+            std::cerr << "bench: " << failed << " scenario(s) failed\n";
+            return 2;
+        }
+        return regressed > 0 ? 1 : 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "bench: " << e.what() << "\n";
+        return 2;
+    }
+}
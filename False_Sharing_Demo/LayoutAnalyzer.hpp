@@ -0,0 +1,191 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "bench/Harness.hpp"
+
+// False-sharing check for a struct: list its fields with the thread that
+// writes each one, and find fields written by different threads that can land
+// on the same cache line.
+//
+//   static constexpr FieldInfo kStatsFields[] = {
+//       FS_FIELD(Stats, hits, 0), FS_FIELD(Stats, misses, 1),
+//       FS_FIELD(Stats, limit, kReadMostly)};
+//   static_assert(false_sharing_pairs<Stats>(kStatsFields) == 0, "Stats: hot fields share a line");
+//
+// Read-mostly fields conflict with written fields on their line (every write
+// invalidates the readers' copies), not with each other. When alignof(S) is a
+// multiple of the line size, line indices are exact; otherwise any two fields
+// less than a line apart may share one, depending on where the object lands.
+//
+// report_layout() prints the same analysis for 64- and 128-byte lines (the
+// latter is the Apple M-series line, and the pair Intel's adjacent-line
+// prefetcher fetches together). stress_layout() confirms a report at run time:
+// one thread per owner writes its fields' bytes, once in a single shared copy
+// of the layout and once in a private copy per thread.
+
+struct FieldInfo
+{
+    const char *name;
+    std::size_t offset;
+    std::size_t size;
+    unsigned owner; // writing thread, or kReadMostly
+};
+
+inline constexpr unsigned kReadMostly = ~0u;
+
+// FieldInfo for S::member written by thread `owner` (S must be standard-layout).
+#define FS_FIELD(S, member, owner) FieldInfo{#member, offsetof(S, member), sizeof(S::member), (owner)}
+
+constexpr bool may_share_line(const FieldInfo &a, const FieldInfo &b, std::size_t line, std::size_t align)
+{
+    if (align % line == 0)
+    {
+        const std::size_t a_lo = a.offset / line, a_hi = (a.offset + a.size - 1) / line;
+        const std::size_t b_lo = b.offset / line, b_hi = (b.offset + b.size - 1) / line;
+        return a_lo <= b_hi && b_lo <= a_hi;
+    }
+    // Unknown placement: bytes strictly between the two fields.
+    const std::size_t gap = (b.offset >= a.offset + a.size)   ? b.offset - (a.offset + a.size)
+                            : (a.offset >= b.offset + b.size) ? a.offset - (b.offset + b.size)
+                                                              : 0;
+    return gap + 1 < line;
+}
+
+constexpr bool owners_conflict(const FieldInfo &a, const FieldInfo &b)
+{
+    return a.owner != b.owner; // includes written vs read-mostly, excludes two read-mostly
+}
+
+template <std::size_t N>
+constexpr std::size_t count_conflicts(const FieldInfo (&f)[N], std::size_t line, std::size_t align)
+{
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < N; ++i)
+        for (std::size_t j = i + 1; j < N; ++j)
+            if (owners_conflict(f[i], f[j]) && may_share_line(f[i], f[j], line, align))
+                ++n;
+    return n;
+}
+
+// Field pairs of S with different owners that may share a `line`-byte line.
+template <class S, std::size_t N>
+constexpr std::size_t false_sharing_pairs(const FieldInfo (&f)[N], std::size_t line = 64)
+{
+    return count_conflicts(f, line, alignof(S));
+}
+
+namespace detail
+{
+    inline void print_owner(unsigned owner)
+    {
+        if (owner == kReadMostly)
+            std::printf("   read");
+        else
+            std::printf("  t%-4u", owner);
+    }
+}
+
+template <class S, std::size_t N>
+void report_layout(const char *name, const FieldInfo (&f)[N])
+{
+    std::printf("Layout %s (%zu bytes, align %zu):\n", name, sizeof(S), alignof(S));
+    std::printf("  %-16s %6s %5s  owner  line64 line128\n", "field", "offset", "size");
+    for (const FieldInfo &fi : f)
+    {
+        std::printf("  %-16s %6zu %5zu", fi.name, fi.offset, fi.size);
+        detail::print_owner(fi.owner);
+        std::printf("  %6zu %7zu\n", fi.offset / 64, fi.offset / 128);
+    }
+    for (std::size_t line : {std::size_t(64), std::size_t(128)})
+    {
+        std::printf("  %zu-byte lines: %zu conflicting pair(s)", line, count_conflicts(f, line, alignof(S)));
+        const char *sep = ": ";
+        for (std::size_t i = 0; i < N; ++i)
+            for (std::size_t j = i + 1; j < N; ++j)
+                if (owners_conflict(f[i], f[j]) && may_share_line(f[i], f[j], line, alignof(S)))
+                {
+                    std::printf("%s%s/%s", sep, f[i].name, f[j].name);
+                    sep = ", ";
+                }
+        std::printf("\n");
+    }
+}
+
+struct StressResult
+{
+    bench::Stats shared;   // every thread writes one copy of the layout
+    bench::Stats separate; // each thread writes its own copy
+    unsigned threads;
+
+    double slowdown() const noexcept { return separate.median_ns > 0 ? shared.median_ns / separate.median_ns : 0.0; }
+};
+
+// One pinned thread per distinct owner (all read-mostly fields share one
+// reader thread) runs `iters` rounds over its fields: byte stores for writers,
+// byte loads for the reader. Both copies are 128-byte aligned.
+template <class S, std::size_t N>
+StressResult stress_layout(const FieldInfo (&f)[N], std::uint64_t iters)
+{
+    std::vector<unsigned> owners;
+    for (const FieldInfo &fi : f)
+    {
+        bool seen = false;
+        for (unsigned o : owners)
+            seen = seen || o == fi.owner;
+        if (!seen)
+            owners.push_back(fi.owner);
+    }
+
+    constexpr std::size_t kAlign = 128;
+    const std::size_t stride = (sizeof(S) + 2 * kAlign - 1) / kAlign * kAlign; // copy + a spare line
+    struct Free
+    {
+        void operator()(unsigned char *p) const noexcept { ::operator delete(p, std::align_val_t(kAlign)); }
+    };
+    std::unique_ptr<unsigned char, Free> buf(
+        static_cast<unsigned char *>(::operator new(stride * owners.size(), std::align_val_t(kAlign))));
+    std::memset(buf.get(), 0, stride * owners.size());
+
+    auto run = [&](bool private_copies)
+    {
+        std::vector<std::thread> ts;
+        for (unsigned k = 0; k < owners.size(); ++k)
+            ts.emplace_back([&, k]
+                            {
+                bench::pin_this_thread(bench::nth_cpu(k));
+                volatile unsigned char *base = buf.get() + (private_copies ? k * stride : 0);
+                const unsigned owner = owners[k];
+                unsigned sum = 0;
+                for (std::uint64_t i = 0; i < iters; ++i)
+                    for (const FieldInfo &fi : f)
+                        if (fi.owner == owner)
+                        {
+                            if (owner == kReadMostly)
+                                sum += base[fi.offset];
+                            else
+                                base[fi.offset] = static_cast<unsigned char>(i);
+                        }
+                bench::do_not_optimize(sum); });
+        for (auto &t : ts)
+            t.join();
+    };
+
+    const bench::Options opt = bench::Options::from_env(3, 1);
+    StressResult r;
+    r.shared = bench::measure([&]
+                              { run(false); }, opt);
+    r.separate = bench::measure([&]
+                                { run(true); }, opt);
+    r.threads = static_cast<unsigned>(owners.size());
+    return r;
+}
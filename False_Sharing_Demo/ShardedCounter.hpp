@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bench/CacheLine.hpp"
+
+// Counter striped over cache-line-padded slots, one per thread, so concurrent
+// increments never write the same line. Reads are the expensive side: sum()
+// walks every slot.
+//
+//   ShardedCounter hits;
+//   auto h = hits.local();   // once per thread
+//   h.add();                 // hot path: plain load + store on its own line
+//   hits.sum();              // any thread, any time (relaxed snapshot)
+//
+// Each live thread holds a small index, the lowest one free when it first
+// touched a counter, returned when the thread exits; so with at most shards()
+// threads alive every thread owns its slot outright and updates it without a
+// read-modify-write. Threads beyond that share one extra overflow slot with
+// fetch_add. Indices are process-wide: a thread uses the same slot in every
+// ShardedCounter.
+
+namespace detail
+{
+    // Lowest-free-index allocator for the thread slots.
+    class ThreadIndexRegistry
+    {
+    public:
+        static ThreadIndexRegistry &get()
+        {
+            static ThreadIndexRegistry r;
+            return r;
+        }
+
+        std::size_t acquire()
+        {
+            std::lock_guard<std::mutex> lk(_mu);
+            for (std::size_t i = 0; i < _used.size(); ++i)
+                if (!_used[i])
+                {
+                    _used[i] = true;
+                    return i;
+                }
+            _used.push_back(true);
+            return _used.size() - 1;
+        }
+
+        void release(std::size_t i)
+        {
+            std::lock_guard<std::mutex> lk(_mu);
+            _used[i] = false;
+        }
+
+    private:
+        std::mutex _mu;
+        std::vector<bool> _used;
+    };
+
+    struct ThreadIndex
+    {
+        std::size_t value;
+        ThreadIndex() : value(ThreadIndexRegistry::get().acquire()) {}
+        ~ThreadIndex() { ThreadIndexRegistry::get().release(value); }
+    };
+
+    // This thread's index. The registry's mutex orders a slot's old owner's
+    // last store before its new owner's first load.
+    inline std::size_t this_thread_index()
+    {
+        static thread_local ThreadIndex idx;
+        return idx.value;
+    }
+}
+
+class ShardedCounter
+{
+    struct alignas(bench::kPadSize) Slot
+    {
+        std::atomic<std::uint64_t> v{0};
+    };
+    static_assert(sizeof(Slot) == bench::kPadSize, "one slot per kPadSize bytes");
+
+public:
+    // One thread's view of the counter: caches its slot and whether it owns it.
+    class Local
+    {
+    public:
+        void add(std::uint64_t n = 1) noexcept
+        {
+            if (_exclusive) // sole writer: no locked instruction needed
+                _slot->v.store(_slot->v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            else
+                _slot->v.fetch_add(n, std::memory_order_relaxed);
+        }
+
+    private:
+        friend class ShardedCounter;
+        Local(Slot *slot, bool exclusive) noexcept : _slot(slot), _exclusive(exclusive) {}
+
+        Slot *_slot;
+        bool _exclusive;
+    };
+
+    // shards owned slots plus the overflow slot.
+    explicit ShardedCounter(std::size_t shards = default_shards())
+        : _n(shards == 0 ? 1 : shards), _slots(new Slot[_n + 1]) {}
+
+    ShardedCounter(const ShardedCounter &) = delete;
+    ShardedCounter &operator=(const ShardedCounter &) = delete;
+
+    // Handle for the calling thread; valid while the thread and counter live.
+    Local local() noexcept
+    {
+        const std::size_t i = detail::this_thread_index();
+        return i < _n ? Local(&_slots[i], true) : Local(&_slots[_n], false);
+    }
+
+    void add(std::uint64_t n = 1) noexcept { local().add(n); }
+
+    // Sum of all slots. Concurrent increments may or may not be included.
+    std::uint64_t sum() const noexcept
+    {
+        std::uint64_t s = 0;
+        for (std::size_t i = 0; i <= _n; ++i)
+            s += _slots[i].v.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // Not safe against concurrent add().
+    void reset() noexcept
+    {
+        for (std::size_t i = 0; i <= _n; ++i)
+            _slots[i].v.store(0, std::memory_order_relaxed);
+    }
+
+    std::size_t shards() const noexcept { return _n; }
+
+    // One per hardware thread, at least 16 (threads often outnumber cores).
+    static std::size_t default_shards() noexcept
+    {
+        const unsigned hw = std::thread::hardware_concurrency();
+        return hw < 16 ? 16 : hw;
+    }
+
+private:
+    std::size_t _n;
+    std::unique_ptr<Slot[]> _slots;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+// Test-and-test-and-set lock with capped exponential backoff. Waiters spin on
+// a plain load (the line stays shared in their caches) and only retry the
+// exchange once the lock looks free; after kMaxPauses they yield, so it still
+// makes progress when threads outnumber cores. Meets BasicLockable, so it
+// works with std::lock_guard.
+class SpinLock
+{
+public:
+    void lock() noexcept
+    {
+        unsigned pauses = 1;
+        while (_locked.exchange(true, std::memory_order_acquire))
+        {
+            while (_locked.load(std::memory_order_relaxed))
+            {
+                if (pauses <= kMaxPauses)
+                {
+                    for (unsigned i = 0; i < pauses; ++i)
+                        relax();
+                    pauses <<= 1;
+                }
+                else
+                    std::this_thread::yield();
+            }
+        }
+    }
+
+    bool try_lock() noexcept
+    {
+        return !_locked.load(std::memory_order_relaxed) && !_locked.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() noexcept { _locked.store(false, std::memory_order_release); }
+
+private:
+    static constexpr unsigned kMaxPauses = 64;
+
+    static void relax() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        __asm__ __volatile__("yield");
+#endif
+    }
+
+    std::atomic<bool> _locked{false};
+};
@@ -2,10 +2,21 @@
 #include <thread>
 #include <vector>
 #include <iostream>
-#include <chrono>
 #include <cassert>
 #include <iomanip>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <type_traits>
+
+#include "LayoutAnalyzer.hpp"
+#include "ShardedCounter.hpp"
+#include "SpinLock.hpp"
+#include "bench/PerfCounters.hpp"
 
 static constexpr std::uint64_t N = 100000000;
 
@@ -15,95 +26,428 @@ struct CountersBad
     std::atomic<std::uint64_t> a, b;
 };
 
-void worker(std::atomic<std::uint64_t> &counter, std::uint64_t iters)
+void worker(std::atomic<std::uint64_t> &counter, std::uint64_t iters, int cpu)
 {
+    bench::pin_this_thread(cpu); // each counter's writer on its own core
     for (std::uint64_t i = 0; i < iters; ++i)
     {
         counter.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
-double run_bad(std::uint64_t iters)
+// Timed runs of two threads incrementing a and b; counters are reset each run.
+// pmc gets the hardware events per run (HITM is the false-sharing signal).
+bench::Stats time_pair(std::atomic<std::uint64_t> &a, std::atomic<std::uint64_t> &b, std::uint64_t iters,
+                       bench::PerfSample &pmc)
 {
-    CountersBad counters;
-    counters.a.store(0, std::memory_order_relaxed);
-    counters.b.store(0, std::memory_order_relaxed);
-
-    auto start = std::chrono::high_resolution_clock::now();
-
-    std::thread t1(worker, std::ref(counters.a), iters);
-    std::thread t2(worker, std::ref(counters.b), iters);
-
-    t1.join();
-    t2.join();
-
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> duration = end - start;
+    return bench::measure([&]
+                          {
+        a.store(0, std::memory_order_relaxed);
+        b.store(0, std::memory_order_relaxed);
+        std::thread t1(worker, std::ref(a), iters, bench::nth_cpu(0));
+        std::thread t2(worker, std::ref(b), iters, bench::nth_cpu(1));
+        t1.join();
+        t2.join();
+        assert(a.load(std::memory_order_relaxed) == iters);
+        assert(b.load(std::memory_order_relaxed) == iters); },
+                          bench::Options::from_env(5, 3), pmc);
+}
 
-    assert(counters.a.load(std::memory_order_relaxed) == iters);
-    assert(counters.b.load(std::memory_order_relaxed) == iters);
+bench::Stats run_bad(std::uint64_t iters, bench::PerfSample &pmc)
+{
+    CountersBad counters;
+    bench::Stats s = time_pair(counters.a, counters.b, iters, pmc);
 
     auto pa = reinterpret_cast<std::uintptr_t>(&counters.a);
     auto pb = reinterpret_cast<std::uintptr_t>(&counters.b);
     std::cout << "Bad &a=" << pa << " &b=" << pb
               << " delta=" << (pb - pa) << " bytes\n";
 
-    return duration.count();
+    return s;
 }
 
-struct alignas(64) Padded
+// bench::kPadSize: 128 on x86 (adjacent-line prefetch) and Apple silicon,
+// else the cache line; see `false_sharing spacing`.
+struct alignas(bench::kPadSize) Padded
 {
     std::atomic<std::uint64_t> v;
 };
 
-static_assert(alignof(Padded) == 64, "Padded struct must be aligned to 64 bytes");
+static_assert(alignof(Padded) == bench::kPadSize, "Padded struct must be aligned to the padding size");
 
 struct CountersGood
 {
     Padded a, b;
 };
 
-double run_good(std::uint64_t iters)
+bench::Stats run_good(std::uint64_t iters, bench::PerfSample &pmc)
 {
     CountersGood counters;
-    counters.a.v.store(0, std::memory_order_relaxed);
-    counters.b.v.store(0, std::memory_order_relaxed);
+    bench::Stats s = time_pair(counters.a.v, counters.b.v, iters, pmc);
 
-    auto start = std::chrono::high_resolution_clock::now();
+    auto pa = reinterpret_cast<std::uintptr_t>(&counters.a.v);
+    auto pb = reinterpret_cast<std::uintptr_t>(&counters.b.v);
+    std::cout << "Good &a=" << pa << " &b=" << pb
+              << " delta=" << (pb - pa) << " bytes\n";
 
-    std::thread t1(worker, std::ref(counters.a.v), iters);
-    std::thread t2(worker, std::ref(counters.b.v), iters);
+    return s;
+}
 
-    t1.join();
-    t2.join();
+// "0.412 seconds (min 0.405, p99 0.430, stddev 0.008, 5 runs)", then the
+// hardware events per increment when counters are compiled in.
+void print_duration(const char *label, const bench::Stats &s, const bench::PerfSample &pmc, double incs)
+{
+    std::cout << label << " duration: " << s.median_ns * 1e-9 << " seconds (min " << s.min_ns * 1e-9
+              << ", p99 " << s.p99_ns * 1e-9 << ", stddev " << s.stddev_ns * 1e-9 << ", "
+              << s.reps << " runs)" << pmc.format("inc", incs) << "\n";
+}
 
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> duration = end - start;
+// --------------------------- layout analysis ---------------------------
+// The two demo layouts, plus a typical hot stats block whose counters are each
+// bumped by a different worker while every worker reads the config version.
 
-    assert(counters.a.v.load(std::memory_order_relaxed) == iters);
-    assert(counters.b.v.load(std::memory_order_relaxed) == iters);
+static constexpr FieldInfo kBadFields[] = {FS_FIELD(CountersBad, a, 0), FS_FIELD(CountersBad, b, 1)};
+static constexpr FieldInfo kGoodFields[] = {FS_FIELD(CountersGood, a, 0), FS_FIELD(CountersGood, b, 1)};
 
-    auto pa = reinterpret_cast<std::uintptr_t>(&counters.a.v);
-    auto pb = reinterpret_cast<std::uintptr_t>(&counters.b.v);
-    std::cout << "Good &a=" << pa << " &b=" << pb
-              << " delta=" << (pb - pa) << " bytes\n";
+static_assert(false_sharing_pairs<CountersBad>(kBadFields) == 1, "CountersBad is the false-sharing example");
+static_assert(false_sharing_pairs<CountersGood>(kGoodFields) == 0, "CountersGood: a and b share a 64-byte line");
+
+struct ServerStats
+{
+    std::uint32_t config_version; // read by every worker
+    std::atomic<std::uint64_t> requests;
+    std::atomic<std::uint64_t> errors;
+    std::atomic<std::uint64_t> bytes_out;
+};
+
+static constexpr FieldInfo kStatsFields[] = {
+    FS_FIELD(ServerStats, config_version, kReadMostly),
+    FS_FIELD(ServerStats, requests, 0),
+    FS_FIELD(ServerStats, errors, 1),
+    FS_FIELD(ServerStats, bytes_out, 2),
+};
+
+template <class S, std::size_t N>
+void analyse(const char *name, const FieldInfo (&f)[N], std::uint64_t iters)
+{
+    report_layout<S>(name, f);
+    const StressResult r = stress_layout<S>(f, iters);
+    std::cout << "  stress (" << r.threads << " threads, " << iters << " rounds): shared copy "
+              << r.shared.median_ms() << " ms, one copy per thread " << r.separate.median_ms()
+              << " ms, slowdown x" << r.slowdown() << "\n";
+    bench::record(std::string("false_sharing/layout/") + name, r.shared, {{"slowdown", r.slowdown()}});
+}
+
+void run_layouts(std::uint64_t iters)
+{
+    analyse<CountersBad>("CountersBad", kBadFields, iters);
+    analyse<CountersGood>("CountersGood", kGoodFields, iters);
+    analyse<ServerStats>("ServerStats", kStatsFields, iters);
+}
+
+// --------------------------- thread-count sweep ---------------------------
+// t threads each add 1 `iters` times to: one shared atomic; t adjacent
+// atomics (CountersBad's layout); t Padded atomics; a ShardedCounter.
+
+// Timed runs of `threads` pinned threads each running body(tid); reset()
+// before every run, total() checked after it. The threads are started and
+// pinned first and wait on a start gate; the clock runs from opening the
+// gate to the last join, so thread creation is not timed and every thread
+// starts its work at the same moment.
+template <class Reset, class Body, class Total>
+bench::Stats time_threads(unsigned threads, std::uint64_t iters, Reset reset, Body body, Total total)
+{
+    auto run = [&]
+    {
+        reset();
+        std::atomic<unsigned> ready{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> ts;
+        ts.reserve(threads);
+        for (unsigned t = 0; t < threads; ++t)
+            ts.emplace_back([&, t]
+                            {
+                bench::pin_this_thread(bench::nth_cpu(t));
+                ready.fetch_add(1, std::memory_order_release);
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield(); // more threads than CPUs must still all arrive
+                body(t); });
+        while (ready.load(std::memory_order_acquire) < threads)
+            std::this_thread::yield();
+        const std::int64_t t0 = bench::now_ns();
+        go.store(true, std::memory_order_release);
+        for (auto &th : ts)
+            th.join();
+        const double ns = static_cast<double>(bench::now_ns() - t0);
+        assert(total() == threads * iters);
+        (void)total;
+        (void)iters;
+        return ns;
+    };
+    const bench::Options opt = bench::Options::from_env(3, 1);
+    for (std::size_t w = 0; w < opt.warmup_max; ++w)
+        run();
+    std::vector<double> ns;
+    for (std::size_t r = 0; r < opt.reps; ++r)
+        ns.push_back(run());
+    return bench::summarize(std::move(ns));
+}
+
+void run_sweep(unsigned max_threads, std::uint64_t iters)
+{
+    std::vector<unsigned> counts;
+    for (unsigned t = 1; t < max_threads; t *= 2)
+        counts.push_back(t);
+    counts.push_back(max_threads);
 
-    return duration.count();
+    std::cout << "\nThread sweep, " << iters << " increments per thread, ns per increment (wall / total):\n"
+              << "threads    shared  adjacent    padded   sharded\n";
+    for (unsigned t : counts)
+    {
+        const double incs = static_cast<double>(t) * static_cast<double>(iters);
+        const std::string tag = "false_sharing/sweep/threads=" + std::to_string(t);
+        auto ns_per_inc = [&](const char *name, const bench::Stats &st)
+        {
+            bench::record(tag + "/" + name, st, {{"ns_per_inc", st.median_ns / incs}});
+            return st.median_ns / incs;
+        };
+
+        std::atomic<std::uint64_t> shared{0};
+        const bench::Stats st_shared = time_threads(
+            t, iters, [&]
+            { shared.store(0, std::memory_order_relaxed); },
+            [&](unsigned)
+            { worker(shared, iters, -1); },
+            [&]
+            { return shared.load(std::memory_order_relaxed); });
+
+        std::unique_ptr<std::atomic<std::uint64_t>[]> adjacent(new std::atomic<std::uint64_t>[t]);
+        auto sum_adjacent = [&]
+        {
+            std::uint64_t s = 0;
+            for (unsigned i = 0; i < t; ++i)
+                s += adjacent[i].load(std::memory_order_relaxed);
+            return s;
+        };
+        const bench::Stats st_adjacent = time_threads(
+            t, iters, [&]
+            { for (unsigned i = 0; i < t; ++i) adjacent[i].store(0, std::memory_order_relaxed); },
+            [&](unsigned tid)
+            { worker(adjacent[tid], iters, -1); },
+            sum_adjacent);
+
+        std::unique_ptr<Padded[]> padded(new Padded[t]);
+        auto sum_padded = [&]
+        {
+            std::uint64_t s = 0;
+            for (unsigned i = 0; i < t; ++i)
+                s += padded[i].v.load(std::memory_order_relaxed);
+            return s;
+        };
+        const bench::Stats st_padded = time_threads(
+            t, iters, [&]
+            { for (unsigned i = 0; i < t; ++i) padded[i].v.store(0, std::memory_order_relaxed); },
+            [&](unsigned tid)
+            { worker(padded[tid].v, iters, -1); },
+            sum_padded);
+
+        ShardedCounter sharded;
+        const bench::Stats st_sharded = time_threads(
+            t, iters, [&]
+            { sharded.reset(); },
+            [&](unsigned)
+            {
+                ShardedCounter::Local h = sharded.local();
+                for (std::uint64_t i = 0; i < iters; ++i)
+                    h.add();
+            },
+            [&]
+            { return sharded.sum(); });
+
+        std::cout << std::setw(7) << t << std::setw(10) << ns_per_inc("shared", st_shared)
+                  << std::setw(10) << ns_per_inc("adjacent", st_adjacent)
+                  << std::setw(10) << ns_per_inc("padded", st_padded)
+                  << std::setw(10) << ns_per_inc("sharded", st_sharded) << "\n";
+    }
+}
+
+// --------------------------- contention sweep ---------------------------
+// t threads share `total` increments of one counter, through: fetch_add
+// relaxed / seq_cst; a CAS loop; std::mutex; SpinLock; or a thread-local
+// count flushed with one fetch_add every kFlushEvery increments.
+
+static constexpr std::uint64_t kFlushEvery = 1024;
+
+void run_contention(unsigned max_threads, std::uint64_t total)
+{
+    std::vector<unsigned> counts;
+    for (unsigned t = 1; t < max_threads; t *= 2)
+        counts.push_back(t);
+    counts.push_back(max_threads);
+
+    std::cout << "Contention sweep, " << total << " increments split across the threads, ns per increment (wall / total):\n"
+              << "threads   relaxed   seq_cst       CAS     mutex  spinlock   batched\n";
+    for (unsigned t : counts)
+    {
+        const std::uint64_t iters = total / t;
+        const double ops = static_cast<double>(iters) * t;
+        const std::string tag = "false_sharing/contention/threads=" + std::to_string(t);
+
+        std::atomic<std::uint64_t> counter{0};
+        auto reset = [&]
+        { counter.store(0, std::memory_order_relaxed); };
+        auto read = [&]
+        { return counter.load(std::memory_order_relaxed); };
+        auto time = [&](const char *name, auto body)
+        {
+            const bench::Stats st = time_threads(t, iters, reset, body, read);
+            bench::record(tag + "/" + name, st, {{"ns_per_op", st.median_ns / ops}});
+            return st.median_ns / ops;
+        };
+
+        // Under a lock the counter needs no atomic RMW: a relaxed load + store.
+        std::mutex mu;
+        SpinLock spin;
+        auto time_locked = [&](const char *name, auto &lock)
+        {
+            using Lock = typename std::decay<decltype(lock)>::type;
+            return time(name, [&](unsigned)
+                        {
+                for (std::uint64_t i = 0; i < iters; ++i)
+                {
+                    std::lock_guard<Lock> g(lock);
+                    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                } });
+        };
+
+        const double relaxed = time("relaxed", [&](unsigned)
+                                    {
+            for (std::uint64_t i = 0; i < iters; ++i)
+                counter.fetch_add(1, std::memory_order_relaxed); });
+        const double seq_cst = time("seq_cst", [&](unsigned)
+                                    {
+            for (std::uint64_t i = 0; i < iters; ++i)
+                counter.fetch_add(1, std::memory_order_seq_cst); });
+        const double cas = time("cas", [&](unsigned)
+                                {
+            for (std::uint64_t i = 0; i < iters; ++i)
+            {
+                std::uint64_t v = counter.load(std::memory_order_relaxed);
+                while (!counter.compare_exchange_weak(v, v + 1, std::memory_order_relaxed))
+                {
+                }
+            } });
+        const double mutex = time_locked("mutex", mu);
+        const double spinlock = time_locked("spinlock", spin);
+        const double batched = time("batched", [&](unsigned)
+                                    {
+            std::uint64_t local = 0;
+            for (std::uint64_t i = 0; i < iters; ++i)
+                if (++local == kFlushEvery)
+                {
+                    counter.fetch_add(local, std::memory_order_relaxed);
+                    local = 0;
+                }
+            counter.fetch_add(local, std::memory_order_relaxed); });
+
+        std::cout << std::setw(7) << t << std::setw(10) << relaxed << std::setw(10) << seq_cst
+                  << std::setw(10) << cas << std::setw(10) << mutex << std::setw(10) << spinlock
+                  << std::setw(10) << batched << "\n";
+    }
 }
 
-int main()
+// --------------------------- spacing sweep ---------------------------
+// The bad/good pair again, with b placed 8, 64, 128, 256 bytes after a (a on a
+// 256-byte boundary): shows whether one line of padding is enough here.
+
+void run_spacing(std::uint64_t iters)
+{
+    static constexpr std::size_t kGaps[] = {8, 64, 128, 256};
+    struct Free
+    {
+        void operator()(unsigned char *p) const noexcept { ::operator delete(p, std::align_val_t(256)); }
+    };
+    std::unique_ptr<unsigned char, Free> buf(static_cast<unsigned char *>(::operator new(512, std::align_val_t(256))));
+
+    std::cout << "Spacing sweep, 2 threads x " << iters << " increments (padding constant: "
+              << bench::kPadSize << " bytes):\n";
+    const double incs = 2.0 * static_cast<double>(iters);
+    for (std::size_t gap : kGaps)
+    {
+        auto *a = ::new (buf.get()) std::atomic<std::uint64_t>(0);
+        auto *b = ::new (buf.get() + gap) std::atomic<std::uint64_t>(0);
+        bench::PerfSample pmc;
+        const bench::Stats st = time_pair(*a, *b, iters, pmc);
+        std::cout << "  spacing " << std::setw(3) << gap << " B: " << st.median_ns * 1e-9 << " s, "
+                  << incs / (st.median_ns * 1e-3) << " M inc/s" << pmc.format("inc", incs) << "\n";
+        std::vector<bench::Metric> m = pmc.metrics(incs);
+        m.push_back(bench::Metric{"minc_per_s", incs / (st.median_ns * 1e-3)});
+        bench::record("false_sharing/spacing=" + std::to_string(gap), st, std::move(m));
+    }
+}
+
+int main(int argc, char **argv)
 {
+    // Usage: false_sharing [max_threads] [iters_per_thread]
+    //        false_sharing layout [rounds]
+    //        false_sharing spacing [iters_per_thread]
+    //        false_sharing contention [max_threads] [total_increments]
+    // Defaults: every allowed CPU (at least 2), 5M increments per thread in the
+    // sweep; 20M rounds per thread in the layout stress; N/2 in the spacing
+    // sweep; 1..64 threads sharing 4M increments in the contention sweep.
+    if (argc > 1 && std::strcmp(argv[1], "spacing") == 0)
+    {
+        std::cout << std::fixed << std::setprecision(3);
+        run_spacing((argc > 2) ? std::strtoull(argv[2], nullptr, 10) : N / 2);
+        return 0;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "contention") == 0)
+    {
+        const unsigned threads = (argc > 2) ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 64;
+        const std::uint64_t total = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 4000000ull;
+        if (threads == 0 || total < threads)
+        {
+            std::cerr << "need max_threads >= 1 and total_increments >= max_threads\n";
+            return 1;
+        }
+        std::cout << std::fixed << std::setprecision(2);
+        run_contention(threads, total);
+        return 0;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "layout") == 0)
+    {
+        std::cout << std::fixed << std::setprecision(3);
+        run_layouts((argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 20000000ull);
+        return 0;
+    }
+    const unsigned cpus = static_cast<unsigned>(bench::allowed_cpus().size());
+    const unsigned max_threads = (argc > 1) ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10))
+                                            : (cpus < 2 ? 2 : cpus);
+    const std::uint64_t sweep_iters = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 5000000ull;
+    if (max_threads == 0 || sweep_iters == 0)
+    {
+        std::cerr << "max_threads and iters_per_thread must be >= 1\n";
+        return 1;
+    }
+
     std::cout << std::fixed << std::setprecision(3);
 
     std::uint64_t iters = N / 2; // Each thread will increment its counter N/2 times
 
-    double duration1 = run_bad(iters);
-    std::cout << "Bad duration: " << duration1 << " seconds\n";
+    const double incs = 2.0 * static_cast<double>(iters);
+    bench::PerfSample pmc_bad, pmc_good;
+
+    bench::Stats bad = run_bad(iters, pmc_bad);
+    print_duration("Bad", bad, pmc_bad, incs);
+    bench::record("false_sharing/bad", bad, pmc_bad.metrics(incs));
+
+    bench::Stats good = run_good(iters, pmc_good);
+    print_duration("Good", good, pmc_good, incs);
+    bench::record("false_sharing/good", good, pmc_good.metrics(incs));
 
-    double duration2 = run_good(iters);
-    std::cout << "Good duration: " << duration2 << " seconds\n";
+    std::cout << "Speedup: " << (bad.median_ns / good.median_ns) << "x\n";
 
-    std::cout << "Speedup: " << (duration1 / duration2) << "x\n";
+    run_sweep(max_threads, sweep_iters);
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,354 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "NodeFormat.hpp"
+
+// ---------------- Compact format (v4) ----------------
+// Snapshot ids mostly increase and next is almost always i + 1, yet v1 spends
+// 8 bytes a record on them. v4 codes the same records in independent blocks:
+//   MAGIC, u32 version (4), u32 count, u32 block_records, then per block:
+//   u8 flags, varint payload_bytes, payload:
+//     ids:  varint zigzag(id[i] - id[i-1]), with id[-1] = 0 at each block start
+//     next: nothing if flags & COMPACT_SEQUENTIAL_NEXT (next[i] = i + 1, and
+//           -1 for the file's last record), else varint zigzag(next[i] - (i+1))
+// Varints are LEB128: 7 bits a byte, low group first, high bit = more follow.
+// A block needs nothing from the blocks before it and carries its length, so
+// readers can skip blocks or decode them on different threads.
+//
+// The decoder runs separate passes over one block: varint bytes -> u32 array
+// (eight at a time while a 64-bit load shows no continuation bit, the common
+// case for small deltas, else every 1-byte varint up to the first long one),
+// then zigzag + prefix sum and the next indices in flat loops without
+// data-dependent branches.
+
+static const std::size_t COMPACT_BLOCK_RECORDS = 256;
+static const unsigned char COMPACT_SEQUENTIAL_NEXT = 1;
+
+inline std::uint32_t zigzag32(std::int32_t v)
+{
+    const std::uint32_t u = static_cast<std::uint32_t>(v);
+    return (u << 1) ^ (0u - (u >> 31));
+}
+
+inline std::int32_t unzigzag32(std::uint32_t u)
+{
+    return static_cast<std::int32_t>((u >> 1) ^ (0u - (u & 1u)));
+}
+
+inline void put_varint(std::vector<unsigned char> &out, std::uint32_t v)
+{
+    while (v >= 0x80)
+    {
+        out.push_back(static_cast<unsigned char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(v));
+}
+
+inline unsigned lowest_set_bit(std::uint64_t x) // x != 0
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(x));
+#else
+    unsigned n = 0;
+    while ((x & 1) == 0)
+    {
+        x >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+// n varints from [p, end) into out; returns the byte after the last one.
+inline const unsigned char *get_varints(const unsigned char *p, const unsigned char *end, std::uint32_t *out,
+                                        std::size_t n)
+{
+    std::size_t i = 0;
+    while (i < n)
+    {
+        if (n - i >= 8 && end - p >= 8)
+        {
+            std::uint64_t w;
+            std::memcpy(&w, p, 8);
+            if (!host_is_little_endian())
+                w = (static_cast<std::uint64_t>(bswap32(static_cast<std::uint32_t>(w))) << 32) |
+                    bswap32(static_cast<std::uint32_t>(w >> 32));
+            const std::uint64_t more = w & 0x8080808080808080ull;
+            if (more == 0) // eight 1-byte varints
+            {
+                for (std::size_t k = 0; k < 8; ++k)
+                    out[i + k] = p[k];
+                p += 8;
+                i += 8;
+                continue;
+            }
+            // 1-byte varints before the first byte with its high bit set
+            const unsigned k = lowest_set_bit(more) / 8;
+            for (unsigned j = 0; j < k; ++j)
+                out[i + j] = p[j];
+            p += k;
+            i += k;
+        }
+        std::uint32_t v = 0;
+        for (unsigned shift = 0;; shift += 7)
+        {
+            if (p == end || shift > 28)
+                throw std::runtime_error("bad varint");
+            const unsigned char b = *p++;
+            v |= static_cast<std::uint32_t>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0)
+                break;
+        }
+        out[i++] = v;
+    }
+    return p;
+}
+
+inline std::uint32_t read_varint(std::istream &is)
+{
+    std::uint32_t v = 0;
+    for (unsigned shift = 0;; shift += 7)
+    {
+        const int c = is.get();
+        if (c == std::char_traits<char>::eof() || shift > 28)
+            throw std::runtime_error("bad varint");
+        v |= static_cast<std::uint32_t>(c & 0x7f) << shift;
+        if ((c & 0x80) == 0)
+            return v;
+    }
+}
+
+// -------- encoder --------
+
+// Block of records first..first+m of a count-record file, appended to out.
+inline void encode_compact_block(const WireRecord *r, std::size_t first, std::size_t m, std::size_t count,
+                                 std::vector<unsigned char> &payload, std::vector<unsigned char> &out)
+{
+    payload.clear();
+    bool sequential = true;
+    std::uint32_t prev = 0;
+    for (std::size_t j = 0; j < m; ++j)
+    {
+        const std::uint32_t id = static_cast<std::uint32_t>(r[j].id);
+        put_varint(payload, zigzag32(static_cast<std::int32_t>(id - prev)));
+        prev = id;
+        const std::size_t i = first + j;
+        sequential = sequential && r[j].next == (i + 1 < count ? static_cast<std::int32_t>(i + 1) : -1);
+    }
+    if (!sequential)
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            const std::int64_t delta = static_cast<std::int64_t>(r[j].next) - static_cast<std::int64_t>(first + j + 1);
+            put_varint(payload, zigzag32(static_cast<std::int32_t>(delta)));
+        }
+    out.push_back(sequential ? COMPACT_SEQUENTIAL_NEXT : 0);
+    put_varint(out, static_cast<std::uint32_t>(payload.size()));
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+// count records from record(i) -> WireRecord as a v4 stream, written in
+// writes of about 512 KB.
+template <class F>
+void write_compact(std::ostream &os, std::size_t count, F record)
+{
+    if (count > static_cast<std::size_t>(INT32_MAX))
+        throw std::runtime_error("too many nodes for s32 next indices");
+    os.write(reinterpret_cast<const char *>(MAGIC), 4);
+    write_u32_le(os, VERSION_COMPACT);
+    write_u32_le(os, static_cast<std::uint32_t>(count));
+    write_u32_le(os, static_cast<std::uint32_t>(COMPACT_BLOCK_RECORDS));
+
+    WireRecord block[COMPACT_BLOCK_RECORDS];
+    std::vector<unsigned char> payload, out;
+    out.reserve(BULK_CHUNK_RECORDS * 8 + 16 * COMPACT_BLOCK_RECORDS);
+    for (std::size_t base = 0; base < count; base += COMPACT_BLOCK_RECORDS)
+    {
+        const std::size_t m = (count - base < COMPACT_BLOCK_RECORDS) ? count - base : COMPACT_BLOCK_RECORDS;
+        for (std::size_t j = 0; j < m; ++j)
+            block[j] = record(base + j);
+        encode_compact_block(block, base, m, count, payload, out);
+        if (out.size() >= BULK_CHUNK_RECORDS * 8 || base + m == count)
+        {
+            os.write(reinterpret_cast<const char *>(out.data()), static_cast<std::streamsize>(out.size()));
+            if (!os)
+                throw std::runtime_error("write records failed");
+            out.clear();
+        }
+    }
+}
+
+// Blocks for records first..first+m, appended to out (for writers that
+// encode ranges separately, e.g. on several threads).
+template <class F>
+void encode_compact_range(F record, std::size_t first, std::size_t m, std::size_t count,
+                          std::vector<unsigned char> &out)
+{
+    WireRecord block[COMPACT_BLOCK_RECORDS];
+    std::vector<unsigned char> payload;
+    for (std::size_t base = first; base < first + m; base += COMPACT_BLOCK_RECORDS)
+    {
+        const std::size_t b = (first + m - base < COMPACT_BLOCK_RECORDS) ? first + m - base : COMPACT_BLOCK_RECORDS;
+        for (std::size_t j = 0; j < b; ++j)
+            block[j] = record(base + j);
+        encode_compact_block(block, base, b, count, payload, out);
+    }
+}
+
+inline void serialize_list_compact(Node *head, std::ostream &os)
+{
+    const Linearized lin = linearize(head);
+    write_compact(os, lin.order.size(), [&](std::size_t i)
+                  { return lin.record(i); });
+}
+
+// -------- decoder --------
+
+// One block's payload [p, p + len) -> out[0..m); tmp holds m words.
+inline void decode_compact_block(const unsigned char *p, std::size_t len, unsigned char flags, std::size_t first,
+                                 std::size_t m, std::size_t count, std::uint32_t *tmp, WireRecord *out)
+{
+    if ((flags & ~COMPACT_SEQUENTIAL_NEXT) != 0)
+        throw std::runtime_error("bad block flags");
+    const unsigned char *end = p + len;
+
+    p = get_varints(p, end, tmp, m);
+    std::uint32_t id = 0;
+    for (std::size_t j = 0; j < m; ++j)
+    {
+        id += static_cast<std::uint32_t>(unzigzag32(tmp[j]));
+        out[j].id = static_cast<std::int32_t>(id);
+    }
+
+    if (flags & COMPACT_SEQUENTIAL_NEXT)
+    {
+        for (std::size_t j = 0; j < m; ++j)
+            out[j].next = static_cast<std::int32_t>(first + j + 1);
+        if (first + m == count)
+            out[m - 1].next = -1;
+    }
+    else
+    {
+        p = get_varints(p, end, tmp, m);
+        bool ok = true;
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            const std::int64_t next = static_cast<std::int64_t>(first + j + 1) + unzigzag32(tmp[j]);
+            ok = ok && next >= -1 && next < static_cast<std::int64_t>(count);
+            out[j].next = static_cast<std::int32_t>(next);
+        }
+        if (!ok)
+            throw std::runtime_error("next index out of range");
+    }
+    if (p != end)
+        throw std::runtime_error("bad block length");
+}
+
+// Blocks of COMPACT_BLOCK_RECORDS in memory [p, end) holding records
+// first..first+m: on_block(first index, const WireRecord *, n). Throws on
+// anything malformed, including bytes left over at the end.
+template <class F>
+void decode_compact_range(const unsigned char *p, const unsigned char *end, std::size_t first, std::size_t m,
+                          std::size_t count, F on_block)
+{
+    std::uint32_t tmp[COMPACT_BLOCK_RECORDS];
+    WireRecord recs[COMPACT_BLOCK_RECORDS];
+    for (std::size_t base = first; base < first + m; base += COMPACT_BLOCK_RECORDS)
+    {
+        const std::size_t b = (first + m - base < COMPACT_BLOCK_RECORDS) ? first + m - base : COMPACT_BLOCK_RECORDS;
+        if (p == end)
+            throw std::runtime_error("read block failed");
+        const unsigned char flags = *p++;
+        std::uint32_t len = 0;
+        p = get_varints(p, end, &len, 1);
+        if (len > static_cast<std::size_t>(end - p))
+            throw std::runtime_error("bad block length");
+        decode_compact_block(p, len, flags, base, b, count, tmp, recs);
+        p += len;
+        on_block(base, static_cast<const WireRecord *>(recs), b);
+    }
+    if (p != end)
+        throw std::runtime_error("bad chunk length");
+}
+
+struct CompactHeader
+{
+    std::size_t count;
+    std::size_t block_records;
+};
+
+// The v4 fields after MAGIC and version.
+inline CompactHeader read_header_compact(std::istream &is)
+{
+    CompactHeader h;
+    h.count = read_u32_le(is);
+    h.block_records = read_u32_le(is);
+    if (h.block_records == 0 || h.block_records > (std::size_t(1) << 20))
+        throw std::runtime_error("bad block size");
+    return h;
+}
+
+// The blocks of a v4 body: on_block(first index, const WireRecord *, n).
+template <class F>
+void read_compact_blocks(std::istream &is, const CompactHeader &h, F on_block)
+{
+    std::vector<unsigned char> payload;
+    std::vector<std::uint32_t> tmp(h.block_records);
+    std::vector<WireRecord> recs(h.block_records);
+    for (std::size_t base = 0; base < h.count; base += h.block_records)
+    {
+        const std::size_t m = (h.count - base < h.block_records) ? h.count - base : h.block_records;
+        const int flags = is.get();
+        if (flags == std::char_traits<char>::eof())
+            throw std::runtime_error("read block failed");
+        const std::uint32_t len = read_varint(is);
+        if (len > 10 * m) // two 5-byte varints per record at most
+            throw std::runtime_error("bad block length");
+        payload.resize(len);
+        is.read(reinterpret_cast<char *>(payload.data()), static_cast<std::streamsize>(len));
+        if (!is)
+            throw std::runtime_error("read block failed");
+        decode_compact_block(payload.data(), len, static_cast<unsigned char>(flags), base, m, h.count, tmp.data(),
+                             recs.data());
+        on_block(base, static_cast<const WireRecord *>(recs.data()), m);
+    }
+}
+
+// v4 body -> List (after MAGIC and version).
+inline List read_list_compact_body(std::istream &is)
+{
+    const CompactHeader h = read_header_compact(is);
+    List out;
+    out.nodes.resize(h.count);
+    read_compact_blocks(is, h, [&](std::size_t base, const WireRecord *r, std::size_t m)
+                        {
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            Node &nd = out.nodes[base + j];
+            nd.id = static_cast<int>(r[j].id);
+            nd.next = r[j].next >= 0 ? &out.nodes[static_cast<std::size_t>(r[j].next)] : nullptr;
+        } });
+    return out;
+}
+
+inline List deserialize_list_compact(std::istream &is)
+{
+    check_version(read_magic_version(is), VERSION_COMPACT);
+    return read_list_compact_body(is);
+}
+
+// A v1 or v4 list stream, whichever the version after MAGIC says.
+inline List deserialize_list_any(std::istream &is)
+{
+    const std::uint32_t version = read_magic_version(is);
+    if (version == VERSION_COMPACT)
+        return read_list_compact_body(is);
+    check_version(version, VERSION);
+    return read_list_body_v1(is, read_u32_le(is));
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define CRC32C_X86 1
+#include <nmmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32) && !defined(__AARCH64EB__)
+#define CRC32C_ARM 1
+#include <arm_acle.h>
+#endif
+
+// ---------------- CRC32C (Castagnoli) ----------------
+// crc32c(data, n) is the iSCSI/ext4 checksum: reflected polynomial 0x82F63B78,
+// initial and final value ~0, crc32c("123456789") == 0xE3069283. Pass the
+// previous result as `crc` to continue over more data.
+//
+// x86-64 uses the SSE4.2 crc32 instruction, 8 bytes a step, when the CPU has
+// it (checked once at run time, so the build needs no -msse4.2); AArch64 uses
+// the CRC32 extension when the compiler targets it. Anything else falls back
+// to slicing-by-8 tables.
+
+namespace detail
+{
+    struct Crc32cTables
+    {
+        std::uint32_t t[8][256];
+
+        Crc32cTables()
+        {
+            for (std::uint32_t i = 0; i < 256; ++i)
+            {
+                std::uint32_t c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1u)));
+                t[0][i] = c;
+            }
+            for (std::uint32_t i = 0; i < 256; ++i)
+                for (int s = 1; s < 8; ++s)
+                    t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xff];
+        }
+    };
+
+    inline std::uint32_t crc32c_sw(std::uint32_t crc, const unsigned char *p, std::size_t n)
+    {
+        static const Crc32cTables tables;
+        const std::uint32_t(&t)[8][256] = tables.t;
+        while (n >= 8)
+        {
+            const std::uint32_t lo = crc ^ (std::uint32_t(p[0]) | std::uint32_t(p[1]) << 8 |
+                                            std::uint32_t(p[2]) << 16 | std::uint32_t(p[3]) << 24);
+            crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+                  t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+            p += 8;
+            n -= 8;
+        }
+        while (n--)
+            crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xff];
+        return crc;
+    }
+
+#if defined(CRC32C_X86)
+#if defined(__GNUC__) || defined(__clang__)
+#define CRC32C_TARGET_SSE42 __attribute__((target("sse4.2")))
+#else
+#define CRC32C_TARGET_SSE42
+#endif
+    CRC32C_TARGET_SSE42 inline std::uint32_t crc32c_hw(std::uint32_t crc, const unsigned char *p, std::size_t n)
+    {
+        std::uint64_t c = crc;
+        for (; n >= 8; p += 8, n -= 8)
+        {
+            std::uint64_t w;
+            std::memcpy(&w, p, 8);
+            c = _mm_crc32_u64(c, w);
+        }
+        std::uint32_t c32 = static_cast<std::uint32_t>(c);
+        for (; n > 0; ++p, --n)
+            c32 = _mm_crc32_u8(c32, *p);
+        return c32;
+    }
+
+    inline bool crc32c_hw_available()
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        static const bool ok = __builtin_cpu_supports("sse4.2");
+#else
+        static const bool ok = []
+        {
+            int r[4];
+            __cpuid(r, 1);
+            return (r[2] & (1 << 20)) != 0;
+        }();
+#endif
+        return ok;
+    }
+#elif defined(CRC32C_ARM)
+    inline std::uint32_t crc32c_hw(std::uint32_t crc, const unsigned char *p, std::size_t n)
+    {
+        for (; n >= 8; p += 8, n -= 8)
+        {
+            std::uint64_t w;
+            std::memcpy(&w, p, 8);
+            crc = __crc32cd(crc, w);
+        }
+        for (; n > 0; ++p, --n)
+            crc = __crc32cb(crc, *p);
+        return crc;
+    }
+
+    inline bool crc32c_hw_available() { return true; }
+#else
+    inline bool crc32c_hw_available() { return false; }
+#endif
+}
+
+// True when crc32c() runs on the CPU's CRC instruction.
+inline bool crc32c_hardware() { return detail::crc32c_hw_available(); }
+
+inline std::uint32_t crc32c(const void *data, std::size_t n, std::uint32_t crc = 0)
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+#if defined(CRC32C_X86) || defined(CRC32C_ARM)
+    if (detail::crc32c_hw_available())
+        return ~detail::crc32c_hw(~crc, p, n);
+#endif
+    return ~detail::crc32c_sw(~crc, p, n);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NODES_HAVE_MMAP 1
+#endif
+
+// ------------------------------ MappedFile ------------------------------
+// Read-only view of a whole file. With mmap the bytes are paged in on first
+// touch, so opening costs the same for 1 KB and 10 GB; the mapping is private
+// and read-only, and it stays valid after the descriptor is closed. Without
+// mmap it degrades to reading the file into a heap buffer.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string &path)
+    {
+#if defined(NODES_HAVE_MMAP)
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("open failed: " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("fstat failed: " + path);
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ > 0)
+        {
+            void *p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error("mmap failed: " + path);
+            }
+            data_ = static_cast<const unsigned char *>(p);
+        }
+        ::close(fd);
+#else
+        std::ifstream is(path, std::ios::binary | std::ios::ate);
+        if (!is)
+            throw std::runtime_error("open failed: " + path);
+        size_ = static_cast<std::size_t>(is.tellg());
+        is.seekg(0);
+        buffer_.reset(new unsigned char[size_ > 0 ? size_ : 1]);
+        if (!is.read(reinterpret_cast<char *>(buffer_.get()), static_cast<std::streamsize>(size_)))
+            throw std::runtime_error("read failed: " + path);
+        data_ = buffer_.get();
+#endif
+    }
+
+    ~MappedFile() { unmap(); }
+
+    MappedFile(MappedFile &&o) noexcept { swap(o); }
+    MappedFile &operator=(MappedFile &&o) noexcept
+    {
+        if (this != &o)
+        {
+            unmap();
+            swap(o);
+        }
+        return *this;
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const unsigned char *data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+
+private:
+    void unmap() noexcept
+    {
+#if defined(NODES_HAVE_MMAP)
+        if (data_ != nullptr)
+            ::munmap(const_cast<unsigned char *>(data_), size_);
+#else
+        buffer_.reset();
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    void swap(MappedFile &o) noexcept
+    {
+        std::swap(data_, o.data_);
+        std::swap(size_, o.size_);
+#if !defined(NODES_HAVE_MMAP)
+        std::swap(buffer_, o.buffer_);
+#endif
+    }
+
+    const unsigned char *data_ = nullptr;
+    std::size_t size_ = 0;
+#if !defined(NODES_HAVE_MMAP)
+    std::unique_ptr<unsigned char[]> buffer_;
+#endif
+};
@@ -0,0 +1,499 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <stdexcept>
+#include <string>
+#include <iostream>
+#include <climits>
+
+#include "MappedFile.hpp"
+
+// Node list wire formats. Both store the list in order from the head as
+// (id, next index) pairs of little-endian s32, next = -1 at the tail, so a
+// file means the same thing whatever sizeof(long)/sizeof(void*) the writer
+// and the reader have.
+//   v1: MAGIC, u32 version, u32 count, records. deserialize_list() streams it
+//       into an owning List and rebuilds the pointers.
+//   v2: 64-byte header, 8-byte records from offset 64. Meant to be used in
+//       place: MappedNodes maps the file and reads records where they lie.
+//   v3: v1 plus a table of root indices, for graphs with cycles, shared
+//       nodes and several roots (NodeGraph.hpp).
+//   v4: v1's records delta + zigzag varint coded in blocks (CompactFormat.hpp).
+//   v5: v4 blocks in CRC32C-checked chunks behind an offset table, encoded
+//       and decoded on several threads (ParallelFormat.hpp).
+// Readers check the version after MAGIC; deserialize_list_any()
+// (CompactFormat.hpp) takes v1 or v4 and dispatches on it.
+
+// ---------------- In-memory node ----------------
+struct Node
+{
+    int id;
+    Node *next;
+};
+
+// ---------------- Endian helpers (C++11) ----------------
+inline bool host_is_little_endian()
+{
+    union
+    {
+        uint16_t u16;
+        unsigned char b[2];
+    } v = {0x0100};
+    return v.b[1] == 0x01; // 0x0001 in memory if LE; here we stored 0x0100, so LE -> [0x00,0x01]
+}
+
+inline std::uint32_t bswap32(std::uint32_t x)
+{
+    return ((x & 0x000000FFu) << 24) | ((x & 0x0000FF00u) << 8) | ((x & 0x00FF0000u) >> 8) | ((x & 0xFF000000u) >> 24);
+}
+
+inline void write_u32_le(std::ostream &os, std::uint32_t v)
+{
+    if (!host_is_little_endian())
+        v = bswap32(v);
+    os.write(reinterpret_cast<const char *>(&v), 4);
+    if (!os)
+        throw std::runtime_error("write_u32_le failed");
+}
+
+inline std::uint32_t read_u32_le(std::istream &is)
+{
+    std::uint32_t v = 0;
+    is.read(reinterpret_cast<char *>(&v), 4);
+    if (!is)
+        throw std::runtime_error("read_u32_le failed");
+    if (!host_is_little_endian())
+        v = bswap32(v);
+    return v;
+}
+
+// Signed 32-bit via unsigned transport
+inline void write_s32_le(std::ostream &os, std::int32_t s)
+{
+    write_u32_le(os, static_cast<std::uint32_t>(s));
+}
+inline std::int32_t read_s32_le(std::istream &is)
+{
+    return static_cast<std::int32_t>(read_u32_le(is));
+}
+
+// Same encoding on raw bytes (mapped files, header buffers); p need not be aligned.
+inline std::uint32_t load_u32_le(const unsigned char *p)
+{
+    std::uint32_t v;
+    std::memcpy(&v, p, 4);
+    return host_is_little_endian() ? v : bswap32(v);
+}
+
+inline void store_u32_le(unsigned char *p, std::uint32_t v)
+{
+    if (!host_is_little_endian())
+        v = bswap32(v);
+    std::memcpy(p, &v, 4);
+}
+
+inline std::uint64_t load_u64_le(const unsigned char *p)
+{
+    return static_cast<std::uint64_t>(load_u32_le(p)) | (static_cast<std::uint64_t>(load_u32_le(p + 4)) << 32);
+}
+
+inline void store_u64_le(unsigned char *p, std::uint64_t v)
+{
+    store_u32_le(p, static_cast<std::uint32_t>(v));
+    store_u32_le(p + 4, static_cast<std::uint32_t>(v >> 32));
+}
+
+// ---------------- Wire format magic/version ----------------
+static const unsigned char MAGIC[4] = {'N', 'D', 'L', 'S'};
+static const std::uint32_t VERSION = 1;
+static const std::uint32_t VERSION_MAPPED = 2;
+static const std::uint32_t VERSION_GRAPH = 3;    // NodeGraph.hpp
+static const std::uint32_t VERSION_COMPACT = 4;  // CompactFormat.hpp
+static const std::uint32_t VERSION_PARALLEL = 5; // ParallelFormat.hpp
+
+// Throws unless version == expected, naming the reader for known versions.
+inline void check_version(std::uint32_t version, std::uint32_t expected)
+{
+    if (version == expected)
+        return;
+    if (version == VERSION)
+        throw std::runtime_error("version 1 file: read it with deserialize_list");
+    if (version == VERSION_MAPPED)
+        throw std::runtime_error("version 2 file: open it with MappedNodes");
+    if (version == VERSION_GRAPH)
+        throw std::runtime_error("version 3 file: read it with deserialize_graph");
+    if (version == VERSION_COMPACT)
+        throw std::runtime_error("version 4 file: read it with deserialize_list_compact");
+    if (version == VERSION_PARALLEL)
+        throw std::runtime_error("version 5 file: open it with ParallelSnapshot");
+    throw std::runtime_error("unsupported version");
+}
+
+// MAGIC and the version after it, in one read.
+inline std::uint32_t read_magic_version(std::istream &is)
+{
+    unsigned char h[8];
+    is.read(reinterpret_cast<char *>(h), sizeof(h));
+    if (!is)
+        throw std::runtime_error("read header failed");
+    if (std::memcmp(h, MAGIC, 4) != 0)
+        throw std::runtime_error("bad magic");
+    return load_u32_le(h + 4);
+}
+
+// v2 header, all fields little-endian (offset: field):
+//    0: magic[4]       4: u32 version (2)   8: u64 count
+//   16: u32 header_size (64, first record)  20: u32 record_size (8)
+//   24: s32 head (-1 if empty)             28..63: zero
+// 64 bytes keep the records cache-line aligned in a page-aligned mapping.
+static const std::size_t V2_HEADER_SIZE = 64;
+static const std::size_t V2_RECORD_SIZE = 8;
+
+inline void write_header_v2(std::ostream &os, std::uint64_t count, std::int32_t head)
+{
+    if (count > static_cast<std::uint64_t>(INT32_MAX))
+        throw std::runtime_error("too many nodes for s32 next indices");
+    unsigned char h[V2_HEADER_SIZE] = {};
+    std::memcpy(h, MAGIC, 4);
+    store_u32_le(h + 4, VERSION_MAPPED);
+    store_u64_le(h + 8, count);
+    store_u32_le(h + 16, static_cast<std::uint32_t>(V2_HEADER_SIZE));
+    store_u32_le(h + 20, static_cast<std::uint32_t>(V2_RECORD_SIZE));
+    store_u32_le(h + 24, static_cast<std::uint32_t>(count == 0 ? -1 : head));
+    os.write(reinterpret_cast<const char *>(h), sizeof(h));
+    if (!os)
+        throw std::runtime_error("write header failed");
+}
+
+// ---------------- Serializer ----------------
+// One record as it goes on the wire (before the little-endian conversion).
+struct WireRecord
+{
+    std::int32_t id;
+    std::int32_t next; // index of the next record, -1 for none
+};
+
+// id must fit s32 on the wire
+inline std::int32_t wire_id(const Node *p)
+{
+    if (p->id < INT32_MIN || p->id > INT32_MAX)
+        throw std::runtime_error("id out of s32 range for wire format");
+    return static_cast<std::int32_t>(p->id);
+}
+
+// Nodes reachable from 'head' in list order. Node i's next is node i + 1, so
+// no pointer -> index lookup is needed; Brent's cycle check (one saved
+// pointer) turns a cyclic list into an error instead of an endless walk.
+// Cyclic and shared structures go through serialize_graph() (NodeGraph.hpp).
+struct Linearized
+{
+    std::vector<Node *> order;
+
+    WireRecord record(std::size_t i) const
+    {
+        const std::int32_t next = (i + 1 < order.size()) ? static_cast<std::int32_t>(i + 1) : -1;
+        return WireRecord{wire_id(order[i]), next};
+    }
+};
+
+inline Linearized linearize(Node *head)
+{
+    Linearized lin;
+    const Node *tortoise = head;
+    std::size_t power = 1, steps = 1;
+    for (Node *p = head; p != nullptr; p = p->next)
+    {
+        if (lin.order.size() >= static_cast<std::size_t>(INT32_MAX))
+            throw std::runtime_error("too many nodes for s32 next indices");
+        lin.order.push_back(p);
+        if (p->next == tortoise)
+            throw std::runtime_error("cycle in list: use serialize_graph");
+        if (steps == power)
+        {
+            tortoise = p->next;
+            power *= 2;
+            steps = 0;
+        }
+        ++steps;
+    }
+    return lin;
+}
+
+inline void write_header_v1(std::ostream &os, std::uint32_t count)
+{
+    os.write(reinterpret_cast<const char *>(MAGIC), 4);
+    if (!os)
+        throw std::runtime_error("write magic failed");
+    write_u32_le(os, VERSION);
+    write_u32_le(os, count);
+}
+
+// (id, next index) records, shared by v1 and v2.
+inline void write_records(const Linearized &lin, std::ostream &os)
+{
+    for (std::size_t i = 0; i < lin.order.size(); ++i)
+    {
+        const WireRecord r = lin.record(i);
+        write_s32_le(os, r.id);
+        write_s32_le(os, r.next);
+    }
+}
+
+// Serializes the list reachable from 'head' (duplicates not removed).
+inline void serialize_list(Node *head, std::ostream &os)
+{
+    // 1) Linearize nodes and assign indices
+    const Linearized lin = linearize(head);
+
+    // 2) Header
+    write_header_v1(os, static_cast<std::uint32_t>(lin.order.size()));
+
+    // 3) Body
+    write_records(lin, os);
+}
+
+// Same list in the v2 (mappable) layout.
+inline void serialize_list_v2(Node *head, std::ostream &os)
+{
+    const Linearized lin = linearize(head);
+    write_header_v2(os, lin.order.size(), 0);
+    write_records(lin, os);
+}
+
+// ---------------- Owning container for a deserialized list ----------------
+struct List
+{
+    std::vector<Node> nodes; // owns storage
+    Node *head() { return nodes.empty() ? nullptr : &nodes[0]; }
+};
+
+// ---------------- Deserializer ----------------
+inline List deserialize_list(std::istream &is)
+{
+    // 1) Header
+    unsigned char magic[4] = {0, 0, 0, 0};
+    is.read(reinterpret_cast<char *>(magic), 4);
+    if (!is)
+        throw std::runtime_error("read magic failed");
+    if (!(magic[0] == MAGIC[0] && magic[1] == MAGIC[1] && magic[2] == MAGIC[2] && magic[3] == MAGIC[3]))
+        throw std::runtime_error("bad magic");
+
+    std::uint32_t version = read_u32_le(is);
+    check_version(version, VERSION);
+
+    std::uint32_t count = read_u32_le(is);
+
+    // 2) Reserve & temp next indices
+    List out;
+    out.nodes.resize(count);
+    std::vector<std::int32_t> nextIdx(count, -1);
+
+    // 3) Read nodes (ids & next indices)
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        std::int32_t id = read_s32_le(is);
+        std::int32_t nxt = read_s32_le(is);
+        out.nodes[i].id = static_cast<int>(id);
+        out.nodes[i].next = nullptr; // link later
+        nextIdx[i] = nxt;
+    }
+
+    // 4) Rebuild pointers
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        if (nextIdx[i] >= 0)
+        {
+            std::size_t j = static_cast<std::size_t>(nextIdx[i]);
+            if (j >= out.nodes.size())
+                throw std::runtime_error("next index out of range");
+            out.nodes[i].next = &out.nodes[j];
+        }
+    }
+
+    return out;
+}
+
+// ---------------- Bulk path ----------------
+// The same bytes, a chunk at a time: records are built as host-order words
+// in a buffer, converted to little-endian in one pass over the chunk (nothing
+// to do on little-endian hosts, a loop the compiler vectorises elsewhere) and
+// moved with one os.write / is.read per chunk, instead of a 4-byte stream call
+// and state check per field. Chunks are larger than a filebuf's buffer, so
+// each one goes to the OS as a single write(2).
+static const std::size_t BULK_CHUNK_RECORDS = 64 * 1024; // 512 KB
+
+inline void words_to_le(std::uint32_t *w, std::size_t n)
+{
+    if (host_is_little_endian())
+        return;
+    for (std::size_t i = 0; i < n; ++i)
+        w[i] = bswap32(w[i]);
+}
+
+// Little-endian -> host is the same swap.
+inline void words_from_le(std::uint32_t *w, std::size_t n) { words_to_le(w, n); }
+
+// n records from record(i) -> WireRecord, one os.write per chunk.
+template <class F>
+void write_records_chunked(std::ostream &os, std::size_t n, F record)
+{
+    std::vector<std::uint32_t> buf(2 * (n < BULK_CHUNK_RECORDS ? n : BULK_CHUNK_RECORDS));
+    for (std::size_t base = 0; base < n; base += BULK_CHUNK_RECORDS)
+    {
+        const std::size_t m = (n - base < BULK_CHUNK_RECORDS) ? n - base : BULK_CHUNK_RECORDS;
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            const WireRecord r = record(base + j);
+            buf[2 * j] = static_cast<std::uint32_t>(r.id);
+            buf[2 * j + 1] = static_cast<std::uint32_t>(r.next);
+        }
+        words_to_le(buf.data(), 2 * m);
+        os.write(reinterpret_cast<const char *>(buf.data()), static_cast<std::streamsize>(m * 8));
+        if (!os)
+            throw std::runtime_error("write records failed");
+    }
+}
+
+inline void write_records_bulk(const Linearized &lin, std::ostream &os)
+{
+    write_records_chunked(os, lin.order.size(), [&](std::size_t i)
+                          { return lin.record(i); });
+}
+
+// serialize_list() through the bulk path; the output is byte-identical.
+inline void serialize_list_bulk(Node *head, std::ostream &os)
+{
+    const Linearized lin = linearize(head);
+    unsigned char h[12];
+    std::memcpy(h, MAGIC, 4);
+    store_u32_le(h + 4, VERSION);
+    store_u32_le(h + 8, static_cast<std::uint32_t>(lin.order.size()));
+    os.write(reinterpret_cast<const char *>(h), sizeof(h));
+    if (!os)
+        throw std::runtime_error("write header failed");
+    write_records_bulk(lin, os);
+}
+
+// count records read chunk_records at a time (one is.read each), passed to
+// on_chunk(first index, const WireRecord *, n) in host order; throws on a
+// next index >= count. Memory is one chunk, whatever count is.
+template <class F>
+void read_record_chunks(std::istream &is, std::size_t count, std::size_t chunk_records, F on_chunk)
+{
+    static_assert(sizeof(WireRecord) == 8, "records are read in place");
+    if (chunk_records == 0)
+        throw std::runtime_error("chunk size must be >= 1");
+    std::vector<WireRecord> buf(count < chunk_records ? count : chunk_records);
+    for (std::size_t base = 0; base < count; base += chunk_records)
+    {
+        const std::size_t m = (count - base < chunk_records) ? count - base : chunk_records;
+        is.read(reinterpret_cast<char *>(buf.data()), static_cast<std::streamsize>(m * 8));
+        if (!is)
+            throw std::runtime_error("read records failed");
+        words_from_le(reinterpret_cast<std::uint32_t *>(buf.data()), 2 * m);
+        for (std::size_t j = 0; j < m; ++j)
+            if (buf[j].next >= 0 && static_cast<std::size_t>(buf[j].next) >= count)
+                throw std::runtime_error("next index out of range");
+        on_chunk(base, static_cast<const WireRecord *>(buf.data()), m);
+    }
+}
+
+// Same, one record at a time: sink(i, WireRecord).
+template <class F>
+void read_records_chunked(std::istream &is, std::size_t count, F sink)
+{
+    read_record_chunks(is, count, BULK_CHUNK_RECORDS, [&](std::size_t base, const WireRecord *r, std::size_t m)
+                       {
+        for (std::size_t j = 0; j < m; ++j)
+            sink(base + j, r[j]); });
+}
+
+// The v1 header; returns the record count.
+inline std::uint32_t read_header_v1(std::istream &is)
+{
+    check_version(read_magic_version(is), VERSION);
+    return read_u32_le(is);
+}
+
+// v1 records after the header -> List. Nodes are allocated up front, so next
+// pointers are set as each chunk arrives, without the nextIdx pass.
+inline List read_list_body_v1(std::istream &is, std::size_t count)
+{
+    List out;
+    out.nodes.resize(count);
+    read_records_chunked(is, count, [&](std::size_t i, const WireRecord &r)
+                         {
+        Node &nd = out.nodes[i];
+        nd.id = static_cast<int>(r.id);
+        nd.next = r.next >= 0 ? &out.nodes[static_cast<std::size_t>(r.next)] : nullptr; });
+    return out;
+}
+
+// deserialize_list() through the bulk path.
+inline List deserialize_list_bulk(std::istream &is)
+{
+    return read_list_body_v1(is, read_header_v1(is));
+}
+
+// ---------------- Zero-copy reader for v2 ----------------
+// The nodes of a v2 file, read in place from a mapping: opening checks the
+// header and the file size and does nothing per node, so it costs a few page
+// faults however large the file is. next() is an index, not a pointer.
+//
+//   MappedNodes nodes("snapshot.bin");
+//   for (std::int32_t i = nodes.head(); i != MappedNodes::npos; i = nodes.at(i).next)
+//       use(nodes.at(i).id);
+class MappedNodes
+{
+public:
+    static const std::int32_t npos = -1;
+
+    using Record = WireRecord; // next: index into the same file, or npos
+
+    explicit MappedNodes(const std::string &path) : file_(path)
+    {
+        const unsigned char *h = file_.data();
+        if (file_.size() < V2_HEADER_SIZE || std::memcmp(h, MAGIC, 4) != 0)
+            throw std::runtime_error("bad magic");
+        check_version(load_u32_le(h + 4), VERSION_MAPPED);
+        const std::uint64_t count = load_u64_le(h + 8);
+        const std::uint32_t header_size = load_u32_le(h + 16);
+        if (load_u32_le(h + 20) != V2_RECORD_SIZE || header_size < V2_HEADER_SIZE || header_size % 8 != 0)
+            throw std::runtime_error("bad v2 header");
+        if (count > static_cast<std::uint64_t>(INT32_MAX) || file_.size() < header_size ||
+            (file_.size() - header_size) / V2_RECORD_SIZE < count)
+            throw std::runtime_error("truncated v2 file");
+        count_ = static_cast<std::size_t>(count);
+        head_ = static_cast<std::int32_t>(load_u32_le(h + 24));
+        if (head_ != npos && (head_ < 0 || static_cast<std::size_t>(head_) >= count_))
+            throw std::runtime_error("head index out of range");
+        records_ = h + header_size;
+    }
+
+    std::size_t size() const noexcept { return count_; }
+    std::int32_t head() const noexcept { return head_; }
+
+    // Unchecked: i < size().
+    Record operator[](std::size_t i) const noexcept
+    {
+        const unsigned char *p = records_ + i * V2_RECORD_SIZE;
+        return Record{static_cast<std::int32_t>(load_u32_le(p)), static_cast<std::int32_t>(load_u32_le(p + 4))};
+    }
+
+    // Checked: throws on an index outside the file, so a corrupt next can't
+    // walk off the mapping.
+    Record at(std::int32_t i) const
+    {
+        if (i < 0 || static_cast<std::size_t>(i) >= count_)
+            throw std::runtime_error("next index out of range");
+        return (*this)[static_cast<std::size_t>(i)];
+    }
+
+private:
+    MappedFile file_;
+    const unsigned char *records_ = nullptr;
+    std::size_t count_ = 0;
+    std::int32_t head_ = npos;
+};
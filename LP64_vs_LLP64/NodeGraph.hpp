@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "NodeFormat.hpp"
+#include "PtrIndexTable.hpp"
+
+// ---------------- Graph serialization (v3) ----------------
+// Any set of nodes reachable from a list of roots: a next may point back
+// (cycles), several nodes may share a successor, and roots may overlap.
+// Every node is written once. Wire layout, little-endian:
+//   MAGIC, u32 version (3), u32 count, u32 root_count,
+//   s32 roots[root_count] (-1 for a null root), count (id, next) records.
+//
+// Two ways to turn pointers into indices:
+//   serialize_graph()       nodes anywhere in memory; a PtrIndexTable sized
+//                           from `expected_nodes`, one probe per node.
+//   serialize_graph_arena() nodes that all live in one vector, e.g. a
+//                           deserialized List::nodes; index = p - base, no
+//                           hashing, and every node of the vector is written.
+
+// ---------------- Owning container for a deserialized graph ----------------
+struct Graph
+{
+    std::vector<Node> nodes; // owns storage
+    std::vector<Node *> roots;
+};
+
+// Nodes in first-visit order, each node's next index, and the roots' indices.
+struct GraphLinearized
+{
+    std::vector<Node *> order;
+    std::vector<std::int32_t> next;
+    std::vector<std::int32_t> roots;
+};
+
+// Walks each root until it reaches null or a node already numbered. `index`
+// maps Node* -> index: insert(p, i) returns (p's index, whether p was new).
+template <class Index>
+GraphLinearized linearize_graph_with(const std::vector<Node *> &roots, Index &index)
+{
+    GraphLinearized lin;
+    for (Node *r : roots)
+    {
+        std::int32_t prev = -1; // last node numbered on this walk
+        std::int32_t root = -1;
+        for (Node *p = r; p != nullptr; p = p->next)
+        {
+            if (lin.order.size() >= static_cast<std::size_t>(INT32_MAX))
+                throw std::runtime_error("too many nodes for s32 next indices");
+            const std::pair<std::int32_t, bool> ins = index.insert(p, static_cast<std::int32_t>(lin.order.size()));
+            if (prev >= 0)
+                lin.next[static_cast<std::size_t>(prev)] = ins.first;
+            else
+                root = ins.first;
+            if (!ins.second)
+                break; // rest of the walk is already numbered
+            lin.order.push_back(p);
+            lin.next.push_back(-1);
+            prev = ins.first;
+        }
+        lin.roots.push_back(root);
+    }
+    return lin;
+}
+
+inline GraphLinearized linearize_graph(const std::vector<Node *> &roots, std::size_t expected_nodes = 0)
+{
+    PtrIndexTable<Node> index(expected_nodes);
+    return linearize_graph_with(roots, index);
+}
+
+inline void write_header_graph(std::ostream &os, std::size_t count, const std::vector<std::int32_t> &roots)
+{
+    if (count > static_cast<std::size_t>(INT32_MAX) || roots.size() > static_cast<std::size_t>(INT32_MAX))
+        throw std::runtime_error("too many nodes for s32 next indices");
+    std::vector<unsigned char> h(16 + 4 * roots.size());
+    std::memcpy(h.data(), MAGIC, 4);
+    store_u32_le(&h[4], VERSION_GRAPH);
+    store_u32_le(&h[8], static_cast<std::uint32_t>(count));
+    store_u32_le(&h[12], static_cast<std::uint32_t>(roots.size()));
+    for (std::size_t i = 0; i < roots.size(); ++i)
+        store_u32_le(&h[16 + 4 * i], static_cast<std::uint32_t>(roots[i]));
+    os.write(reinterpret_cast<const char *>(h.data()), static_cast<std::streamsize>(h.size()));
+    if (!os)
+        throw std::runtime_error("write header failed");
+}
+
+inline void write_graph(const GraphLinearized &lin, std::ostream &os)
+{
+    write_header_graph(os, lin.order.size(), lin.roots);
+    write_records_chunked(os, lin.order.size(), [&](std::size_t i)
+                          { return WireRecord{wire_id(lin.order[i]), lin.next[i]}; });
+}
+
+inline void serialize_graph(const std::vector<Node *> &roots, std::ostream &os, std::size_t expected_nodes = 0)
+{
+    write_graph(linearize_graph(roots, expected_nodes), os);
+}
+
+// Arena fast path: record i is arena[i]. Throws if a root or next points
+// outside the arena (use serialize_graph for those).
+inline void serialize_graph_arena(const std::vector<Node> &arena, const std::vector<Node *> &roots, std::ostream &os)
+{
+    const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(arena.data());
+    const std::size_t n = arena.size();
+    auto index_of = [&](const Node *p) -> std::int32_t
+    {
+        if (p == nullptr)
+            return -1;
+        const std::uintptr_t off = reinterpret_cast<std::uintptr_t>(p) - base;
+        if (off >= n * sizeof(Node) || off % sizeof(Node) != 0)
+            throw std::runtime_error("pointer outside the arena: use serialize_graph");
+        return static_cast<std::int32_t>(off / sizeof(Node));
+    };
+
+    std::vector<std::int32_t> root_idx;
+    root_idx.reserve(roots.size());
+    for (const Node *r : roots)
+        root_idx.push_back(index_of(r));
+    write_header_graph(os, n, root_idx);
+    write_records_chunked(os, n, [&](std::size_t i)
+                          { return WireRecord{wire_id(&arena[i]), index_of(arena[i].next)}; });
+}
+
+inline Graph deserialize_graph(std::istream &is)
+{
+    check_version(read_magic_version(is), VERSION_GRAPH);
+    const std::size_t count = read_u32_le(is);
+    const std::size_t root_count = read_u32_le(is);
+
+    std::vector<unsigned char> rb(4 * root_count);
+    is.read(reinterpret_cast<char *>(rb.data()), static_cast<std::streamsize>(rb.size()));
+    if (!is)
+        throw std::runtime_error("read roots failed");
+
+    Graph out;
+    out.nodes.resize(count);
+    out.roots.reserve(root_count);
+    for (std::size_t i = 0; i < root_count; ++i)
+    {
+        const std::int32_t r = static_cast<std::int32_t>(load_u32_le(&rb[4 * i]));
+        if (r >= 0 && static_cast<std::size_t>(r) >= count)
+            throw std::runtime_error("root index out of range");
+        out.roots.push_back(r >= 0 ? &out.nodes[static_cast<std::size_t>(r)] : nullptr);
+    }
+    read_records_chunked(is, count, [&](std::size_t i, const WireRecord &r)
+                         {
+        Node &nd = out.nodes[i];
+        nd.id = static_cast<int>(r.id);
+        nd.next = r.next >= 0 ? &out.nodes[static_cast<std::size_t>(r.next)] : nullptr; });
+    return out;
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CompactFormat.hpp"
+#include "Crc32c.hpp"
+#include "MappedFile.hpp"
+
+// ---------------- Chunked parallel format (v5) ----------------
+// v4 blocks grouped into chunks of chunk_records, behind an offset table, so
+// any thread can encode, check or decode any chunk, and each chunk carries a
+// CRC32C so a damaged one is found, and named, without reading the others.
+// All fields little-endian:
+//    0: magic[4]          4: u32 version (5)    8: u32 count
+//   12: u32 chunk_records 16: u32 chunk_count  20: u32 crc32c of the table
+//   24: chunk_count x {u64 offset from file start, u32 bytes, u32 crc32c}
+//   then the chunks; chunk k holds records k * chunk_records .. as v4 blocks
+//   (CompactFormat.hpp).
+//
+//   serialize_parallel(os, n, record, threads);   // record(i) from any thread
+//   ParallelSnapshot snap("snapshot.bin");         // header and table only
+//   snap.verify(threads);                          // indices of bad chunks
+//   List l = snap.decode(threads);                 // throws on a bad chunk
+
+static const std::size_t PARALLEL_CHUNK_RECORDS = std::size_t(1) << 20;
+static const std::size_t V5_HEADER_SIZE = 24;
+static const std::size_t V5_ENTRY_SIZE = 16;
+
+// job(k) for every k in [0, n) on `threads` threads (the caller is one),
+// which take indices from a shared counter. The first exception thrown by a
+// job is rethrown here once all threads have finished.
+template <class F>
+void parallel_for_index(std::size_t n, unsigned threads, F job)
+{
+    std::atomic<std::size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mu;
+    auto run = [&]
+    {
+        for (std::size_t k; (k = next.fetch_add(1, std::memory_order_relaxed)) < n;)
+        {
+            try
+            {
+                job(k);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lk(error_mu);
+                if (!error)
+                    error = std::current_exception();
+                next.store(n, std::memory_order_relaxed); // stop handing out work
+            }
+        }
+    };
+    std::vector<std::thread> ts;
+    for (unsigned t = 1; t < threads && t < n; ++t)
+        ts.emplace_back(run);
+    run();
+    for (auto &t : ts)
+        t.join();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+// count records from record(i) -> WireRecord, chunks encoded and checksummed
+// on `threads` threads, then written in order. record must be safe to call
+// concurrently.
+template <class F>
+void serialize_parallel(std::ostream &os, std::size_t count, F record, unsigned threads,
+                        std::size_t chunk_records = PARALLEL_CHUNK_RECORDS)
+{
+    if (count > static_cast<std::size_t>(INT32_MAX))
+        throw std::runtime_error("too many nodes for s32 next indices");
+    if (chunk_records == 0 || chunk_records > static_cast<std::size_t>(INT32_MAX))
+        throw std::runtime_error("bad chunk size");
+    const std::size_t chunks = (count + chunk_records - 1) / chunk_records;
+    std::vector<std::vector<unsigned char>> bodies(chunks);
+    std::vector<std::uint32_t> crcs(chunks);
+    parallel_for_index(chunks, threads, [&](std::size_t k)
+                       {
+        const std::size_t first = k * chunk_records;
+        const std::size_t m = (count - first < chunk_records) ? count - first : chunk_records;
+        encode_compact_range(record, first, m, count, bodies[k]);
+        crcs[k] = crc32c(bodies[k].data(), bodies[k].size()); });
+
+    std::vector<unsigned char> h(V5_HEADER_SIZE + V5_ENTRY_SIZE * chunks);
+    std::memcpy(h.data(), MAGIC, 4);
+    store_u32_le(&h[4], VERSION_PARALLEL);
+    store_u32_le(&h[8], static_cast<std::uint32_t>(count));
+    store_u32_le(&h[12], static_cast<std::uint32_t>(chunk_records));
+    store_u32_le(&h[16], static_cast<std::uint32_t>(chunks));
+    std::uint64_t offset = h.size();
+    for (std::size_t k = 0; k < chunks; ++k)
+    {
+        unsigned char *e = &h[V5_HEADER_SIZE + V5_ENTRY_SIZE * k];
+        store_u64_le(e, offset);
+        store_u32_le(e + 8, static_cast<std::uint32_t>(bodies[k].size()));
+        store_u32_le(e + 12, crcs[k]);
+        offset += bodies[k].size();
+    }
+    store_u32_le(&h[20], crc32c(h.data() + V5_HEADER_SIZE, h.size() - V5_HEADER_SIZE));
+
+    os.write(reinterpret_cast<const char *>(h.data()), static_cast<std::streamsize>(h.size()));
+    for (const std::vector<unsigned char> &b : bodies)
+        os.write(reinterpret_cast<const char *>(b.data()), static_cast<std::streamsize>(b.size()));
+    if (!os)
+        throw std::runtime_error("write chunks failed");
+}
+
+inline void serialize_list_parallel(Node *head, std::ostream &os, unsigned threads)
+{
+    const Linearized lin = linearize(head);
+    serialize_parallel(os, lin.order.size(), [&](std::size_t i)
+                       { return lin.record(i); }, threads);
+}
+
+// A v5 file, mapped (or any v5 bytes in memory). Construction reads the
+// header and the offset table, checks the table's CRC and that every chunk
+// lies inside the data; chunk bodies are only touched by verify()/decode().
+class ParallelSnapshot
+{
+public:
+    explicit ParallelSnapshot(const std::string &path) : file_(path) { parse(file_.data(), file_.size()); }
+
+    // Not owning: data must outlive the snapshot.
+    ParallelSnapshot(const unsigned char *data, std::size_t size) { parse(data, size); }
+
+    std::size_t size() const noexcept { return count_; }
+    std::size_t chunks() const noexcept { return table_.size(); }
+
+    bool chunk_ok(std::size_t k) const
+    {
+        const Entry &e = table_[k];
+        return crc32c(data_ + e.offset, e.bytes) == e.crc;
+    }
+
+    // Indices of chunks whose CRC does not match, in order.
+    std::vector<std::size_t> verify(unsigned threads) const
+    {
+        std::vector<unsigned char> bad(table_.size(), 0);
+        parallel_for_index(table_.size(), threads, [&](std::size_t k)
+                           { bad[k] = !chunk_ok(k); });
+        std::vector<std::size_t> out;
+        for (std::size_t k = 0; k < bad.size(); ++k)
+            if (bad[k])
+                out.push_back(k);
+        return out;
+    }
+
+    // Chunk k's records: on_block(first index, const WireRecord *, n).
+    // Does not check the CRC.
+    template <class F>
+    void decode_chunk(std::size_t k, F on_block) const
+    {
+        const Entry &e = table_[k];
+        const std::size_t first = k * chunk_records_;
+        const std::size_t m = (count_ - first < chunk_records_) ? count_ - first : chunk_records_;
+        decode_compact_range(data_ + e.offset, data_ + e.offset + e.bytes, first, m, count_, on_block);
+    }
+
+    // The whole list; each thread checks a chunk's CRC, then decodes it into
+    // its slice of the nodes. Throws naming the first bad chunk found.
+    List decode(unsigned threads) const
+    {
+        List out;
+        out.nodes.resize(count_);
+        Node *nodes = out.nodes.data();
+        parallel_for_index(table_.size(), threads, [&](std::size_t k)
+                           {
+            if (!chunk_ok(k))
+                throw std::runtime_error("chunk " + std::to_string(k) + ": checksum mismatch");
+            decode_chunk(k, [&](std::size_t base, const WireRecord *r, std::size_t m)
+                         {
+                for (std::size_t j = 0; j < m; ++j)
+                {
+                    nodes[base + j].id = static_cast<int>(r[j].id);
+                    nodes[base + j].next = r[j].next >= 0 ? nodes + r[j].next : nullptr;
+                } }); });
+        return out;
+    }
+
+private:
+    struct Entry
+    {
+        std::size_t offset;
+        std::size_t bytes;
+        std::uint32_t crc;
+    };
+
+    void parse(const unsigned char *data, std::size_t size)
+    {
+        if (size < V5_HEADER_SIZE || std::memcmp(data, MAGIC, 4) != 0)
+            throw std::runtime_error("bad magic");
+        check_version(load_u32_le(data + 4), VERSION_PARALLEL);
+        count_ = load_u32_le(data + 8);
+        chunk_records_ = load_u32_le(data + 12);
+        const std::size_t chunks = load_u32_le(data + 16);
+        if (count_ > static_cast<std::size_t>(INT32_MAX) || chunk_records_ == 0 ||
+            chunks != (count_ + chunk_records_ - 1) / chunk_records_)
+            throw std::runtime_error("bad v5 header");
+        if ((size - V5_HEADER_SIZE) / V5_ENTRY_SIZE < chunks)
+            throw std::runtime_error("truncated v5 table");
+        if (crc32c(data + V5_HEADER_SIZE, V5_ENTRY_SIZE * chunks) != load_u32_le(data + 20))
+            throw std::runtime_error("v5 table: checksum mismatch");
+
+        table_.resize(chunks);
+        for (std::size_t k = 0; k < chunks; ++k)
+        {
+            const unsigned char *e = data + V5_HEADER_SIZE + V5_ENTRY_SIZE * k;
+            const std::uint64_t offset = load_u64_le(e);
+            const std::uint64_t bytes = load_u32_le(e + 8);
+            if (offset > size || bytes > size - offset)
+                throw std::runtime_error("chunk " + std::to_string(k) + " outside the file");
+            table_[k] = Entry{static_cast<std::size_t>(offset), static_cast<std::size_t>(bytes), load_u32_le(e + 12)};
+        }
+        data_ = data;
+    }
+
+    MappedFile file_; // empty for the in-memory constructor
+    const unsigned char *data_ = nullptr;
+    std::size_t count_ = 0;
+    std::size_t chunk_records_ = 0;
+    std::vector<Entry> table_;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// ------------------------------ PtrIndexTable ------------------------------
+// Open-addressing map from an object's address to an s32 index, for turning
+// pointers into record indices. One flat array of (key, value) slots with
+// linear probing, kept at most half full; size it up front with the expected
+// count and a whole build is one allocation and no rehash. Fibonacci hashing
+// of the address spreads the low bits that allocation alignment leaves zero.
+// Insert-only: there is no erase.
+template <class T>
+class PtrIndexTable
+{
+public:
+    static const std::int32_t npos = -1;
+
+    explicit PtrIndexTable(std::size_t expected = 0) { rehash(capacity_for(expected)); }
+
+    std::int32_t find(const T *p) const noexcept
+    {
+        for (std::size_t i = home(p);; i = (i + 1) & mask_)
+        {
+            const Slot &s = slots_[i];
+            if (s.key == p)
+                return s.value;
+            if (s.key == nullptr)
+                return npos;
+        }
+    }
+
+    // (index stored for p, true if p was new and now maps to `index`).
+    std::pair<std::int32_t, bool> insert(const T *p, std::int32_t index)
+    {
+        if (2 * (size_ + 1) > slots_.size())
+            rehash(2 * slots_.size());
+        for (std::size_t i = home(p);; i = (i + 1) & mask_)
+        {
+            Slot &s = slots_[i];
+            if (s.key == p)
+                return std::make_pair(s.value, false);
+            if (s.key == nullptr)
+            {
+                s.key = p;
+                s.value = index;
+                ++size_;
+                return std::make_pair(index, true);
+            }
+        }
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    std::size_t capacity() const noexcept { return slots_.size(); }
+
+private:
+    struct Slot
+    {
+        const T *key = nullptr; // nullptr: empty
+        std::int32_t value = npos;
+    };
+
+    static std::size_t capacity_for(std::size_t expected)
+    {
+        std::size_t cap = 16;
+        while (cap < 2 * expected)
+            cap *= 2;
+        return cap;
+    }
+
+    std::size_t home(const T *p) const noexcept
+    {
+        const std::uint64_t x = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(p));
+        return static_cast<std::size_t>((x * 0x9E3779B97F4A7C15ull) >> shift_);
+    }
+
+    void rehash(std::size_t cap)
+    {
+        std::vector<Slot> old(cap);
+        old.swap(slots_);
+        mask_ = cap - 1;
+        shift_ = 64;
+        for (std::size_t c = cap; c > 1; c >>= 1)
+            --shift_;
+        size_ = 0;
+        for (const Slot &s : old)
+            if (s.key != nullptr)
+                insert(s.key, s.value);
+    }
+
+    std::vector<Slot> slots_;
+    std::size_t mask_ = 0;
+    unsigned shift_ = 64;
+    std::size_t size_ = 0;
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <vector>
+
+#include "NodeFormat.hpp"
+
+// ---------------- Streaming v1 readers ----------------
+// deserialize_list() sizes everything for the whole file before it links a
+// single node. These read a fixed number of records at a time instead, so
+// work can start on the first chunk while the rest is still arriving:
+//
+//   for_each_record_chunk()  records only, index-based next; memory is one
+//                            chunk buffer whatever the file size.
+//   StreamingList            builds Nodes chunk by chunk with their next
+//                            pointers, and hands each chunk to a callback
+//                            once every pointer in it is final.
+
+// v1 records of `is` in chunks: on_chunk(first index, const WireRecord *, n).
+template <class F>
+std::size_t for_each_record_chunk(std::istream &is, std::size_t chunk_records, F on_chunk)
+{
+    const std::size_t count = read_header_v1(is);
+    read_record_chunks(is, count, chunk_records, on_chunk);
+    return count;
+}
+
+// Nodes live in separately allocated chunks of chunk_nodes (stable addresses,
+// no reallocation while the file grows them). A next that points backwards
+// or into the current chunk is linked at once; a forward one is queued and
+// patched when its target's chunk arrives. A chunk is complete when none of
+// its nodes waits for a patch; completed chunks are delivered in file order,
+// so a list (next = i + 1) delivers chunk k as soon as chunk k + 1 is read.
+class StreamingList
+{
+public:
+    // A completed run of nodes: nodes[0..size) are records first..first+size.
+    struct Chunk
+    {
+        Node *nodes;
+        std::size_t first;
+        std::size_t size;
+    };
+
+    explicit StreamingList(std::size_t chunk_nodes = BULK_CHUNK_RECORDS) : chunk_nodes_(chunk_nodes)
+    {
+        if (chunk_nodes_ == 0)
+            throw std::runtime_error("chunk size must be >= 1");
+    }
+
+    StreamingList(const StreamingList &) = delete;
+    StreamingList &operator=(const StreamingList &) = delete;
+
+    // Reads a v1 stream to the end, replacing any earlier contents and calling
+    // on_chunk(const Chunk &) for each chunk as it completes.
+    template <class F>
+    void read(std::istream &is, F on_chunk)
+    {
+        chunks_.clear();
+        size_ = 0;
+        std::vector<std::size_t> waiting; // per chunk: forward links not yet patched
+        std::priority_queue<Patch> patches;
+        std::size_t delivered = 0;
+
+        for_each_record_chunk(is, chunk_nodes_, [&](std::size_t base, const WireRecord *r, std::size_t m)
+                              {
+            chunks_.emplace_back(new Node[m]);
+            Node *c = chunks_.back().get();
+            const std::size_t k = chunks_.size() - 1;
+            waiting.push_back(0);
+            size_ = base + m;
+
+            for (std::size_t j = 0; j < m; ++j)
+            {
+                c[j].id = static_cast<int>(r[j].id);
+                c[j].next = nullptr;
+                if (r[j].next < 0)
+                    continue;
+                const std::size_t t = static_cast<std::size_t>(r[j].next);
+                if (t >= base && t < size_)
+                    c[j].next = &c[t - base];
+                else if (t < base)
+                    c[j].next = &(*this)[t];
+                else
+                {
+                    patches.push(Patch{t, &c[j], k});
+                    ++waiting[k];
+                }
+            }
+            while (!patches.empty() && patches.top().target < size_)
+            {
+                const Patch p = patches.top();
+                patches.pop();
+                p.from->next = &(*this)[p.target];
+                --waiting[p.chunk];
+            }
+            while (delivered < chunks_.size() && waiting[delivered] == 0)
+            {
+                on_chunk(Chunk{chunks_[delivered].get(), delivered * chunk_nodes_,
+                               delivered + 1 < chunks_.size() ? chunk_nodes_ : m});
+                ++delivered;
+            } });
+        // read_record_chunks() rejects next >= count, so every patch has landed.
+    }
+
+    void read(std::istream &is)
+    {
+        read(is, [](const Chunk &) {});
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    Node *head() noexcept { return size_ == 0 ? nullptr : &chunks_[0][0]; }
+    Node &operator[](std::size_t i) noexcept { return chunks_[i / chunk_nodes_][i % chunk_nodes_]; }
+
+private:
+    struct Patch
+    {
+        std::size_t target; // record index not read yet
+        Node *from;
+        std::size_t chunk; // chunk of `from`
+
+        bool operator<(const Patch &o) const noexcept { return target > o.target; } // min-heap
+    };
+
+    std::size_t chunk_nodes_;
+    std::vector<std::unique_ptr<Node[]>> chunks_;
+    std::size_t size_ = 0;
+};
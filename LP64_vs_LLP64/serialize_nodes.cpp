@@ -1,184 +1,614 @@
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <vector>
+#include <algorithm>
+#include <numeric>
+#include <random>
 #include <unordered_map>
 #include <stdexcept>
 #include <iostream>
+#include <iomanip>
 #include <fstream>
+#include <sstream>
+#include <string>
 #include <cassert>
 
-// ---------------- In-memory node ----------------
-struct Node
-{
-    int id;
-    Node *next;
-};
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "NodeFormat.hpp"
+#include "CompactFormat.hpp"
+#include "NodeGraph.hpp"
+#include "StreamingReader.hpp"
+#include "ParallelFormat.hpp"
+#include "bench/Harness.hpp"
 
-// ---------------- Endian helpers (C++11) ----------------
-inline bool host_is_little_endian()
+// ---------------- Demo / test ----------------
+static void print_list(Node *head, const char *tag)
 {
-    union
+    std::cout << tag << ": ";
+    for (const Node *p = head; p != nullptr; p = p->next)
     {
-        uint16_t u16;
-        unsigned char b[2];
-    } v = {0x0100};
-    return v.b[1] == 0x01; // 0x0001 in memory if LE; here we stored 0x0100, so LE -> [0x00,0x01]
+        std::cout << p->id << (p->next ? " -> " : "");
+    }
+    std::cout << "\n";
 }
 
-inline std::uint32_t bswap32(std::uint32_t x)
+// ---------------- Load-time benchmark ----------------
+// A list of n nodes (id i, next i+1) written record by record, so that 100M
+// nodes don't need a 100M-node list and index map in memory first.
+static void write_synthetic(const char *path, std::uint32_t n, bool mapped)
 {
-    return ((x & 0x000000FFu) << 24) | ((x & 0x0000FF00u) << 8) | ((x & 0x00FF0000u) >> 8) | ((x & 0xFF000000u) >> 24);
+    std::ofstream os(path, std::ios::binary);
+    if (mapped)
+        write_header_v2(os, n, 0);
+    else
+        write_header_v1(os, n);
+    for (std::uint32_t i = 0; i < n; ++i)
+    {
+        write_s32_le(os, static_cast<std::int32_t>(i));
+        write_s32_le(os, i + 1 < n ? static_cast<std::int32_t>(i + 1) : -1);
+    }
 }
 
-inline void write_u32_le(std::ostream &os, std::uint32_t v)
+// Startup cost of each format: v1 streams every field and rebuilds pointers,
+// v2 maps the file. "+walk" adds one traversal summing the ids, i.e. the
+// first pass over the data (for v2 that is where the page faults land).
+// The files were just written, so they are in the page cache; drop it
+// (echo 3 > /proc/sys/vm/drop_caches) between runs to time a cold disk.
+static void run_load_bench(const std::vector<std::uint32_t> &sizes)
 {
-    if (!host_is_little_endian())
-        v = bswap32(v);
-    os.write(reinterpret_cast<const char *>(&v), 4);
-    if (!os)
-        throw std::runtime_error("write_u32_le failed");
+    const char *v1_path = "nodes_v1.bin";
+    const char *v2_path = "nodes_v2.bin";
+    const bench::Options opt = bench::Options::from_env(3, 1);
+    std::cout << "Load time, median ms (page cache warm):\n"
+              << "      nodes   v1 stream  v1 +walk   v2 mmap  v2 +walk\n";
+    for (std::uint32_t n : sizes)
+    {
+        write_synthetic(v1_path, n, false);
+        write_synthetic(v2_path, n, true);
+        const std::uint64_t expect = static_cast<std::uint64_t>(n) * (n - 1) / 2;
+        (void)expect;
+        const std::string tag = "serialize_nodes/load/nodes=" + std::to_string(n);
+
+        auto v1 = [&](bool walk)
+        {
+            std::ifstream ifs(v1_path, std::ios::binary);
+            List l = deserialize_list(ifs);
+            std::uint64_t sum = 0;
+            if (walk)
+            {
+                for (const Node *p = l.head(); p != nullptr; p = p->next)
+                    sum += static_cast<std::uint32_t>(p->id);
+                assert(sum == expect);
+            }
+            bench::do_not_optimize(sum);
+            bench::do_not_optimize(l.nodes.data());
+        };
+        auto v2 = [&](bool walk)
+        {
+            MappedNodes nodes(v2_path);
+            std::uint64_t sum = 0;
+            if (walk)
+            {
+                for (std::int32_t i = nodes.head(); i != MappedNodes::npos;)
+                {
+                    const MappedNodes::Record r = nodes.at(i);
+                    sum += static_cast<std::uint32_t>(r.id);
+                    i = r.next;
+                }
+                assert(sum == expect);
+            }
+            bench::do_not_optimize(sum);
+            bench::do_not_optimize(nodes.head());
+        };
+
+        const bench::Stats v1_load = bench::measure([&]
+                                                    { v1(false); }, opt);
+        const bench::Stats v1_walk = bench::measure([&]
+                                                    { v1(true); }, opt);
+        const bench::Stats v2_open = bench::measure([&]
+                                                    { v2(false); }, opt);
+        const bench::Stats v2_walk = bench::measure([&]
+                                                    { v2(true); }, opt);
+        const double per = static_cast<double>(n);
+        bench::record(tag + "/v1_stream", v1_load, {{"ns_per_node", v1_load.median_ns / per}});
+        bench::record(tag + "/v1_stream_walk", v1_walk, {{"ns_per_node", v1_walk.median_ns / per}});
+        bench::record(tag + "/v2_mmap", v2_open, {{"ns_per_node", v2_open.median_ns / per}});
+        bench::record(tag + "/v2_mmap_walk", v2_walk, {{"ns_per_node", v2_walk.median_ns / per}});
+
+        std::cout << std::setw(11) << n << std::setw(12) << v1_load.median_ms() << std::setw(10)
+                  << v1_walk.median_ms() << std::setw(10) << v2_open.median_ms() << std::setw(10)
+                  << v2_walk.median_ms() << "\n";
+    }
+    std::remove(v1_path);
+    std::remove(v2_path);
 }
 
-inline std::uint32_t read_u32_le(std::istream &is)
+// ---------------- Stream vs bulk I/O benchmark ----------------
+// v1 encode and decode of an n-node list through a file, per-field stream
+// calls vs the chunked bulk path. The list is linearized once up front so
+// both encoders are timed on the I/O part alone.
+static void run_io_bench(std::uint32_t n)
 {
-    std::uint32_t v = 0;
-    is.read(reinterpret_cast<char *>(&v), 4);
-    if (!is)
-        throw std::runtime_error("read_u32_le failed");
-    if (!host_is_little_endian())
-        v = bswap32(v);
-    return v;
+    const char *path = "nodes_io.bin";
+    std::vector<Node> nodes(n);
+    for (std::uint32_t i = 0; i < n; ++i)
+    {
+        nodes[i].id = static_cast<int>(i);
+        nodes[i].next = (i + 1 < n) ? &nodes[i + 1] : nullptr;
+    }
+    const Linearized lin = linearize(&nodes[0]);
+    const double mb = (12.0 + 8.0 * n) / 1e6;
+    const bench::Options opt = bench::Options::from_env(3, 1);
+    const std::string tag = "serialize_nodes/io/nodes=" + std::to_string(n);
+
+    auto encode = [&](bool bulk)
+    {
+        std::ofstream os(path, std::ios::binary);
+        write_header_v1(os, n);
+        if (bulk)
+            write_records_bulk(lin, os);
+        else
+            write_records(lin, os);
+    };
+    auto decode = [&](bool bulk)
+    {
+        std::ifstream is(path, std::ios::binary);
+        List l = bulk ? deserialize_list_bulk(is) : deserialize_list(is);
+        assert(l.nodes.size() == n && l.nodes[n - 1].id == static_cast<int>(n - 1));
+        assert(n < 2 || l.nodes[0].next == &l.nodes[1]);
+        bench::do_not_optimize(l.nodes.data());
+    };
+
+    std::cout << "v1 I/O, " << n << " nodes (" << mb << " MB), MB/s (median):\n";
+    auto report = [&](const char *name, const bench::Stats &st)
+    {
+        const double mbps = mb / (st.median_ns / 1e9);
+        bench::record(tag + "/" + name, st, {{"mb_per_s", mbps}});
+        std::cout << "  " << std::left << std::setw(14) << name << std::right << std::setw(10) << mbps
+                  << " MB/s  (" << st.median_ms() << " ms)\n";
+    };
+    report("encode/stream", bench::measure([&]
+                                           { encode(false); }, opt));
+    report("encode/bulk", bench::measure([&]
+                                         { encode(true); }, opt));
+    report("decode/stream", bench::measure([&]
+                                           { decode(false); }, opt));
+    report("decode/bulk", bench::measure([&]
+                                         { decode(true); }, opt));
+    std::remove(path);
 }
 
-// Signed 32-bit via unsigned transport
-inline void write_s32_le(std::ostream &os, std::int32_t s)
+// ---------------- Pointer -> index benchmark ----------------
+// The index shape serialize_list used before: std::unordered_map, not reserved.
+struct UnorderedMapIndex
 {
-    write_u32_le(os, static_cast<std::uint32_t>(s));
-}
-inline std::int32_t read_s32_le(std::istream &is)
+    std::unordered_map<const Node *, std::int32_t> map;
+
+    std::pair<std::int32_t, bool> insert(const Node *p, std::int32_t i)
+    {
+        const auto r = map.emplace(p, i);
+        return std::make_pair(r.first->second, r.second);
+    }
+};
+
+// Discards everything written, so only encoding is timed.
+struct NullBuf : std::streambuf
 {
-    return static_cast<std::int32_t>(read_u32_le(is));
+    std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+    int overflow(int c) override { return traits_type::not_eof(c); }
+};
+
+// n nodes in one vector, linked in a random order (so successive nodes are
+// far apart in memory, as on a heap), the last one pointing back to the
+// middle of the chain; a second root enters the chain at a shared node.
+static void run_graph_bench(std::uint32_t n)
+{
+    std::vector<Node> arena(n);
+    std::vector<std::uint32_t> perm(n);
+    std::iota(perm.begin(), perm.end(), 0u);
+    std::shuffle(perm.begin(), perm.end(), std::mt19937(42));
+    for (std::uint32_t k = 0; k < n; ++k)
+    {
+        Node &nd = arena[perm[k]];
+        nd.id = static_cast<int>(k);
+        nd.next = &arena[perm[k + 1 < n ? k + 1 : n / 2]];
+    }
+    const std::vector<Node *> roots = {&arena[perm[0]], &arena[perm[n / 3]]};
+
+    const bench::Options opt = bench::Options::from_env(3, 1);
+    const std::string tag = "serialize_nodes/graph/nodes=" + std::to_string(n);
+    const double per = static_cast<double>(n);
+    NullBuf null_buf;
+    std::ostream null_os(&null_buf);
+
+    auto map_index = [&]
+    {
+        UnorderedMapIndex index;
+        return linearize_graph_with(roots, index);
+    };
+    auto table_index = [&]
+    { return linearize_graph(roots, n); };
+
+    assert(map_index().next == table_index().next);
+    std::cout << "Graph serialization, " << n << " nodes (shuffled chain with a cycle and a shared node), ns per node:\n"
+              << "               index  serialize\n";
+    auto row = [&](const char *name, const bench::Stats &index, const bench::Stats &full)
+    {
+        bench::record(tag + "/" + name + "/index", index, {{"ns_per_node", index.median_ns / per}});
+        bench::record(tag + "/" + name + "/serialize", full, {{"ns_per_node", full.median_ns / per}});
+        std::cout << "  " << std::left << std::setw(12) << name << std::right << std::setw(7)
+                  << index.median_ns / per << std::setw(11) << full.median_ns / per << "\n";
+    };
+    row("unordered_map",
+        bench::measure([&]
+                       { bench::do_not_optimize(map_index().next.data()); }, opt),
+        bench::measure([&]
+                       { write_graph(map_index(), null_os); }, opt));
+    row("open-address",
+        bench::measure([&]
+                       { bench::do_not_optimize(table_index().next.data()); }, opt),
+        bench::measure([&]
+                       { serialize_graph(roots, null_os, n); }, opt));
+    // The arena path has no separate index step: each next is converted while writing.
+    const bench::Stats arena_full = bench::measure([&]
+                                                   { serialize_graph_arena(arena, roots, null_os); }, opt);
+    bench::record(tag + "/arena/serialize", arena_full, {{"ns_per_node", arena_full.median_ns / per}});
+    std::cout << "  " << std::left << std::setw(12) << "arena" << std::right << std::setw(7) << "-"
+              << std::setw(11) << arena_full.median_ns / per << "\n";
 }
 
-// ---------------- Wire format magic/version ----------------
-static const unsigned char MAGIC[4] = {'N', 'D', 'L', 'S'};
-static const std::uint32_t VERSION = 1;
+// ---------------- Streaming load benchmark ----------------
+// Peak resident memory of one call, above what was resident before it:
+// /proc/self/clear_refs "5" resets VmHWM to the current RSS (Linux >= 4.0).
+// -1 where that is not available. Freed heap pages are handed back first
+// (malloc_trim), or earlier runs' blocks would be reused without showing up.
+static long read_status_kb(const char *field)
+{
+    std::ifstream st("/proc/self/status");
+    std::string line;
+    const std::size_t len = std::strlen(field);
+    while (std::getline(st, line))
+        if (line.compare(0, len, field) == 0)
+            return std::strtol(line.c_str() + len, nullptr, 10);
+    return -1;
+}
 
-// ---------------- Serializer ----------------
-// Serializes the list reachable from 'head' (duplicates not removed).
-void serialize_list(Node *head, std::ostream &os)
+template <class F>
+static long peak_extra_kb(F &&f)
 {
-    // 1) Linearize nodes and assign indices
-    std::vector<Node *> order;
-    std::unordered_map<Node *, std::int32_t> index; // Node* -> index
-    for (Node *p = head; p != nullptr; p = p->next)
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
     {
-        index[p] = static_cast<std::int32_t>(order.size());
-        order.push_back(p);
+        std::ofstream clear("/proc/self/clear_refs");
+        clear << "5";
     }
+    const long base = read_status_kb("VmRSS:");
+    f();
+    const long peak = read_status_kb("VmHWM:");
+    return (base < 0 || peak < 0) ? -1 : peak - base;
+}
 
-    // 2) Header
-    os.write(reinterpret_cast<const char *>(MAGIC), 4);
-    if (!os)
-        throw std::runtime_error("write magic failed");
-    write_u32_le(os, VERSION);
-    write_u32_le(os, static_cast<std::uint32_t>(order.size()));
+// Time to a usable list, time until the first chunk could be handed on, and
+// peak extra memory, for each v1 reader.
+static void run_stream_bench(std::uint32_t n)
+{
+    const char *path = "nodes_stream.bin";
+    write_synthetic(path, n, false);
+    const bench::Options opt = bench::Options::from_env(3, 1);
+    const std::string tag = "serialize_nodes/stream/nodes=" + std::to_string(n);
+    const std::uint64_t expect = static_cast<std::uint64_t>(n) * (n - 1) / 2;
+    (void)expect;
 
-    // 3) Body
-    for (std::size_t i = 0; i < order.size(); ++i)
+    std::cout << "v1 load, " << n << " nodes, " << BULK_CHUNK_RECORDS << "-record chunks:\n"
+              << "  reader              total ms  first chunk ms  peak extra MB\n";
+    auto row = [&](const char *name, auto load)
     {
-        Node *p = order[i];
+        double first_ns = 0;
+        auto once = [&]
+        {
+            std::ifstream is(path, std::ios::binary);
+            const std::uint64_t t0 = bench::now_ns();
+            load(is, [&]
+                 { if (first_ns == 0) first_ns = static_cast<double>(bench::now_ns() - t0); });
+        };
+        const bench::Stats st = bench::measure([&]
+                                               { first_ns = 0; once(); }, opt);
+        first_ns = 0;
+        const long kb = peak_extra_kb(once);
+        const double first_ms = (first_ns > 0 ? first_ns : st.median_ns) / 1e6;
+        bench::record(tag + "/" + name, st, {{"first_chunk_ms", first_ms}, {"peak_extra_kb", static_cast<double>(kb)}});
+        std::cout << "  " << std::left << std::setw(18) << name << std::right << std::setw(10) << st.median_ms()
+                  << std::setw(16) << first_ms << std::setw(15);
+        if (kb >= 0)
+            std::cout << kb / 1024.0;
+        else
+            std::cout << "n/a";
+        std::cout << "\n";
+    };
 
-        // id must fit s32 on the wire
-        if (p->id < INT32_MIN || p->id > INT32_MAX)
-            throw std::runtime_error("id out of s32 range for wire format");
+    // Whole-file readers: nothing is usable before they return.
+    row("deserialize_list", [&](std::istream &is, auto)
+        {
+        List l = deserialize_list(is);
+        bench::do_not_optimize(l.nodes.data()); });
+    row("bulk", [&](std::istream &is, auto)
+        {
+        List l = deserialize_list_bulk(is);
+        bench::do_not_optimize(l.nodes.data()); });
+    row("StreamingList", [&](std::istream &is, auto first)
+        {
+        StreamingList l;
+        std::uint64_t sum = 0;
+        l.read(is, [&](const StreamingList::Chunk &c)
+               {
+            first();
+            for (std::size_t j = 0; j < c.size; ++j)
+                sum += static_cast<std::uint32_t>(c.nodes[j].id); });
+        assert(sum == expect && l.size() == n);
+        bench::do_not_optimize(sum); });
+    row("records only", [&](std::istream &is, auto first)
+        {
+        std::uint64_t sum = 0;
+        for_each_record_chunk(is, BULK_CHUNK_RECORDS, [&](std::size_t, const WireRecord *r, std::size_t m)
+                              {
+            first();
+            for (std::size_t j = 0; j < m; ++j)
+                sum += static_cast<std::uint32_t>(r[j].id); });
+        assert(sum == expect);
+        bench::do_not_optimize(sum); });
+    std::remove(path);
+}
 
-        std::int32_t id = static_cast<std::int32_t>(p->id);
-        std::int32_t nextIndex = -1;
-        if (p->next)
+// ---------------- Compact format benchmark ----------------
+// Reads from a buffer in place (istringstream would copy it first).
+struct MemBuf : std::streambuf
+{
+    MemBuf(const std::string &s)
+    {
+        char *p = const_cast<char *>(s.data());
+        setg(p, p, p + s.size());
+    }
+};
+
+// records 0..n-1 of one shape: 0 sequential (id i, next i + 1), 1 snapshot
+// (ids increasing with occasional gaps, 1 in 256 next elsewhere), 2 random.
+static void fill_records(std::vector<WireRecord> &recs, int shape, std::mt19937 &rng)
+{
+    const std::uint32_t n = static_cast<std::uint32_t>(recs.size());
+    std::uint32_t id = 0;
+    for (std::uint32_t i = 0; i < n; ++i)
+    {
+        std::int32_t next = (i + 1 < n) ? static_cast<std::int32_t>(i + 1) : -1;
+        if (shape == 0)
+            id = i;
+        else if (shape == 1)
         {
-            // If next wasn't encountered in linearization, we’d need a full graph pass.
-            // For a singly-linked list traversed from head, it will be encountered.
-            std::unordered_map<Node *, std::int32_t>::const_iterator it = index.find(p->next);
-            if (it == index.end())
-            {
-                // Fallback: assign new index? For strict lists this shouldn't happen.
-                throw std::runtime_error("Encountered next pointer not in index map");
-            }
-            nextIndex = it->second;
+            id += 1 + ((rng() & 7) == 0 ? rng() % 100 : 0);
+            if ((rng() & 255) == 0)
+                next = static_cast<std::int32_t>(rng() % n);
         }
-
-        write_s32_le(os, id);
-        write_s32_le(os, nextIndex);
+        else
+        {
+            id = static_cast<std::uint32_t>(rng());
+            next = static_cast<std::int32_t>(rng() % n);
+        }
+        recs[i] = WireRecord{static_cast<std::int32_t>(id), next};
     }
 }
 
-// ---------------- Owning container for a deserialized list ----------------
-struct List
+// Size and record decode speed of v1 vs v4 on three shapes of data. GB/s is
+// decoded record bytes (8 per node) per second, from memory.
+static void run_compact_bench(std::uint32_t n)
 {
-    std::vector<Node> nodes; // owns storage
-    Node *head() { return nodes.empty() ? nullptr : &nodes[0]; }
-};
+    std::mt19937 rng(7);
+    std::vector<WireRecord> recs(n);
+    const bench::Options opt = bench::Options::from_env(3, 1);
+    const double out_gb = 8.0 * n / 1e9;
 
-// ---------------- Deserializer ----------------
-List deserialize_list(std::istream &is)
-{
-    // 1) Header
-    unsigned char magic[4] = {0, 0, 0, 0};
-    is.read(reinterpret_cast<char *>(magic), 4);
-    if (!is)
-        throw std::runtime_error("read magic failed");
-    if (!(magic[0] == MAGIC[0] && magic[1] == MAGIC[1] && magic[2] == MAGIC[2] && magic[3] == MAGIC[3]))
-        throw std::runtime_error("bad magic");
+    std::cout << "v1 vs v4 (compact), " << n << " nodes; decode GB/s of records:\n"
+              << "  shape         v1 MB    v4 MB  ratio  v1 GB/s  v4 GB/s  v4 encode ms\n";
+    for (int shape = 0; shape < 3; ++shape)
+    {
+        static const char *const names[] = {"sequential", "snapshot", "random"};
+        fill_records(recs, shape, rng);
+        auto record = [&](std::size_t i)
+        { return recs[i]; };
 
-    std::uint32_t version = read_u32_le(is);
-    if (version != VERSION)
-        throw std::runtime_error("unsupported version");
+        std::ostringstream v1os, v4os;
+        write_header_v1(v1os, n);
+        write_records_chunked(v1os, n, record);
+        const bench::Stats enc = bench::measure([&]
+                                                {
+            std::ostringstream os;
+            write_compact(os, n, record);
+            v4os.swap(os); }, opt);
+        const std::string v1 = v1os.str(), v4 = v4os.str();
 
-    std::uint32_t count = read_u32_le(is);
+        // Both decoders must give back the records they were given.
+        auto check = [&](std::size_t base, const WireRecord *r, std::size_t m)
+        {
+            for (std::size_t j = 0; j < m; ++j)
+                if (r[j].id != recs[base + j].id || r[j].next != recs[base + j].next)
+                    throw std::runtime_error("decode mismatch");
+        };
+        auto decode_v1 = [&](auto on_chunk)
+        {
+            MemBuf mb(v1);
+            std::istream is(&mb);
+            read_record_chunks(is, read_header_v1(is), BULK_CHUNK_RECORDS, on_chunk);
+        };
+        auto decode_v4 = [&](auto on_block)
+        {
+            MemBuf mb(v4);
+            std::istream is(&mb);
+            check_version(read_magic_version(is), VERSION_COMPACT);
+            read_compact_blocks(is, read_header_compact(is), on_block);
+        };
+        decode_v1(check);
+        decode_v4(check);
+
+        std::uint64_t sink = 0;
+        auto consume = [&](std::size_t, const WireRecord *r, std::size_t m)
+        {
+            for (std::size_t j = 0; j < m; ++j)
+                sink += static_cast<std::uint32_t>(r[j].id) + static_cast<std::uint32_t>(r[j].next);
+        };
+        const bench::Stats d1 = bench::measure([&]
+                                               { decode_v1(consume); }, opt);
+        const bench::Stats d4 = bench::measure([&]
+                                               { decode_v4(consume); }, opt);
+        bench::do_not_optimize(sink);
 
-    // 2) Reserve & temp next indices
-    List out;
-    out.nodes.resize(count);
-    std::vector<std::int32_t> nextIdx(count, -1);
+        const double gb1 = out_gb / (d1.median_ns / 1e9), gb4 = out_gb / (d4.median_ns / 1e9);
+        const std::string tag = std::string("serialize_nodes/compact/nodes=") + std::to_string(n) + "/" + names[shape];
+        bench::record(tag + "/v1_decode", d1, {{"bytes", static_cast<double>(v1.size())}, {"gb_per_s", gb1}});
+        bench::record(tag + "/v4_decode", d4, {{"bytes", static_cast<double>(v4.size())}, {"gb_per_s", gb4}});
+        bench::record(tag + "/v4_encode", enc, {{"bytes", static_cast<double>(v4.size())}});
+        std::cout << "  " << std::left << std::setw(11) << names[shape] << std::right << std::setw(8)
+                  << v1.size() / 1e6 << std::setw(9) << v4.size() / 1e6 << std::setw(7)
+                  << static_cast<double>(v1.size()) / static_cast<double>(v4.size()) << std::setw(9) << gb1
+                  << std::setw(9) << gb4 << std::setw(14) << enc.median_ms() << "\n";
+    }
+}
+
+// ---------------- Parallel format benchmark ----------------
+// v5 encode (into a NullBuf), verify and decode of snapshot-shaped records on
+// 1, 2, 4, ... threads up to max_threads, from memory. Speedup is against the
+// 1-thread row.
+static void run_parallel_bench(std::uint32_t n, unsigned max_threads)
+{
+    std::mt19937 rng(7);
+    std::vector<WireRecord> recs(n);
+    fill_records(recs, 1, rng);
+    auto record = [&](std::size_t i)
+    { return recs[i]; };
+    const bench::Options opt = bench::Options::from_env(3, 1);
 
-    // 3) Read nodes (ids & next indices)
-    for (std::uint32_t i = 0; i < count; ++i)
+    std::string bytes;
     {
-        std::int32_t id = read_s32_le(is);
-        std::int32_t nxt = read_s32_le(is);
-        out.nodes[i].id = static_cast<int>(id);
-        out.nodes[i].next = nullptr; // link later
-        nextIdx[i] = nxt;
+        std::ostringstream os;
+        serialize_parallel(os, n, record, max_threads);
+        bytes = os.str();
+    }
+    const ParallelSnapshot snap(reinterpret_cast<const unsigned char *>(bytes.data()), bytes.size());
+    {
+        const List l = snap.decode(max_threads);
+        for (std::size_t i = 0; i < n; ++i)
+            if (l.nodes[i].id != recs[i].id ||
+                l.nodes[i].next != (recs[i].next >= 0 ? &l.nodes[static_cast<std::size_t>(recs[i].next)] : nullptr))
+                throw std::runtime_error("decode mismatch");
     }
 
-    // 4) Rebuild pointers
-    for (std::uint32_t i = 0; i < count; ++i)
+    std::cout << "v5 (parallel), " << n << " nodes, " << snap.chunks() << " chunks, " << bytes.size() / 1e6
+              << " MB, CRC32C " << (crc32c_hardware() ? "hardware" : "software") << ":\n"
+              << "  threads  encode ms  (x)  verify ms  (x)  decode ms  (x)\n";
+    double base[3] = {0, 0, 0};
+    for (unsigned t = 1;; t = (t * 2 < max_threads) ? t * 2 : max_threads)
     {
-        if (nextIdx[i] >= 0)
+        const bench::Stats enc = bench::measure([&]
+                                                {
+            NullBuf nb;
+            std::ostream os(&nb);
+            serialize_parallel(os, n, record, t); }, opt);
+        const bench::Stats ver = bench::measure([&]
+                                                {
+            const std::vector<std::size_t> bad = snap.verify(t);
+            if (!bad.empty())
+                throw std::runtime_error("verify failed"); }, opt);
+        const bench::Stats dec = bench::measure([&]
+                                                {
+            List l = snap.decode(t);
+            bench::do_not_optimize(l.nodes.data()); }, opt);
+
+        const bench::Stats *st[3] = {&enc, &ver, &dec};
+        static const char *const names[] = {"encode", "verify", "decode"};
+        std::cout << "  " << std::setw(7) << t;
+        for (int k = 0; k < 3; ++k)
         {
-            std::size_t j = static_cast<std::size_t>(nextIdx[i]);
-            if (j >= out.nodes.size())
-                throw std::runtime_error("next index out of range");
-            out.nodes[i].next = &out.nodes[j];
+            if (t == 1)
+                base[k] = st[k]->median_ns;
+            const double x = base[k] / st[k]->median_ns;
+            bench::record("serialize_nodes/parallel/nodes=" + std::to_string(n) + "/" + names[k] +
+                              "/threads=" + std::to_string(t),
+                          *st[k], {{"speedup", x}});
+            std::cout << std::setw(11) << st[k]->median_ms() << std::setw(5) << x;
         }
+        std::cout << "\n";
+        if (t == max_threads)
+            break;
     }
-
-    return out;
 }
 
-// ---------------- Demo / test ----------------
-static void print_list(Node *head, const char *tag)
+int main(int argc, char **argv)
 {
-    std::cout << tag << ": ";
-    for (const Node *p = head; p != nullptr; p = p->next)
+    // Usage: serialize_nodes              round-trip demo (v1 and v2)
+    //        serialize_nodes bench [nodes...]
+    //        serialize_nodes io [nodes]
+    //        serialize_nodes graph [nodes]
+    //        serialize_nodes stream [nodes]
+    //        serialize_nodes compact [nodes]
+    //        serialize_nodes parallel [nodes] [max_threads]
+    // Defaults: bench 1M and 100M nodes (the 100M files are 800 MB each, v1
+    // loads them into ~2 GB of memory); io, graph, stream and compact 10M nodes;
+    // parallel 100M nodes (~2.7 GB) on up to every allowed CPU.
+    if (argc > 1 && std::strcmp(argv[1], "bench") == 0)
     {
-        std::cout << p->id << (p->next ? " -> " : "");
+        std::vector<std::uint32_t> sizes;
+        for (int i = 2; i < argc; ++i)
+            sizes.push_back(static_cast<std::uint32_t>(std::strtoul(argv[i], nullptr, 10)));
+        if (sizes.empty())
+            sizes = {1000000u, 100000000u};
+        for (std::uint32_t n : sizes)
+            if (n == 0 || n > static_cast<std::uint32_t>(INT32_MAX))
+            {
+                std::cerr << "node counts must be in 1.." << INT32_MAX << "\n";
+                return 1;
+            }
+        std::cout << std::fixed << std::setprecision(3);
+        run_load_bench(sizes);
+        return 0;
+    }
+    if (argc > 1 && (std::strcmp(argv[1], "io") == 0 || std::strcmp(argv[1], "graph") == 0 ||
+                     std::strcmp(argv[1], "stream") == 0 || std::strcmp(argv[1], "compact") == 0))
+    {
+        const unsigned long n = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 10000000ul;
+        if (n < 3 || n > static_cast<unsigned long>(INT32_MAX))
+        {
+            std::cerr << "node count must be in 3.." << INT32_MAX << "\n";
+            return 1;
+        }
+        std::cout << std::fixed << std::setprecision(1);
+        if (argv[1][0] == 'i')
+            run_io_bench(static_cast<std::uint32_t>(n));
+        else if (argv[1][0] == 'g')
+            run_graph_bench(static_cast<std::uint32_t>(n));
+        else if (argv[1][1] == 't')
+            run_stream_bench(static_cast<std::uint32_t>(n));
+        else
+            run_compact_bench(static_cast<std::uint32_t>(n));
+        return 0;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "parallel") == 0)
+    {
+        const unsigned long n = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 100000000ul;
+        const unsigned long cpus = static_cast<unsigned long>(bench::allowed_cpus().size());
+        const unsigned long threads = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : (cpus > 0 ? cpus : 1);
+        if (n < 3 || n > static_cast<unsigned long>(INT32_MAX) || threads < 1 || threads > 1024)
+        {
+            std::cerr << "node count must be in 3.." << INT32_MAX << ", threads in 1..1024\n";
+            return 1;
+        }
+        std::cout << std::fixed << std::setprecision(1);
+        run_parallel_bench(static_cast<std::uint32_t>(n), static_cast<unsigned>(threads));
+        return 0;
     }
-    std::cout << "\n";
-}
 
-int main()
-{
     // Build a simple list: 10 -> 20 -> 30
     Node n3{30, nullptr};
     Node n2{20, &n3};
@@ -211,5 +641,186 @@ int main()
     assert(roundtrip.nodes[2].next == nullptr);
 
     std::cout << "Round-trip OK\n";
+
+    // Same list in the v2 layout, read in place through a mapping
+    {
+        std::ofstream ofs("list_v2.bin", std::ios::binary);
+        serialize_list_v2(&n1, ofs);
+    }
+    {
+        MappedNodes mapped("list_v2.bin");
+        std::cout << "Mapped v2: ";
+        for (std::int32_t i = mapped.head(); i != MappedNodes::npos; i = mapped.at(i).next)
+            std::cout << mapped.at(i).id << (mapped.at(i).next != MappedNodes::npos ? " -> " : "");
+        std::cout << "\n";
+        assert(mapped.size() == 3);
+        assert(mapped.head() == 0);
+        assert(mapped[0].id == 10 && mapped[0].next == 1);
+        assert(mapped[1].id == 20 && mapped[1].next == 2);
+        assert(mapped[2].id == 30 && mapped[2].next == MappedNodes::npos);
+        (void)mapped;
+    }
+    std::cout << "Mapped v2 OK\n";
+
+    // Bulk path: same bytes, same list
+    {
+        std::ostringstream a, b;
+        serialize_list(&n1, a);
+        serialize_list_bulk(&n1, b);
+        assert(a.str() == b.str());
+        std::istringstream is(b.str());
+        List bulk = deserialize_list_bulk(is);
+        assert(bulk.nodes.size() == 3 && bulk.nodes[2].id == 30);
+        assert(bulk.nodes[0].next == &bulk.nodes[1] && bulk.nodes[2].next == nullptr);
+        (void)bulk;
+    }
+    std::cout << "Bulk round-trip OK\n";
+
+    // Graph: 1 -> 2 -> 3 -> 4 -> (back to 2), and 5 -> 3 sharing the tail;
+    // roots {1, 5, 1}. The list serializer refuses the cycle.
+    {
+        std::vector<Node> arena(5);
+        for (int i = 0; i < 5; ++i)
+            arena[static_cast<std::size_t>(i)].id = i + 1;
+        arena[0].next = &arena[1];
+        arena[1].next = &arena[2];
+        arena[2].next = &arena[3];
+        arena[3].next = &arena[1];
+        arena[4].next = &arena[2];
+        const std::vector<Node *> roots = {&arena[0], &arena[4], &arena[0]};
+
+        bool refused = false;
+        try
+        {
+            std::ostringstream os;
+            serialize_list(&arena[0], os);
+        }
+        catch (const std::runtime_error &)
+        {
+            refused = true;
+        }
+        assert(refused);
+        (void)refused;
+
+        for (int arena_path = 0; arena_path < 2; ++arena_path)
+        {
+            std::ostringstream os;
+            if (arena_path)
+                serialize_graph_arena(arena, roots, os);
+            else
+                serialize_graph(roots, os);
+            std::istringstream is(os.str());
+            Graph g = deserialize_graph(is);
+            assert(g.nodes.size() == 5 && g.roots.size() == 3);
+            Node *a = g.roots[0], *e = g.roots[1];
+            assert(g.roots[2] == a && a->id == 1 && e->id == 5);
+            assert(a->next->id == 2 && a->next->next->id == 3 && a->next->next->next->id == 4);
+            assert(a->next->next->next->next == a->next); // cycle kept
+            assert(e->next == a->next->next);             // shared node kept
+            (void)a;
+            (void)e;
+        }
+    }
+    std::cout << "Graph round-trip OK\n";
+
+    // Streaming, one record per chunk, records stored out of list order:
+    // [10 -> rec 2] [30] [20 -> rec 1]. Chunk 0 waits for a forward link.
+    {
+        std::ostringstream os;
+        write_header_v1(os, 3);
+        const std::int32_t recs[] = {10, 2, 30, -1, 20, 1};
+        for (std::int32_t v : recs)
+            write_s32_le(os, v);
+        std::istringstream is(os.str());
+        StreamingList sl(1);
+        std::vector<std::size_t> order;
+        sl.read(is, [&](const StreamingList::Chunk &c)
+                {
+            assert(c.size == 1);
+            order.push_back(c.first); });
+        assert((order == std::vector<std::size_t>{0, 1, 2}));
+        print_list(sl.head(), "Streamed");
+        assert(sl.size() == 3 && sl.head()->id == 10);
+        assert(sl.head()->next == &sl[2] && sl[2].next == &sl[1] && sl[1].next == nullptr);
+    }
+    std::cout << "Streaming OK\n";
+
+    // Compact (v4): same list back, also through the version dispatch; a
+    // block whose next is not sequential, and a v1 file read the same way.
+    {
+        std::ostringstream os;
+        serialize_list_compact(&n1, os);
+        std::istringstream is(os.str());
+        List c = deserialize_list_any(is);
+        print_list(c.head(), "Compact");
+        assert(c.nodes.size() == 3 && c.nodes[1].id == 20 && c.nodes[1].next == &c.nodes[2]);
+
+        std::ostringstream os2;
+        const WireRecord recs[] = {{-5, 2}, {7, -1}, {1000000, 1}};
+        write_compact(os2, 3, [&](std::size_t i)
+                      { return recs[i]; });
+        std::istringstream is2(os2.str());
+        List d = deserialize_list_compact(is2);
+        assert(d.nodes[0].id == -5 && d.nodes[0].next == &d.nodes[2]);
+        assert(d.nodes[2].id == 1000000 && d.nodes[2].next == &d.nodes[1] && d.nodes[1].next == nullptr);
+
+        std::ostringstream v1;
+        serialize_list(&n1, v1);
+        std::istringstream is4(v1.str());
+        List e = deserialize_list_any(is4);
+        assert(e.nodes.size() == 3 && e.nodes[2].id == 30);
+        (void)c;
+        (void)d;
+        (void)e;
+        assert(os.str().size() < v1.str().size());
+    }
+    std::cout << "Compact round-trip OK\n";
+
+    // Parallel (v5): the CRC32C check value on both paths; 10 nodes in chunks
+    // of 4, then one flipped bit in chunk 1 is found by verify() and decode().
+    {
+        const char check[] = "123456789";
+        assert(crc32c(check, 9) == 0xE3069283u);
+        assert(~detail::crc32c_sw(~0u, reinterpret_cast<const unsigned char *>(check), 9) == 0xE3069283u);
+        (void)check;
+
+        std::vector<Node> ten(10);
+        for (std::size_t i = 0; i < ten.size(); ++i)
+        {
+            ten[i].id = static_cast<int>(100 + i);
+            ten[i].next = i + 1 < ten.size() ? &ten[i + 1] : nullptr;
+        }
+        const Linearized lin = linearize(&ten[0]);
+        std::ostringstream os;
+        serialize_parallel(os, lin.order.size(), [&](std::size_t i)
+                           { return lin.record(i); }, 2, 4);
+        std::string bytes = os.str();
+        {
+            const ParallelSnapshot snap(reinterpret_cast<const unsigned char *>(bytes.data()), bytes.size());
+            assert(snap.size() == 10 && snap.chunks() == 3 && snap.verify(2).empty());
+            List p = snap.decode(2);
+            print_list(p.head(), "Parallel");
+            assert(p.nodes[9].id == 109 && p.nodes[3].next == &p.nodes[4] && p.nodes[9].next == nullptr);
+            (void)p;
+        }
+        // Offset of chunk 1 from its table entry.
+        const std::size_t at = static_cast<std::size_t>(
+            load_u64_le(reinterpret_cast<const unsigned char *>(bytes.data()) + V5_HEADER_SIZE + V5_ENTRY_SIZE));
+        bytes[at] = static_cast<char>(bytes[at] ^ 0x10);
+        const ParallelSnapshot snap(reinterpret_cast<const unsigned char *>(bytes.data()), bytes.size());
+        assert((snap.verify(2) == std::vector<std::size_t>{1}));
+        bool caught = false;
+        try
+        {
+            snap.decode(2);
+        }
+        catch (const std::runtime_error &e)
+        {
+            caught = std::strcmp(e.what(), "chunk 1: checksum mismatch") == 0;
+        }
+        assert(caught);
+        (void)caught;
+    }
+    std::cout << "Parallel round-trip OK\n";
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define SPSC_HAVE_MMAP 1
+#endif
+
+// --------------------------- HugePageAllocator ---------------------------
+// STL-style allocator for large, long-lived buffers (ring storage). Requests
+// are rounded up to 2 MB and mapped directly:
+//   - huge_pages: try explicit huge pages (MAP_HUGETLB) first, and fall back
+//     to normal pages with a transparent-huge-page hint (MADV_HUGEPAGE).
+//   - populate:   pre-fault the mapping (MAP_POPULATE for huge pages, a
+//     write per page otherwise) so the first traffic doesn't page-fault.
+// Without mmap it degrades to ::operator new.
+template <class T>
+class HugePageAllocator
+{
+public:
+    using value_type = T;
+
+    static constexpr std::size_t kHugePage = std::size_t(2) << 20; // 2 MB
+
+    explicit HugePageAllocator(bool huge_pages = true, bool populate = true) noexcept
+        : huge_pages_(huge_pages), populate_(populate)
+    {
+    }
+
+    template <class U>
+    HugePageAllocator(const HugePageAllocator<U> &o) noexcept
+        : huge_pages_(o.huge_pages()), populate_(o.populate())
+    {
+    }
+
+    T *allocate(std::size_t n)
+    {
+        const std::size_t bytes = round_up(n * sizeof(T));
+#if defined(SPSC_HAVE_MMAP)
+        void *p = map(bytes);
+        if (p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(p);
+#else
+        return static_cast<T *>(::operator new(bytes));
+#endif
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+#if defined(SPSC_HAVE_MMAP)
+        ::munmap(p, round_up(n * sizeof(T)));
+#else
+        (void)n;
+        ::operator delete(p);
+#endif
+    }
+
+    bool huge_pages() const noexcept { return huge_pages_; }
+    bool populate() const noexcept { return populate_; }
+
+    template <class U>
+    bool operator==(const HugePageAllocator<U> &o) const noexcept
+    {
+        return huge_pages_ == o.huge_pages() && populate_ == o.populate();
+    }
+    template <class U>
+    bool operator!=(const HugePageAllocator<U> &o) const noexcept { return !(*this == o); }
+
+private:
+    static std::size_t round_up(std::size_t bytes) noexcept
+    {
+        return (bytes + kHugePage - 1) & ~(kHugePage - 1);
+    }
+
+#if defined(SPSC_HAVE_MMAP)
+    void *map(std::size_t bytes) const noexcept
+    {
+        const int prot = PROT_READ | PROT_WRITE;
+        const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_HUGETLB)
+        if (huge_pages_)
+        {
+            int huge_flags = flags | MAP_HUGETLB;
+#if defined(MAP_POPULATE)
+            if (populate_)
+                huge_flags |= MAP_POPULATE;
+#endif
+            void *p = ::mmap(nullptr, bytes, prot, huge_flags, -1, 0);
+            if (p != MAP_FAILED)
+                return p;
+        }
+#endif
+        // No reserved huge pages (or not Linux): regular pages + THP hint.
+        // Pre-fault after madvise so the touched pages can be backed huge.
+        void *p = ::mmap(nullptr, bytes, prot, flags, -1, 0);
+        if (p == MAP_FAILED)
+            return nullptr;
+#if defined(MADV_HUGEPAGE)
+        if (huge_pages_)
+            ::madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+        if (populate_)
+            prefault(p, bytes);
+        return p;
+    }
+
+    static void prefault(void *p, std::size_t bytes) noexcept
+    {
+        volatile char *c = static_cast<volatile char *>(p);
+        for (std::size_t off = 0; off < bytes; off += 4096)
+            c[off] = 0;
+    }
+#endif
+
+    bool huge_pages_;
+    bool populate_;
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "bench/CacheLine.hpp"
+
+// --------------------------- BoundedQueue ---------------------------
+// Bounded multi-producer queue after Dmitry Vyukov's design: every cell
+// carries a sequence number that says whose turn it is.
+//   seq == pos        -> free, producer for ticket 'pos' may write it
+//   seq == pos + 1    -> full, consumer for ticket 'pos' may read it
+// Producers claim tickets with a CAS on enqueue_pos_. With MultiConsumer the
+// consumers do the same on dequeue_pos_; the single-consumer variant (MPSC)
+// owns dequeue_pos_ and advances it with a plain store.
+// Same try_push/try_emplace/try_pop surface as SPSCQueue; capacity is chosen
+// at construction and must be a power of two.
+template <class T, bool MultiConsumer>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(std::size_t capacity)
+        : mask_(capacity - 1), enqueue_pos_(0), dequeue_pos_(0)
+    {
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+        {
+            throw std::invalid_argument("Capacity must be a power of two >= 2");
+        }
+        cells_.reset(new Cell[capacity]);
+        for (std::size_t i = 0; i < capacity; ++i)
+        {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~BoundedQueue() { clear(); }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+    BoundedQueue(BoundedQueue &&) = delete;
+    BoundedQueue &operator=(BoundedQueue &&) = delete;
+
+    std::size_t capacity() const noexcept { return mask_ + 1; }
+
+    // Any producer thread
+    bool try_push(const T &value) { return try_emplace(value); }
+
+    // Any producer thread
+    bool try_push(T &&value) { return try_emplace(std::move(value)); }
+
+    // Any producer thread
+    template <class... Args>
+    bool try_emplace(Args &&...args)
+    {
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;)
+        {
+            cell = &cells_[pos & mask_];
+            std::size_t seq = cell->seq.load(std::memory_order_acquire);
+            std::ptrdiff_t dif = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (dif == 0)
+            {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        ::new (static_cast<void *>(cell->ptr())) T(std::forward<Args>(args)...);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Any consumer thread (MPMC) / the consumer thread (MPSC)
+    bool try_pop(T &out)
+    {
+        Cell *cell;
+        std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        if (MultiConsumer)
+        {
+            for (;;)
+            {
+                cell = &cells_[pos & mask_];
+                std::size_t seq = cell->seq.load(std::memory_order_acquire);
+                std::ptrdiff_t dif = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+                if (dif == 0)
+                {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (dif < 0)
+                {
+                    return false; // empty
+                }
+                else
+                {
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+        else
+        {
+            cell = &cells_[pos & mask_];
+            if (cell->seq.load(std::memory_order_acquire) != pos + 1)
+            {
+                return false; // empty (or producer still writing this cell)
+            }
+            dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+        }
+        T *p = cell->ptr();
+        out = std::move(*p);
+        p->~T(); // destroy once
+        cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Non-owning query (racy/approximate)
+    bool empty() const noexcept
+    {
+        return enqueue_pos_.load(std::memory_order_acquire) ==
+               dequeue_pos_.load(std::memory_order_acquire);
+    }
+
+    // Destroy any remaining elements. Call only when all threads are stopped.
+    void clear() noexcept
+    {
+        std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        const std::size_t end = enqueue_pos_.load(std::memory_order_relaxed);
+        for (; pos != end; ++pos)
+        {
+            Cell &cell = cells_[pos & mask_];
+            cell.ptr()->~T();
+            cell.seq.store(pos + mask_ + 1, std::memory_order_relaxed);
+        }
+        dequeue_pos_.store(pos, std::memory_order_relaxed);
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> seq;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T *ptr() noexcept { return reinterpret_cast<T *>(&storage); }
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    const std::size_t mask_;
+
+    // Contended by producers
+    alignas(bench::kPadSize) std::atomic<std::size_t> enqueue_pos_;
+    // Contended by consumers (MPMC) / owned by the consumer (MPSC)
+    alignas(bench::kPadSize) std::atomic<std::size_t> dequeue_pos_;
+};
+
+template <class T>
+using MPMCQueue = BoundedQueue<T, true>;
+
+template <class T>
+using MPSCQueue = BoundedQueue<T, false>;
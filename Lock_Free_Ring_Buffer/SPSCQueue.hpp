@@ -0,0 +1,382 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <cassert>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "bench/CacheLine.hpp"
+
+// --------------------------- Ring storage ---------------------------
+// The queue logic only needs "address of slot i" and a power-of-two mask, so
+// where the slots live is a policy: inline in the object, or on the heap.
+
+// Fixed capacity, slots stored inline (capacity is a template argument).
+template <class T, std::size_t PowerOfTwoCapacity>
+class InlineRingStorage
+{
+public:
+    InlineRingStorage() noexcept
+    {
+        static_assert(PowerOfTwoCapacity >= 2, "Capacity must be >= 2");
+        static_assert((PowerOfTwoCapacity & (PowerOfTwoCapacity - 1)) == 0,
+                      "Capacity must be a power of two");
+    }
+
+    static constexpr std::size_t capacity() noexcept { return PowerOfTwoCapacity; }
+    static constexpr std::size_t mask() noexcept { return PowerOfTwoCapacity - 1; }
+
+    T *slot(std::size_t i) noexcept { return reinterpret_cast<T *>(&buf_[i]); }
+
+private:
+    using storage_t = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+    storage_t buf_[PowerOfTwoCapacity];
+};
+
+// Capacity chosen at construction; slots come from Alloc (raw storage only,
+// elements are placement-new'd by the queue).
+template <class T, class Alloc = std::allocator<T>>
+class HeapRingStorage
+{
+public:
+    explicit HeapRingStorage(std::size_t capacity, const Alloc &alloc = Alloc())
+        : alloc_(alloc), cap_(capacity), mask_(capacity - 1)
+    {
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+        {
+            throw std::invalid_argument("Capacity must be a power of two >= 2");
+        }
+        buf_ = traits::allocate(alloc_, cap_);
+    }
+
+    ~HeapRingStorage() { traits::deallocate(alloc_, buf_, cap_); }
+
+    HeapRingStorage(const HeapRingStorage &) = delete;
+    HeapRingStorage &operator=(const HeapRingStorage &) = delete;
+
+    std::size_t capacity() const noexcept { return cap_; }
+    std::size_t mask() const noexcept { return mask_; }
+
+    T *slot(std::size_t i) noexcept { return buf_ + i; }
+
+private:
+    using traits = std::allocator_traits<Alloc>;
+    static_assert(std::is_same<typename traits::value_type, T>::value,
+                  "Alloc::value_type must be T");
+
+    Alloc alloc_;
+    std::size_t cap_;
+    std::size_t mask_;
+    T *buf_ = nullptr;
+};
+
+// --------------------------- BasicSPSCQueue ---------------------------
+// Pad separates the producer's and the consumer's index lines (see
+// bench::kPadSize); the spacing benchmark instantiates smaller values.
+template <class T, class Storage, std::size_t Pad = bench::kPadSize>
+class BasicSPSCQueue
+{
+    static_assert((Pad & (Pad - 1)) == 0 && Pad >= alignof(std::atomic<std::size_t>),
+                  "Pad must be a power of two >= alignof(std::atomic<std::size_t>)");
+
+public:
+    // Arguments are forwarded to the storage (none for inline, capacity and
+    // optional allocator for heap storage).
+    template <class... Args,
+              class = typename std::enable_if<std::is_constructible<Storage, Args &&...>::value>::type>
+    explicit BasicSPSCQueue(Args &&...args)
+        : store_(std::forward<Args>(args)...), head_(0), tail_(0)
+    {
+    }
+
+    ~BasicSPSCQueue() { clear(); }
+
+    BasicSPSCQueue(const BasicSPSCQueue &) = delete;
+    BasicSPSCQueue &operator=(const BasicSPSCQueue &) = delete;
+
+    BasicSPSCQueue(BasicSPSCQueue &&) = delete;
+    BasicSPSCQueue &operator=(BasicSPSCQueue &&) = delete;
+
+    // Number of slots in the ring (one is always kept empty).
+    std::size_t capacity() const noexcept { return store_.capacity(); }
+
+    // Producer thread only
+    bool try_push(const T &value)
+    {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t next = (head + 1) & store_.mask();
+        if (!has_room(next))
+        {
+            return false; // full
+        }
+        ::new (static_cast<void *>(store_.slot(head))) T(value); // placement-new
+        head_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Producer thread only
+    bool try_push(T &&value)
+    {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t next = (head + 1) & store_.mask();
+        if (!has_room(next))
+        {
+            return false; // full
+        }
+        ::new (static_cast<void *>(store_.slot(head))) T(std::move(value));
+        head_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Producer thread only
+    template <class... Args>
+    bool try_emplace(Args &&...args)
+    {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t next = (head + 1) & store_.mask();
+        if (!has_room(next))
+        {
+            return false; // full
+        }
+        ::new (static_cast<void *>(store_.slot(head))) T(std::forward<Args>(args)...);
+        head_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Producer thread only. Copies up to n elements from src and publishes
+    // them with a single release store. Returns how many were pushed.
+    std::size_t try_push_n(const T *src, std::size_t n)
+    {
+        const std::size_t mask = store_.mask();
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t room = (tail_cache_ - head - 1) & mask;
+        if (room < n)
+        {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            room = (tail_cache_ - head - 1) & mask;
+        }
+        const std::size_t count = n < room ? n : room;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            ::new (static_cast<void *>(store_.slot((head + i) & mask))) T(src[i]);
+        }
+        if (count != 0)
+        {
+            head_.store((head + count) & mask, std::memory_order_release);
+        }
+        return count;
+    }
+
+    // Contiguous run of uninitialised slots handed out by reserve().
+    // Construct elements in [data, data + size) with placement new.
+    struct WriteWindow
+    {
+        T *data;
+        std::size_t size;
+    };
+
+    // Producer thread only. Returns up to n free slots that are contiguous in
+    // memory; the window is shorter than n when the ring is nearly full or
+    // the run would wrap past the end of the buffer.
+    WriteWindow reserve(std::size_t n)
+    {
+        const std::size_t mask = store_.mask();
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t room = (tail_cache_ - head - 1) & mask;
+        if (room < n)
+        {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            room = (tail_cache_ - head - 1) & mask;
+        }
+        std::size_t count = n < room ? n : room;
+        if (count > store_.capacity() - head)
+        {
+            count = store_.capacity() - head; // stop at the wrap point
+        }
+        return WriteWindow{store_.slot(head), count};
+    }
+
+    // Producer thread only. Publishes the first count slots of the last
+    // reserve() window, all of which must have been constructed.
+    void commit(std::size_t count)
+    {
+        const std::size_t mask = store_.mask();
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        assert(count <= ((tail_cache_ - head - 1) & mask));
+        head_.store((head + count) & mask, std::memory_order_release);
+    }
+
+    // Consumer thread only. Moves the front element into out.
+    bool try_pop(T &out)
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (!has_data(tail))
+        {
+            return false; // empty
+        }
+        T *p = store_.slot(tail);
+        out = std::move(*p);
+        destroy_slot(p);
+        tail_.store((tail + 1) & store_.mask(), std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only. Same as above but move-constructs the result,
+    // so T needs no default constructor or assignment.
+    std::optional<T> try_pop()
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (!has_data(tail))
+        {
+            return std::nullopt; // empty
+        }
+        T *p = store_.slot(tail);
+        std::optional<T> out(std::move(*p));
+        destroy_slot(p);
+        tail_.store((tail + 1) & store_.mask(), std::memory_order_release);
+        return out;
+    }
+
+    // Consumer thread only. Zero-copy: calls f(T&) on the element while it is
+    // still in its slot, then destroys it and frees the slot. If f throws,
+    // the element stays at the front of the queue.
+    template <class F>
+    bool consume(F &&f)
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (!has_data(tail))
+        {
+            return false; // empty
+        }
+        T *p = store_.slot(tail);
+        std::forward<F>(f)(*p);
+        destroy_slot(p);
+        tail_.store((tail + 1) & store_.mask(), std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only. Moves up to n elements into dst and releases
+    // their slots with a single store. Returns how many were popped.
+    std::size_t try_pop_n(T *dst, std::size_t n)
+    {
+        const std::size_t mask = store_.mask();
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t avail = (head_cache_ - tail) & mask;
+        if (avail < n)
+        {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            avail = (head_cache_ - tail) & mask;
+        }
+        const std::size_t count = n < avail ? n : avail;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            T *p = store_.slot((tail + i) & mask);
+            dst[i] = std::move(*p);
+            destroy_slot(p);
+        }
+        if (count != 0)
+        {
+            tail_.store((tail + count) & mask, std::memory_order_release);
+        }
+        return count;
+    }
+
+    // Non-owning queries (racy/approximate, but often useful for debug)
+    bool empty() const noexcept
+    {
+        return tail_.load(std::memory_order_acquire) ==
+               head_.load(std::memory_order_acquire);
+    }
+    bool full() const noexcept
+    {
+        std::size_t head = head_.load(std::memory_order_acquire);
+        std::size_t next = (head + 1) & store_.mask();
+        return next == tail_.load(std::memory_order_acquire);
+    }
+
+    // Destroy any remaining elements. Call only when both threads are stopped.
+    void clear() noexcept
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (std::is_trivially_destructible<T>::value)
+        {
+            tail = head; // nothing to run, just drop the indices
+        }
+        while (tail != head)
+        {
+            store_.slot(tail)->~T();
+            tail = (tail + 1) & store_.mask();
+        }
+        tail_.store(tail, std::memory_order_relaxed);
+        head_cache_ = head;
+        tail_cache_ = tail;
+    }
+
+private:
+    // Trivially destructible payloads (PODs, trivially copyable structs) skip
+    // the destructor call entirely.
+    static void destroy_slot(T *p) noexcept
+    {
+        if constexpr (!std::is_trivially_destructible<T>::value)
+        {
+            p->~T();
+        }
+        else
+        {
+            (void)p;
+        }
+    }
+
+    // Producer side: only touch the consumer's line when the cached tail says full.
+    bool has_room(std::size_t next)
+    {
+        if (next == tail_cache_)
+        {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (next == tail_cache_)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Consumer side: only touch the producer's line when the cached head says empty.
+    bool has_data(std::size_t tail)
+    {
+        if (tail == head_cache_)
+        {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail == head_cache_)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Storage store_;
+
+    // Written by producer; read by consumer
+    alignas(Pad) std::atomic<std::size_t> head_;
+    // Producer-local copy of tail_
+    alignas(Pad) std::size_t tail_cache_ = 0;
+    // Written by consumer; read by producer
+    alignas(Pad) std::atomic<std::size_t> tail_;
+    // Consumer-local copy of head_
+    alignas(Pad) std::size_t head_cache_ = 0;
+};
+
+// Compile-time capacity, buffer inline: SPSCQueue<T, 1 << 16> q;
+template <class T, std::size_t PowerOfTwoCapacity>
+using SPSCQueue = BasicSPSCQueue<T, InlineRingStorage<T, PowerOfTwoCapacity>>;
+
+// Runtime capacity, buffer from Alloc: DynSPSCQueue<T> q(cap);
+template <class T, class Alloc = std::allocator<T>>
+using DynSPSCQueue = BasicSPSCQueue<T, HeapRingStorage<T, Alloc>>;
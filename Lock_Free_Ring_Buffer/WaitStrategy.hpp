@@ -0,0 +1,230 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+#include "bench/CacheLine.hpp"
+
+#if defined(__linux__)
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(SYS_membarrier) && __has_include(<linux/membarrier.h>)
+#include <linux/membarrier.h>
+#define WAIT_HAVE_MEMBARRIER 1
+#endif
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+// --------------------------- Wait strategies ---------------------------
+// What a consumer does when try_pop() comes back empty. Each policy exposes
+//   wait_until(ready)  consumer side: return once ready() is true
+//   notify()           producer side: call after every successful push
+// Spin and yield never sleep, so their notify() is empty and the producer's
+// hot path stays the queue's single release store.
+
+inline void cpu_relax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+namespace detail
+{
+    // Registers the process for expedited membarrier(2) once. False where the
+    // platform or kernel (< 4.14) has no such command.
+    inline bool membarrier_registered() noexcept
+    {
+#if defined(WAIT_HAVE_MEMBARRIER)
+        static const bool ok = []
+        {
+            const long cmds = ::syscall(SYS_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+            return cmds > 0 && (cmds & MEMBARRIER_CMD_PRIVATE_EXPEDITED) != 0 &&
+                   ::syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+        }();
+        return ok;
+#else
+        return false;
+#endif
+    }
+
+    // Runs a full memory barrier on every CPU currently running one of this
+    // process's threads. Only valid once membarrier_registered() is true.
+    inline void membarrier_all_threads() noexcept
+    {
+#if defined(WAIT_HAVE_MEMBARRIER)
+        ::syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+#endif
+    }
+} // namespace detail
+
+// Busy-poll with `pause`, backing off exponentially (capped) between polls
+// so a spinning core doesn't hammer the producer's cache line.
+class SpinWait
+{
+public:
+    template <class Ready>
+    void wait_until(Ready &&ready) noexcept
+    {
+        unsigned pauses = 1;
+        while (!ready())
+        {
+            for (unsigned i = 0; i < pauses; ++i)
+                cpu_relax();
+            if (pauses < kMaxPauses)
+                pauses <<= 1;
+        }
+    }
+
+    void notify() noexcept {}
+
+private:
+    static constexpr unsigned kMaxPauses = 64;
+};
+
+// Spin briefly, then give the core away with yield() between polls.
+class YieldWait
+{
+public:
+    template <class Ready>
+    void wait_until(Ready &&ready) noexcept
+    {
+        for (unsigned i = 0; i < kSpins; ++i)
+        {
+            if (ready())
+                return;
+            cpu_relax();
+        }
+        while (!ready())
+            std::this_thread::yield();
+    }
+
+    void notify() noexcept {}
+
+private:
+    static constexpr unsigned kSpins = 1024;
+};
+
+// Spin briefly, then sleep in the kernel (futex on Linux, condition variable
+// elsewhere). The consumer advertises itself in waiters_ before re-checking
+// the queue; the producer only issues a wake when it sees that flag. The
+// push's store and the producer's load of waiters_ must not be reordered, or
+// a push that lands just as the consumer goes to sleep is missed. Where the
+// kernel has expedited membarrier the sleeping side pays for that: it forces
+// a barrier on the producer's CPU after advertising itself, and notify() is a
+// plain load with no waiter. Elsewhere notify() falls back to a seq_cst fence
+// (an mfence-class barrier on x86, tens of cycles per push; `spsc wait`
+// reports notify() with no waiter next to SpinWait's empty one).
+class ParkWait
+{
+public:
+    template <class Ready>
+    void wait_until(Ready &&ready) noexcept
+    {
+        for (unsigned i = 0; i < kSpins; ++i)
+        {
+            if (ready())
+                return;
+            cpu_relax();
+        }
+        for (;;)
+        {
+            std::uint32_t e = epoch_.load(std::memory_order_acquire);
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            if (asymmetric_)
+                detail::membarrier_all_threads();
+            if (ready())
+            {
+                waiters_.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+            park(e);
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+            if (ready())
+                return;
+        }
+    }
+
+    void notify() noexcept
+    {
+        if (asymmetric_)
+            std::atomic_signal_fence(std::memory_order_seq_cst); // compiler only; see above
+        else
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) != 0)
+        {
+            epoch_.fetch_add(1, std::memory_order_release);
+            wake();
+        }
+    }
+
+private:
+    static constexpr unsigned kSpins = 1024;
+
+    const bool asymmetric_ = detail::membarrier_registered();
+
+#if defined(__linux__)
+    void park(std::uint32_t expected) noexcept
+    {
+        // Returns immediately if epoch_ already moved past 'expected'.
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&epoch_), FUTEX_WAIT_PRIVATE,
+                  expected, nullptr, nullptr, 0);
+    }
+    void wake() noexcept
+    {
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&epoch_), FUTEX_WAKE_PRIVATE,
+                  INT_MAX, nullptr, nullptr, 0);
+    }
+#else
+    void park(std::uint32_t expected) noexcept
+    {
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait(lk, [&]
+                 { return epoch_.load(std::memory_order_acquire) != expected; });
+    }
+    void wake() noexcept
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        cv_.notify_all();
+    }
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+#endif
+
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+                  "futex word must be a plain 32-bit integer");
+
+    // Bumped by the producer on every wake; the futex word.
+    alignas(bench::kPadSize) std::atomic<std::uint32_t> epoch_{0};
+    // Consumers currently (about to be) parked.
+    alignas(bench::kPadSize) std::atomic<std::uint32_t> waiters_{0};
+};
+
+// Blocking helpers over any queue with try_push/try_pop and a wait policy.
+template <class Queue, class T, class Wait>
+void push_wait(Queue &q, T &&value, Wait &w)
+{
+    while (!q.try_push(std::forward<T>(value)))
+        cpu_relax(); // full: consumer is behind, it will free a slot shortly
+    w.notify();
+}
+
+template <class Queue, class T, class Wait>
+void pop_wait(Queue &q, T &out, Wait &w)
+{
+    w.wait_until([&]
+                 { return q.try_pop(out); });
+}
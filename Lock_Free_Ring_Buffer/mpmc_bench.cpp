@@ -0,0 +1,262 @@
+#include "MPMCQueue.hpp"
+#include "SPSCQueue.hpp"
+
+#include "bench/Harness.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// --------------------------- Multi-thread benchmark ---------------------------
+// Sweeps producer/consumer counts over MPMCQueue, MPSCQueue (1 consumer) and
+// P sharded SPSC lanes (lane i drained by consumer i % C). Every message
+// carries its enqueue timestamp, so the consumer side records end-to-end
+// latency (push call -> pop returned) in addition to aggregate throughput.
+// Each row is timed over pinned runs released from a start gate (BENCH_REPS,
+// default 3, after one warm-up); msgs/s is from the median run, latency
+// percentiles over the samples of every timed run.
+//
+// Usage: mpmc [N] [cap] [max_threads]
+
+struct Msg
+{
+    std::uint64_t seq;
+    std::int64_t t_ns;
+};
+
+static constexpr std::uint64_t kStop = ~std::uint64_t(0); // poison pill
+static constexpr std::size_t kSampleEvery = 16;           // keep 1/16 latencies
+
+struct ConsumerResult
+{
+    std::uint64_t sum = 0;
+    std::uint64_t count = 0;
+    std::vector<std::int64_t> lat;
+};
+
+static void record(ConsumerResult &r, const Msg &m)
+{
+    r.sum += m.seq;
+    if ((r.count++ % kSampleEvery) == 0)
+        r.lat.push_back(bench::now_ns() - m.t_ns);
+}
+
+// One timed run: wall time from the gate opening to the last consumer done.
+struct Run
+{
+    double ns = 0;
+    std::vector<ConsumerResult> res;
+};
+
+// Pins and starts P producers (CPUs 0..P-1) and C consumers (P..P+C-1),
+// then opens the gate once every thread is waiting at it.
+template <class Producer, class Consumer, class Drain>
+static double gated_run(unsigned P, unsigned C, Producer producer, Consumer consumer, Drain drain)
+{
+    std::atomic<unsigned> ready(0);
+    std::atomic<bool> go(false);
+    auto wait_gate = [&](int cpu)
+    {
+        bench::pin_this_thread(cpu);
+        ready.fetch_add(1, std::memory_order_release);
+        while (!go.load(std::memory_order_acquire))
+            std::this_thread::yield(); // more threads than CPUs must still all arrive
+    };
+    std::vector<std::thread> consumers, producers;
+    for (unsigned c = 0; c < C; ++c)
+        consumers.emplace_back([&, c]
+                               {
+            wait_gate(bench::nth_cpu(P + c));
+            consumer(c); });
+    for (unsigned p = 0; p < P; ++p)
+        producers.emplace_back([&, p]
+                               {
+            wait_gate(bench::nth_cpu(p));
+            producer(p); });
+    while (ready.load(std::memory_order_acquire) < P + C)
+        std::this_thread::yield();
+
+    const std::int64_t t0 = bench::now_ns();
+    go.store(true, std::memory_order_release);
+    for (auto &t : producers)
+        t.join();
+    drain();
+    for (auto &t : consumers)
+        t.join();
+    return static_cast<double>(bench::now_ns() - t0);
+}
+
+// Warm-up, then the timed runs; records mpmc/<name>/P=<p>/C=<c> and prints
+// the row. Every run must deliver each of 0..N-1 exactly once.
+template <class OneRun>
+static void measure_row(const char *name, unsigned P, unsigned C, std::uint64_t N, OneRun one_run)
+{
+    const std::uint64_t expected = N * (N - 1) / 2;
+    bool ok = true;
+    auto run = [&]
+    {
+        Run r = one_run();
+        std::uint64_t sum = 0, count = 0;
+        for (const auto &c : r.res)
+        {
+            sum += c.sum;
+            count += c.count;
+        }
+        ok = ok && sum == expected && count == N;
+        return r;
+    };
+    const bench::Options opt = bench::Options::from_env(3, 1);
+    for (std::size_t w = 0; w < opt.warmup_max; ++w)
+        run();
+    std::vector<double> ns;
+    std::vector<std::int64_t> lat;
+    for (std::size_t i = 0; i < opt.reps; ++i)
+    {
+        Run r = run();
+        ns.push_back(r.ns);
+        for (const auto &c : r.res)
+            lat.insert(lat.end(), c.lat.begin(), c.lat.end());
+    }
+    const bench::Stats st = bench::summarize(std::move(ns));
+
+    std::sort(lat.begin(), lat.end());
+    auto pct = [&](double q) -> double
+    {
+        if (lat.empty())
+            return 0;
+        std::size_t i = static_cast<std::size_t>(q * static_cast<double>(lat.size() - 1));
+        return static_cast<double>(lat[i]);
+    };
+    const double msgs_per_s = static_cast<double>(N) / (st.median_ns * 1e-9);
+    const double lat_max = lat.empty() ? 0 : static_cast<double>(lat.back());
+    bench::record(std::string("mpmc/") + name + "/P=" + std::to_string(P) + "/C=" + std::to_string(C), st,
+                  {{"msgs_per_s", msgs_per_s},
+                   {"lat_p50_ns", pct(0.50)},
+                   {"lat_p99_ns", pct(0.99)},
+                   {"lat_p999_ns", pct(0.999)},
+                   {"lat_max_ns", lat_max}});
+
+    std::cout << std::left << std::setw(6) << name << std::right
+              << " P=" << std::setw(2) << P << " C=" << std::setw(2) << C
+              << " | " << std::setw(12) << std::fixed << std::setprecision(0) << msgs_per_s << " msgs/s"
+              << " | lat ns p50=" << pct(0.50) << " p99=" << pct(0.99)
+              << " p99.9=" << pct(0.999) << " max=" << lat_max
+              << " | checksum OK? " << (ok ? "yes" : "NO") << "\n";
+}
+
+// Producer p sends seq p, p+P, p+2P, ... < N.
+template <class Queue>
+static Run run_shared(unsigned P, unsigned C, std::uint64_t N, std::size_t cap)
+{
+    Queue q(cap);
+    Run run;
+    run.res.resize(C);
+    run.ns = gated_run(
+        P, C, [&](unsigned p)
+        {
+            for (std::uint64_t i = p; i < N; i += P) {
+                while (!q.try_emplace(Msg{i, bench::now_ns()})) {}
+            } },
+        [&](unsigned c)
+        {
+            ConsumerResult &r = run.res[c];
+            r.lat.reserve(N / kSampleEvery / C + 16);
+            Msg m;
+            for (;;) {
+                while (!q.try_pop(m)) {}
+                if (m.seq == kStop) break;
+                record(r, m);
+            } },
+        [&]
+        {
+            for (unsigned c = 0; c < C; ++c) {
+                while (!q.try_emplace(Msg{kStop, 0})) {}
+            } });
+    return run;
+}
+
+// One SPSC lane per producer; consumer c polls lanes c, c+C, c+2C, ...
+static Run run_lanes(unsigned P, unsigned C, std::uint64_t N, std::size_t cap)
+{
+    typedef DynSPSCQueue<Msg> Lane;
+    std::vector<std::unique_ptr<Lane>> lanes;
+    for (unsigned p = 0; p < P; ++p)
+        lanes.emplace_back(new Lane(cap));
+
+    Run run;
+    run.res.resize(C);
+    run.ns = gated_run(
+        P, C, [&](unsigned p)
+        {
+            Lane &q = *lanes[p];
+            for (std::uint64_t i = p; i < N; i += P) {
+                while (!q.try_emplace(Msg{i, bench::now_ns()})) {}
+            }
+            while (!q.try_emplace(Msg{kStop, 0})) {} },
+        [&](unsigned c)
+        {
+            ConsumerResult &r = run.res[c];
+            r.lat.reserve(N / kSampleEvery / C + 16);
+            std::vector<Lane *> mine;
+            for (unsigned l = c; l < P; l += C) mine.push_back(lanes[l].get());
+            Msg m;
+            while (!mine.empty()) {
+                for (std::size_t k = 0; k < mine.size();) {
+                    if (!mine[k]->try_pop(m)) { ++k; continue; }
+                    if (m.seq == kStop) { mine.erase(mine.begin() + k); continue; }
+                    record(r, m);
+                }
+            } },
+        [] {});
+    return run;
+}
+
+int main(int argc, char **argv)
+{
+    const std::uint64_t N = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 10000000ull;
+    const std::size_t CAP = (argc > 2) ? static_cast<std::size_t>(std::strtoull(argv[2], nullptr, 10))
+                                       : (1u << 16);
+    unsigned max_threads = (argc > 3) ? static_cast<unsigned>(std::strtoul(argv[3], nullptr, 10))
+                                      : std::thread::hardware_concurrency();
+    if (max_threads < 2)
+        max_threads = 2; // at least one producer and one consumer
+
+    if ((CAP & (CAP - 1)) != 0 || CAP < 2)
+    {
+        std::cerr << "Capacity must be a power of two >= 2\n";
+        return 1;
+    }
+
+    std::cout << "N: " << N << " | capacity: " << CAP << " | max threads: " << max_threads << "\n";
+
+    // Fan-in: P producers -> 1 consumer
+    for (unsigned P = 1; P + 1 <= max_threads; P *= 2)
+    {
+        measure_row("mpsc", P, 1, N, [&]
+                    { return run_shared<MPSCQueue<Msg>>(P, 1, N, CAP); });
+        measure_row("mpmc", P, 1, N, [&]
+                    { return run_shared<MPMCQueue<Msg>>(P, 1, N, CAP); });
+        measure_row("lanes", P, 1, N, [&]
+                    { return run_lanes(P, 1, N, CAP); });
+    }
+    // General: P producers -> C consumers
+    for (unsigned C = 2; C + 1 <= max_threads; C *= 2)
+    {
+        for (unsigned P = 1; P + C <= max_threads; P *= 2)
+        {
+            measure_row("mpmc", P, C, N, [&]
+                        { return run_shared<MPMCQueue<Msg>>(P, C, N, CAP); });
+            measure_row("lanes", P, C, N, [&]
+                        { return run_lanes(P, C, N, CAP); });
+        }
+    }
+    return 0;
+}
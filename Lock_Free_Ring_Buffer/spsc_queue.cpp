@@ -1,199 +1,393 @@
-#include <atomic>
+#include "SPSCQueue.hpp"
+#include "HugePageAllocator.hpp"
+#include "WaitStrategy.hpp"
+
+#include "bench/PerfCounters.hpp"
+
 #include <cstddef>
 #include <cstdint>
-#include <new>
-#include <type_traits>
 #include <thread>
 #include <chrono>
 #include <iostream>
-#include <cassert>
 #include <memory>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <optional>
+#include <string>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+#endif
 
-// --------------------------- SPSCQueue ---------------------------
-template <class T, std::size_t PowerOfTwoCapacity>
-class SPSCQueue
+// --------------------------- Test / Benchmark ---------------------------
+typedef std::uint64_t value_t;
+
+// One producer/consumer run, pinned to two CPUs. batch == 0 uses
+// try_push/try_pop per item, otherwise try_push_n/try_pop_n with up to 'batch'
+// items per call. Returns the consumer's sum of the values.
+template <class Queue>
+value_t run_once(Queue *q, std::size_t N, std::size_t batch)
 {
-public:
-    SPSCQueue() noexcept : head_(0), tail_(0)
-    {
-        static_assert(PowerOfTwoCapacity >= 2, "Capacity must be >= 2");
-        static_assert((PowerOfTwoCapacity & (PowerOfTwoCapacity - 1)) == 0,
-                      "Capacity must be a power of two");
-    }
+    value_t sum = 0;
 
-    ~SPSCQueue() { clear(); }
+    std::thread prod([&]
+                     {
+        bench::pin_this_thread(bench::nth_cpu(0));
+        if (batch == 0) {
+            for (std::size_t i = 0; i < N; ++i) {
+                value_t v = static_cast<value_t>(i);
+                while (!q->try_push(v)) {}
+            }
+            return;
+        }
+        std::unique_ptr<value_t[]> local(new value_t[batch]);
+        for (std::size_t i = 0; i < N;) {
+            std::size_t n = (N - i) < batch ? (N - i) : batch;
+            for (std::size_t k = 0; k < n; ++k)
+                local[k] = static_cast<value_t>(i + k);
+            std::size_t done = 0;
+            while (done < n)
+                done += q->try_push_n(local.get() + done, n - done);
+            i += n;
+        } });
+    std::thread cons([&]
+                     {
+        bench::pin_this_thread(bench::nth_cpu(1));
+        if (batch == 0) {
+            value_t v;
+            for (std::size_t i = 0; i < N; ++i) {
+                while (!q->try_pop(v)) {}
+                sum += v;
+            }
+            return;
+        }
+        std::unique_ptr<value_t[]> local(new value_t[batch]);
+        for (std::size_t i = 0; i < N;) {
+            std::size_t want = (N - i) < batch ? (N - i) : batch;
+            std::size_t got = q->try_pop_n(local.get(), want);
+            for (std::size_t k = 0; k < got; ++k)
+                sum += local[k];
+            i += got;
+        } });
 
-    SPSCQueue(const SPSCQueue &) = delete;
-    SPSCQueue &operator=(const SPSCQueue &) = delete;
+    prod.join();
+    cons.join();
+    return sum;
+}
 
-    SPSCQueue(SPSCQueue &&) = default;
-    SPSCQueue &operator=(SPSCQueue &&) = default;
+// " | time: 0.123 s (min 0.120, stddev 0.002, 3 runs) | throughput: ..."
+static void print_time(const bench::Stats &st, std::size_t N)
+{
+    const double secs = st.median_ns * 1e-9;
+    std::cout << " | time: " << secs << " s (min " << st.min_ns * 1e-9 << ", stddev "
+              << st.stddev_ns * 1e-9 << ", " << st.reps << " runs)"
+              << " | throughput: " << (static_cast<double>(N) / secs) << " msgs/s";
+}
 
-    // Producer thread only
-    bool try_push(const T &value)
-    {
-        std::size_t head = head_.load(std::memory_order_relaxed);
-        std::size_t next = (head + 1) & MASK;
-        if (next == tail_.load(std::memory_order_acquire))
-        {
-            return false; // full
-        }
-        ::new (elem_addr(head)) T(value); // placement-new
-        head_.store(next, std::memory_order_release);
-        return true;
-    }
+// Throughput plus the hardware events per message.
+static void record_run(const std::string &name, const bench::Stats &st, const bench::PerfSample &pmc, std::size_t N)
+{
+    std::vector<bench::Metric> m = pmc.metrics(static_cast<double>(N));
+    m.push_back(bench::Metric{"msgs_per_s", static_cast<double>(N) / (st.median_ns * 1e-9)});
+    bench::record(name, st, std::move(m));
+}
 
-    // Producer thread only
-    bool try_push(T &&value)
-    {
-        std::size_t head = head_.load(std::memory_order_relaxed);
-        std::size_t next = (head + 1) & MASK;
-        if (next == tail_.load(std::memory_order_acquire))
-        {
-            return false; // full
-        }
-        ::new (elem_addr(head)) T(std::move(value));
-        head_.store(next, std::memory_order_release);
-        return true;
-    }
+// Timed runs of run_once (the queue is empty again after each run).
+template <class Queue>
+void run_bench(Queue *q, const char *storage, std::size_t N, std::size_t batch)
+{
+    const unsigned long long expected = (unsigned long long)N * (N - 1ull) / 2;
+    bool ok = true;
+    bench::PerfSample pmc;
+    const bench::Stats st = bench::measure([&]
+                                           { ok = (run_once(q, N, batch) == expected) && ok; },
+                                           bench::Options::from_env(3, 2), pmc);
 
-    // Producer thread only
-    template <class... Args>
-    bool try_emplace(Args &&...args)
-    {
-        std::size_t head = head_.load(std::memory_order_relaxed);
-        std::size_t next = (head + 1) & MASK;
-        if (next == tail_.load(std::memory_order_acquire))
-        {
-            return false; // full
+    const std::string mode = batch == 0 ? std::string("per-item") : "batch(" + std::to_string(batch) + ")";
+    std::cout << "Capacity: " << q->capacity() << " | storage: " << storage
+              << " | N: " << N << " | mode: " << mode;
+    print_time(st, N);
+    std::cout << " | checksum OK? " << (ok ? "yes" : "NO") << pmc.format("msg", static_cast<double>(N)) << "\n";
+    record_run("spsc/cap=" + std::to_string(q->capacity()) + "/" + storage + "/" + mode, st, pmc, N);
+}
+
+template <class Alloc>
+void run_cap(std::size_t cap, const Alloc &alloc, const char *storage, std::size_t N, std::size_t batch)
+{
+    // Queue object is small now (buffer lives behind a pointer), but keep the
+    // two hot index lines away from the stack frame of main().
+    std::unique_ptr<DynSPSCQueue<value_t, Alloc>> q(new DynSPSCQueue<value_t, Alloc>(cap, alloc));
+    run_bench(q.get(), storage, N, 0);
+    run_bench(q.get(), storage, N, batch);
+}
+
+// --------------------------- Spacing benchmark ---------------------------
+// Same queue with its head/tail index lines Pad bytes apart: 8 puts all four
+// index words on one line, 64 is one line each, 128/256 also keep them out of
+// the adjacent-line prefetcher's pairs. A small ring keeps the indices hot.
+
+template <std::size_t Pad>
+void run_spacing(std::size_t N, std::size_t batch)
+{
+    typedef BasicSPSCQueue<value_t, HeapRingStorage<value_t>, Pad> Q;
+    std::unique_ptr<Q> q(new Q(std::size_t(1) << 10));
+    const std::string storage = "heap,pad=" + std::to_string(Pad);
+    run_bench(q.get(), storage.c_str(), N, 0);
+    run_bench(q.get(), storage.c_str(), N, batch);
+}
+
+static void run_spacing_modes(std::size_t N, std::size_t batch)
+{
+    std::cout << "Index spacing sweep (padding constant: " << bench::kPadSize << " bytes)\n";
+    run_spacing<8>(N, batch);
+    run_spacing<64>(N, batch);
+    run_spacing<128>(N, batch);
+    run_spacing<256>(N, batch);
+}
+
+// --------------------------- Payload benchmark ---------------------------
+// Non-trivial 256-byte message: a heap-backed string plus inline bytes. The
+// producer side is identical in every mode; only the dequeue path changes.
+
+struct HeavyMsg
+{
+    std::uint64_t seq;
+    std::string text; // longer than SSO, so copying it allocates
+    char body[256 - sizeof(std::uint64_t) - sizeof(std::string)];
+
+    HeavyMsg() : seq(0), body{} {}
+    HeavyMsg(std::uint64_t s, const std::string &t) : seq(s), text(t), body{} {}
+};
+static_assert(sizeof(HeavyMsg) == 256, "HeavyMsg should be 256 bytes");
+
+// pop(q, sum) must dequeue one message (returning false if empty) and add
+// its seq + text length to sum.
+template <class Pop>
+void run_payload_bench(const char *name, std::size_t N, Pop pop)
+{
+    DynSPSCQueue<HeavyMsg> q(1u << 12);
+    const std::string text(48, 'x');
+    const unsigned long long expected = (unsigned long long)N * (N - 1ull) / 2 + N * text.size();
+    bool ok = true;
+    bench::PerfSample pmc;
+
+    const bench::Stats st = bench::measure([&]
+                                           {
+        std::uint64_t sum = 0;
+        std::thread prod([&]
+                         {
+            bench::pin_this_thread(bench::nth_cpu(0));
+            for (std::size_t i = 0; i < N; ++i)
+                while (!q.try_emplace(static_cast<std::uint64_t>(i), text)) {} });
+        std::thread cons([&]
+                         {
+            bench::pin_this_thread(bench::nth_cpu(1));
+            for (std::size_t i = 0; i < N; ++i)
+                while (!pop(q, sum)) {} });
+        prod.join();
+        cons.join();
+        ok = (sum == expected) && ok; },
+                                           bench::Options::from_env(3, 2), pmc);
+
+    std::cout << "Payload: " << name << " | N: " << N;
+    print_time(st, N);
+    std::cout << " | checksum OK? " << (ok ? "yes" : "NO") << pmc.format("msg", static_cast<double>(N)) << "\n";
+    record_run(std::string("spsc/payload/") + name, st, pmc, N);
+}
+
+static void run_payload_modes(std::size_t N)
+{
+    typedef DynSPSCQueue<HeavyMsg> Q;
+    std::cout << "sizeof(HeavyMsg): " << sizeof(HeavyMsg) << " bytes\n";
+
+    // What try_pop used to do: copy-assign out of the slot, then destroy it.
+    run_payload_bench("copy-out", N, [](Q &q, std::uint64_t &sum)
+                      {
+        static thread_local HeavyMsg out;
+        return q.consume([&](HeavyMsg &m) { out = m; sum += out.seq + out.text.size(); }); });
+    run_payload_bench("try_pop(T&)", N, [](Q &q, std::uint64_t &sum)
+                      {
+        static thread_local HeavyMsg out;
+        if (!q.try_pop(out)) return false;
+        sum += out.seq + out.text.size();
+        return true; });
+    run_payload_bench("optional", N, [](Q &q, std::uint64_t &sum)
+                      {
+        std::optional<HeavyMsg> m = q.try_pop();
+        if (!m) return false;
+        sum += m->seq + m->text.size();
+        return true; });
+    run_payload_bench("consume", N, [](Q &q, std::uint64_t &sum)
+                      { return q.consume([&](const HeavyMsg &m) { sum += m.seq + m.text.size(); }); });
+}
+
+// --------------------------- Wait-strategy benchmark ---------------------------
+// Bursty load: the producer pushes 'burst' timestamped messages, then idles for
+// 'gap_us'. Wake-up latency is measured on the first message of each burst
+// (the one that finds the consumer idle); CPU is the consumer thread's CPU
+// time over wall time, i.e. how much of a core the idle consumer burns.
+
+// Per-thread CPU seconds, or -1 where the platform has no such clock.
+static double thread_cpu_seconds()
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) * 1e-9;
+#else
+    return -1.0;
+#endif
+}
+
+// Producer-side cost of notify() when no consumer is parked, i.e. what every
+// push pays on top of the queue's own store.
+template <class Wait>
+double notify_ns(const char *name)
+{
+    constexpr std::size_t kCalls = 1u << 20;
+    Wait w;
+    const bench::Stats st = bench::measure([&]
+                                           {
+        for (std::size_t i = 0; i < kCalls; ++i) {
+            w.notify();
+            bench::clobber_memory();
+        } });
+    const double ns = st.median_ns / static_cast<double>(kCalls);
+    bench::record(std::string("spsc/wait/") + name + "/notify", st, {{"ns_per_call", ns}});
+    return ns;
+}
+
+template <class Wait>
+void run_wait_bench(const char *name, std::size_t bursts, std::size_t burst, std::size_t gap_us)
+{
+    DynSPSCQueue<std::int64_t> q(1u << 16);
+    Wait w;
+    std::vector<std::int64_t> wake, all;
+    wake.reserve(bursts);
+    all.reserve(bursts * burst);
+    double cpu = 0.0;
+
+    std::thread cons([&]
+                     {
+        const double c0 = thread_cpu_seconds();
+        std::int64_t t;
+        for (std::size_t i = 0;; ++i) {
+            pop_wait(q, t, w);
+            if (t < 0) break; // stop marker
+            const std::int64_t lat = bench::now_ns() - t;
+            all.push_back(lat);
+            if (i % burst == 0) wake.push_back(lat);
         }
-        ::new (elem_addr(head)) T(std::forward<Args>(args)...);
-        head_.store(next, std::memory_order_release);
-        return true;
-    }
+        const double c1 = thread_cpu_seconds();
+        cpu = (c0 < 0.0) ? -1.0 : (c1 - c0); });
 
-    // Consumer thread only
-    bool try_pop(T &out)
+    const std::int64_t t0 = bench::now_ns();
+    for (std::size_t b = 0; b < bursts; ++b)
     {
-        std::size_t tail = tail_.load(std::memory_order_relaxed);
-        if (tail == head_.load(std::memory_order_acquire))
-        {
-            return false; // empty
-        }
-        T *p = elem_ptr(tail);
-        out = *p; // copy or move (RVO not applicable here)
-        p->~T();  // destroy once
-        tail_.store((tail + 1) & MASK, std::memory_order_release);
-        return true;
+        for (std::size_t k = 0; k < burst; ++k)
+            push_wait(q, bench::now_ns(), w);
+        std::this_thread::sleep_for(std::chrono::microseconds(gap_us));
     }
+    push_wait(q, std::int64_t(-1), w);
+    cons.join();
+    const double secs = static_cast<double>(bench::now_ns() - t0) * 1e-9;
 
-    // Non-owning queries (racy/approximate, but often useful for debug)
-    bool empty() const noexcept
+    auto stats = [](const std::vector<std::int64_t> &v)
+    { return bench::summarize(std::vector<double>(v.begin(), v.end())); };
+    const bench::Stats ws = stats(wake), ms = stats(all);
+    std::cout << "Wait: " << name
+              << " | wake-up ns p50=" << ws.median_ns << " p99=" << ws.p99_ns
+              << " | msg ns p50=" << ms.median_ns << " p99=" << ms.p99_ns
+              << " | consumer CPU: ";
+    if (cpu < 0.0)
+        std::cout << "n/a";
+    else
+        std::cout << (100.0 * cpu / secs) << " %";
+    std::cout << " | msgs: " << all.size() << "/" << bursts * burst
+              << " | notify() no waiter: " << notify_ns<Wait>(name) << " ns\n";
+    bench::record(std::string("spsc/wait/") + name + "/wake", ws, {{"cpu_pct", cpu < 0.0 ? -1.0 : 100.0 * cpu / secs}});
+    bench::record(std::string("spsc/wait/") + name + "/msg", ms);
+}
+
+int main(int argc, char **argv)
+{
+    // Usage: spsc [cap] [N] [batch] [heap|huge|huge-nopopulate]
+    //        spsc wait [bursts] [burst_len] [gap_us]
+    //        spsc payload [N]
+    //        spsc spacing [N] [batch]
+    // Defaults: sweep 1<<10 .. 1<<20, 20M items, batches of 64, std::allocator.
+    if (argc > 1 && std::strcmp(argv[1], "payload") == 0)
     {
-        return tail_.load(std::memory_order_acquire) ==
-               head_.load(std::memory_order_acquire);
+        run_payload_modes((argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 5000000ull);
+        return 0;
     }
-    bool full() const noexcept
+    if (argc > 1 && std::strcmp(argv[1], "spacing") == 0)
     {
-        std::size_t head = head_.load(std::memory_order_acquire);
-        std::size_t next = (head + 1) & MASK;
-        return next == tail_.load(std::memory_order_acquire);
+        const std::size_t n = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 20000000ull;
+        const std::size_t batch = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 64;
+        if (batch == 0)
+        {
+            std::cerr << "Batch size must be >= 1\n";
+            return 1;
+        }
+        run_spacing_modes(n, batch);
+        return 0;
     }
-
-    // Destroy any remaining elements. Call only when both threads are stopped.
-    void clear() noexcept
+    if (argc > 1 && std::strcmp(argv[1], "wait") == 0)
     {
-        std::size_t tail = tail_.load(std::memory_order_relaxed);
-        std::size_t head = head_.load(std::memory_order_relaxed);
-        while (tail != head)
+        const std::size_t bursts = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 2000;
+        const std::size_t burst = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 64;
+        const std::size_t gap_us = (argc > 4) ? std::strtoull(argv[4], nullptr, 10) : 200;
+        if (burst == 0)
         {
-            elem_ptr(tail)->~T();
-            tail = (tail + 1) & MASK;
+            std::cerr << "Burst length must be >= 1\n";
+            return 1;
         }
-        tail_.store(tail, std::memory_order_relaxed);
+        std::cout << "Bursts: " << bursts << " x " << burst << " msgs, gap " << gap_us << " us\n";
+        run_wait_bench<SpinWait>("spin", bursts, burst, gap_us);
+        run_wait_bench<YieldWait>("spin+yield", bursts, burst, gap_us);
+        run_wait_bench<ParkWait>("spin+park", bursts, burst, gap_us);
+        return 0;
     }
 
-private:
-    static constexpr std::size_t CAP = PowerOfTwoCapacity;
-    static constexpr std::size_t MASK = CAP - 1;
-    using storage_t = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
-
-    void *elem_addr(std::size_t i) { return &buf_[i]; }
-    T *elem_ptr(std::size_t i) { return reinterpret_cast<T *>(&buf_[i]); }
-
-    storage_t buf_[CAP];
-
-    // Written by producer; read by consumer
-    alignas(64) std::atomic<std::size_t> head_;
-    // Written by consumer; read by producer
-    alignas(64) std::atomic<std::size_t> tail_;
-};
-
-// --------------------------- Test / Benchmark ---------------------------
-int main(int argc, char **argv)
-{
-    typedef std::uint64_t value_t;
-
-    // Defaults: 1<<16 capacity, 20M items. You can tweak via args.
     const std::size_t CAP = (argc > 1) ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10))
-                                       : (1u << 16);
+                                       : 0;
     const std::size_t N = (argc > 2) ? static_cast<std::size_t>(std::strtoull(argv[2], nullptr, 10))
                                      : 20000000ull;
+    const std::size_t BATCH = (argc > 3) ? static_cast<std::size_t>(std::strtoull(argv[3], nullptr, 10))
+                                         : 64;
+    const char *storage = (argc > 4) ? argv[4] : "heap";
+    const bool sweep = (CAP == 0);
 
-    // Enforce power-of-two CAP from command line in this simple demo.
-    if ((CAP & (CAP - 1)) != 0 || CAP < 2)
+    // Capacity is a runtime value now, but the ring is still mask-indexed.
+    if (!sweep && ((CAP & (CAP - 1)) != 0 || CAP < 2))
     {
         std::cerr << "Capacity must be a power of two >= 2\n";
         return 1;
     }
-
-    // We can’t pass CAP as a runtime value to the template—so use a switch on a few common sizes,
-    // or just pick one at compile time. For flexibility, here’s a simple macro helper:
-#define RUN_WITH_CAP(CAPPOW2)                                                          \
-    if (CAP == (CAPPOW2))                                                              \
-    {                                                                                  \
-        std::unique_ptr<SPSCQueue<value_t, (CAPPOW2)>> q(                              \
-            new SPSCQueue<value_t, (CAPPOW2)>());                                      \
-        std::atomic<bool> go(false);                                                   \
-        std::atomic<std::size_t> produced(0), consumed(0);                             \
-        value_t sum = 0;                                                               \
-        std::thread prod([&] {                                                       \
-            while (!go.load(std::memory_order_acquire)) {}                           \
-            for (std::size_t i = 0; i < N; ++i) {                                    \
-                value_t v = static_cast<value_t>(i);                                 \
-                while (!q->try_push(v)) {}                                           \
-                produced.fetch_add(1, std::memory_order_relaxed);                    \
-            } });                                                     \
-        std::thread cons([&] {                                                       \
-            while (!go.load(std::memory_order_acquire)) {}                           \
-            value_t v;                                                               \
-            for (std::size_t i = 0; i < N; ++i) {                                    \
-                while (!q->try_pop(v)) {}                                            \
-                sum += v;                                                            \
-                consumed.fetch_add(1, std::memory_order_relaxed);                    \
-            } });                                                     \
-        auto t0 = std::chrono::steady_clock::now();                                    \
-        go.store(true, std::memory_order_release);                                     \
-        prod.join();                                                                   \
-        cons.join();                                                                   \
-        auto t1 = std::chrono::steady_clock::now();                                    \
-        const double secs = std::chrono::duration<double>(t1 - t0).count();            \
-        const unsigned long long expected = (unsigned long long)N * (N - 1ull) / 2;    \
-        std::cout << "Capacity: " << (CAPPOW2) << " | N: " << N                        \
-                  << " | time: " << secs << " s\n";                                    \
-        std::cout << "Throughput: " << (static_cast<double>(N) / secs) << " msgs/s\n"; \
-        std::cout << "Checksum OK? " << (sum == expected ? "yes" : "NO") << "\n";      \
-        return 0;                                                                      \
+    if (BATCH == 0)
+    {
+        std::cerr << "Batch size must be >= 1\n";
+        return 1;
     }
 
-    // Support a few common power-of-two sizes conveniently
-    RUN_WITH_CAP(1u << 10)
-    RUN_WITH_CAP(1u << 12)
-    RUN_WITH_CAP(1u << 14)
-    RUN_WITH_CAP(1u << 16)
-    RUN_WITH_CAP(1u << 18)
-    RUN_WITH_CAP(1u << 20)
-
-    std::cerr << "Unsupported CAP for this demo. Recompile or add to the list.\n";
-    return 2;
+    const std::size_t lo = sweep ? (std::size_t(1) << 10) : CAP;
+    const std::size_t hi = sweep ? (std::size_t(1) << 20) : CAP;
+    for (std::size_t cap = lo; cap <= hi; cap <<= 2)
+    {
+        if (std::strcmp(storage, "heap") == 0)
+            run_cap(cap, std::allocator<value_t>(), storage, N, BATCH);
+        else if (std::strcmp(storage, "huge") == 0)
+            run_cap(cap, HugePageAllocator<value_t>(true, true), storage, N, BATCH);
+        else if (std::strcmp(storage, "huge-nopopulate") == 0)
+            run_cap(cap, HugePageAllocator<value_t>(true, false), storage, N, BATCH);
+        else
+        {
+            std::cerr << "Unknown storage '" << storage << "' (heap|huge|huge-nopopulate)\n";
+            return 1;
+        }
+    }
+    return 0;
 }
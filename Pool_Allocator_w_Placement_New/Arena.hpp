@@ -0,0 +1,267 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Monotonic (bump-pointer) arena for per-request scratch data.
+//
+// allocate() carves bytes from the current block in O(1); nothing is freed
+// individually. reset() releases everything at once: registered destructors
+// run (newest first) and the bump pointer rewinds to the first block. Blocks
+// are kept and reused by the next request, so a steady-state request loop
+// does no heap allocation at all. Requests larger than a block get a block
+// of their own, which is returned to the heap on reset(), or by the rewind
+// (Scope) back past the point where it was allocated.
+//
+// Scope gives the same rewind for a nested region:
+//   { Arena::Scope s(arena); ...temporary allocations... } // rewound here
+class Arena
+{
+public:
+    static constexpr std::size_t kDefaultBlock = 64 * 1024;
+
+    explicit Arena(std::size_t block_size = kDefaultBlock) noexcept
+        : _block_size(block_size)
+    {
+    }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    Arena(Arena &&) = delete;
+    Arena &operator=(Arena &&) = delete;
+
+    ~Arena() noexcept
+    {
+        run_dtors(nullptr);
+        Block *b = _first;
+        while (b != nullptr)
+        {
+            Block *next = b->next;
+            ::operator delete(b);
+            b = next;
+        }
+    }
+
+    // Uninitialised storage for 'bytes' bytes aligned to 'align' (a power of two).
+    void *allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t))
+    {
+        assert(align != 0 && (align & (align - 1)) == 0);
+        if (_cur != nullptr)
+        {
+            std::size_t off = align_up(_offset, _cur, align);
+            if (off + bytes <= _cur->size)
+            {
+                _offset = off + bytes;
+                return _cur->data() + off;
+            }
+        }
+        return allocate_slow(bytes, align);
+    }
+
+    // Uninitialised array of n T's.
+    template <class T>
+    T *allocate_array(std::size_t n)
+    {
+        return static_cast<T *>(allocate(n * sizeof(T), alignof(T)));
+    }
+
+    // Constructs a T in the arena. Non-trivially-destructible types get their
+    // destructor registered so reset() (or the enclosing Scope) runs it.
+    template <class T, class... Args>
+    T *create(Args &&...args)
+    {
+        if constexpr (std::is_trivially_destructible<T>::value)
+        {
+            return ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+        else
+        {
+            // Reserve the record first so a throwing ctor leaves nothing half-registered.
+            Dtor *d = static_cast<Dtor *>(allocate(sizeof(Dtor), alignof(Dtor)));
+            T *p = ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            d->fn = [](void *o) noexcept
+            { static_cast<T *>(o)->~T(); };
+            d->obj = p;
+            d->prev = _dtors;
+            _dtors = d;
+            return p;
+        }
+    }
+
+    // Position in the arena that rewind() can return to.
+    struct Marker
+    {
+        void *block;
+        std::size_t offset;
+        void *dtors;
+    };
+
+    Marker mark() const noexcept { return Marker{_cur, _offset, _dtors}; }
+
+    // Destroys everything created after m and makes its memory reusable;
+    // oversized blocks taken since m go back to the heap.
+    void rewind(const Marker &m) noexcept
+    {
+        run_dtors(static_cast<Dtor *>(m.dtors));
+        Block *at = static_cast<Block *>(m.block);
+        release_oversized(at);
+        if (at == nullptr)
+        {
+            _cur = _first;
+            _offset = 0;
+        }
+        else
+        {
+            _cur = at;
+            _offset = m.offset;
+        }
+    }
+
+    // End of request: destroy everything, keep the regular blocks.
+    void reset() noexcept
+    {
+        run_dtors(nullptr);
+        release_oversized(nullptr);
+        _cur = _first;
+        _offset = 0;
+    }
+
+    // RAII rewind to the position at construction.
+    class Scope
+    {
+    public:
+        explicit Scope(Arena &a) noexcept : _arena(a), _mark(a.mark()) {}
+        ~Scope() { _arena.rewind(_mark); }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        Arena &_arena;
+        Marker _mark;
+    };
+
+    // Bytes obtained from the heap (all blocks).
+    std::size_t bytes_reserved() const noexcept
+    {
+        std::size_t total = 0;
+        for (Block *b = _first; b != nullptr; b = b->next)
+            total += b->size;
+        return total;
+    }
+
+    std::size_t block_count() const noexcept
+    {
+        std::size_t n = 0;
+        for (Block *b = _first; b != nullptr; b = b->next)
+            ++n;
+        return n;
+    }
+
+private:
+    struct alignas(std::max_align_t) Block
+    {
+        Block *next;
+        std::size_t size; // usable bytes after the header
+        bool oversized;
+
+        char *data() noexcept { return reinterpret_cast<char *>(this + 1); }
+    };
+
+    struct Dtor
+    {
+        void (*fn)(void *) noexcept;
+        void *obj;
+        Dtor *prev;
+    };
+
+    static std::size_t align_up(std::size_t off, Block *b, std::size_t align) noexcept
+    {
+        auto addr = reinterpret_cast<std::uintptr_t>(b->data()) + off;
+        auto aligned = (addr + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1);
+        return off + static_cast<std::size_t>(aligned - addr);
+    }
+
+    void *allocate_slow(std::size_t bytes, std::size_t align)
+    {
+        // Worst-case padding if the block data isn't already 'align'-aligned.
+        const std::size_t need = bytes + (align > alignof(Block) ? align : 0);
+
+        // Reuse blocks kept from an earlier request before going to the heap.
+        Block *b = (_cur != nullptr) ? _cur->next : _first;
+        while (b != nullptr && !b->oversized)
+        {
+            if (need <= b->size)
+                break;
+            b = b->next;
+        }
+        if (b == nullptr || b->oversized)
+        {
+            const bool oversized = need > _block_size;
+            b = new_block(oversized ? need : _block_size, oversized);
+        }
+        _cur = b;
+        std::size_t off = align_up(0, b, align);
+        _offset = off + bytes;
+        return b->data() + off;
+    }
+
+    // Links a new block right after the current one so the chain stays in
+    // allocation order (Marker positions remain comparable).
+    Block *new_block(std::size_t size, bool oversized)
+    {
+        void *mem = ::operator new(sizeof(Block) + size);
+        Block *b = ::new (mem) Block{nullptr, size, oversized};
+        if (_cur == nullptr)
+        {
+            b->next = _first;
+            _first = b;
+        }
+        else
+        {
+            b->next = _cur->next;
+            _cur->next = b;
+        }
+        return b;
+    }
+
+    // Frees the oversized blocks after `after` in the chain (all of them for
+    // nullptr). No oversized block ever sits after _cur, so after a marker's
+    // block they are exactly the ones allocated since the marker.
+    void release_oversized(Block *after) noexcept
+    {
+        Block **link = (after != nullptr) ? &after->next : &_first;
+        while (*link != nullptr)
+        {
+            Block *b = *link;
+            if (b->oversized)
+            {
+                *link = b->next;
+                ::operator delete(b);
+            }
+            else
+            {
+                link = &b->next;
+            }
+        }
+    }
+
+    void run_dtors(Dtor *stop) noexcept
+    {
+        while (_dtors != stop)
+        {
+            Dtor *d = _dtors;
+            _dtors = d->prev;
+            d->fn(d->obj);
+        }
+    }
+
+    std::size_t _block_size;
+    Block *_first = nullptr;
+    Block *_cur = nullptr;
+    std::size_t _offset = 0;
+    Dtor *_dtors = nullptr;
+};
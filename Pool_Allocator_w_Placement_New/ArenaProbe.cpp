@@ -0,0 +1,225 @@
+#include "Arena.hpp"
+
+#include "bench/Harness.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct Probe
+{
+    static int live, ctors, dtors;
+    std::string s;
+    explicit Probe(const char *x = "") : s(x)
+    {
+        ++live;
+        ++ctors;
+    }
+    ~Probe() noexcept
+    {
+        --live;
+        ++dtors;
+    }
+};
+int Probe::live = 0, Probe::ctors = 0, Probe::dtors = 0;
+
+struct Suite
+{
+    static void alignment()
+    {
+        Arena a(1024);
+        for (std::size_t align = 1; align <= 256; align <<= 1)
+        {
+            a.allocate(3, 1); // knock the bump pointer off alignment
+            void *p = a.allocate(24, align);
+            assert(reinterpret_cast<std::uintptr_t>(p) % align == 0);
+            (void)p;
+        }
+    }
+
+    static void destructors_on_reset()
+    {
+        Arena a;
+        a.create<Probe>("a");
+        a.create<Probe>("b");
+        auto *pod = a.create<int>(7); // trivially destructible: nothing registered
+        assert(*pod == 7);
+        assert(Probe::live == 2);
+        a.reset();
+        assert(Probe::live == 0 && Probe::ctors == Probe::dtors);
+        (void)pod;
+    }
+
+    static void reuse_after_reset()
+    {
+        Arena a(4096);
+        void *first = a.allocate(64);
+        for (int i = 0; i < 100; ++i)
+            a.allocate(100); // spills into more blocks
+        const std::size_t blocks = a.block_count();
+        assert(blocks > 1);
+        a.reset();
+        assert(a.allocate(64) == first); // rewound to the first block
+        for (int i = 0; i < 100; ++i)
+            a.allocate(100);
+        assert(a.block_count() == blocks); // kept blocks were reused
+        (void)first;
+        (void)blocks;
+    }
+
+    static void scope_rewind()
+    {
+        Arena a;
+        a.create<Probe>("outer");
+        void *before = a.allocate(8, 8);
+        {
+            Arena::Scope s(a);
+            a.create<Probe>("inner");
+            a.allocate(1000);
+            assert(Probe::live == 2);
+        }
+        assert(Probe::live == 1); // only the inner object died
+        assert(a.allocate(8, 8) == static_cast<char *>(before) + 8); // memory reused
+        a.reset();
+        assert(Probe::live == 0);
+        (void)before;
+    }
+
+    static void oversized()
+    {
+        Arena a(1024);
+        char *big = static_cast<char *>(a.allocate(1 << 20));
+        std::memset(big, 0xAB, 1 << 20);
+        void *small = a.allocate(16);
+        assert(small != nullptr);
+        a.reset();
+        assert(a.bytes_reserved() < (1 << 20)); // oversized block handed back
+        (void)small;
+    }
+
+    // A per-request Scope around an oversized allocation: its block goes back
+    // at the end of each scope, so blocks and bytes don't pile up.
+    static void oversized_in_scopes()
+    {
+        Arena a(4096);
+        a.allocate(100);
+        std::size_t blocks = 0, reserved = 0;
+        for (int i = 0; i < 100; ++i)
+        {
+            {
+                Arena::Scope s(a);
+                char *big = static_cast<char *>(a.allocate(64 * 1024));
+                big[0] = 1;
+                a.allocate(3000); // a regular block after the oversized one
+            }
+            if (i == 0)
+            {
+                blocks = a.block_count();
+                reserved = a.bytes_reserved();
+            }
+            assert(a.block_count() == blocks && a.bytes_reserved() == reserved);
+            assert(reserved < 64 * 1024);
+        }
+        (void)blocks;
+        (void)reserved;
+    }
+};
+
+// ---------------- Request-shaped benchmark ----------------
+// Each "request" allocates a mix of small scratch objects (headers, tokens,
+// small arrays) and drops them all at the end: malloc/free per object vs one
+// Arena::reset() per request. Each timed run is kRequests requests.
+
+static constexpr std::size_t kRequests = 20000;
+static constexpr std::size_t kAllocsPerRequest = 64;
+
+static std::size_t request_size(std::size_t i)
+{
+    static const std::size_t sizes[] = {16, 24, 32, 48, 64, 96, 128, 256, 40, 512};
+    return sizes[i % (sizeof(sizes) / sizeof(sizes[0]))];
+}
+
+// Times f() (kRequests requests) and records it; ns per request.
+template <class F>
+static double ns_per_request(const char *name, F &&f)
+{
+    const bench::Stats st = bench::measure(f);
+    const double ns = st.median_ns / static_cast<double>(kRequests);
+    bench::record(std::string("arena_probe/") + name, st, {{"ns_per_request", ns}});
+    return ns;
+}
+
+static void bench_requests()
+{
+    double t_malloc = ns_per_request("malloc_free", [&]
+                                     {
+        void *ptrs[kAllocsPerRequest];
+        for (std::size_t r = 0; r < kRequests; ++r) {
+            for (std::size_t i = 0; i < kAllocsPerRequest; ++i) {
+                ptrs[i] = std::malloc(request_size(r + i));
+                static_cast<char *>(ptrs[i])[0] = 1;
+            }
+            bench::do_not_optimize(ptrs[r % kAllocsPerRequest]);
+            for (std::size_t i = 0; i < kAllocsPerRequest; ++i)
+                std::free(ptrs[i]);
+        } });
+
+    Arena arena;
+    double t_arena = ns_per_request("arena", [&]
+                                    {
+        for (std::size_t r = 0; r < kRequests; ++r) {
+            void *last = nullptr;
+            for (std::size_t i = 0; i < kAllocsPerRequest; ++i) {
+                last = arena.allocate(request_size(r + i));
+                static_cast<char *>(last)[0] = 1;
+            }
+            bench::do_not_optimize(last);
+            arena.reset();
+        } });
+
+    double t_strings_heap = ns_per_request("strings_new_delete", [&]
+                                           {
+        for (std::size_t r = 0; r < kRequests; ++r) {
+            std::vector<std::string *> v;
+            v.reserve(8);
+            for (int i = 0; i < 8; ++i)
+                v.push_back(new std::string(40, 'x'));
+            bench::do_not_optimize(v[r % 8]->size());
+            for (auto *s : v)
+                delete s;
+        } });
+
+    double t_strings_arena = ns_per_request("strings_arena", [&]
+                                            {
+        for (std::size_t r = 0; r < kRequests; ++r) {
+            std::string *last = nullptr;
+            for (int i = 0; i < 8; ++i)
+                last = arena.create<std::string>(40, 'x');
+            bench::do_not_optimize(last->size());
+            arena.reset(); // runs the 8 registered destructors
+        } });
+
+    std::cout << "requests per run: " << kRequests << " | allocations/request: " << kAllocsPerRequest << "\n"
+              << "raw blocks   malloc/free: " << t_malloc << " ns/request"
+              << " | Arena: " << t_arena << " ns/request"
+              << " | speedup: " << (t_malloc / t_arena) << "x\n"
+              << "8 x string   new/delete:  " << t_strings_heap << " ns/request"
+              << " | Arena::create: " << t_strings_arena << " ns/request\n"
+              << "arena blocks kept: " << arena.block_count() << " (" << arena.bytes_reserved() << " bytes)\n";
+}
+
+int main()
+{
+    Suite::alignment();
+    Suite::destructors_on_reset();
+    Suite::reuse_after_reset();
+    Suite::scope_rewind();
+    Suite::oversized();
+    Suite::oversized_in_scopes();
+    bench_requests();
+    return 0;
+}
@@ -0,0 +1,384 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+// Thread-safe, growable counterpart of ObjectPool.
+//
+// Storage is a list of ChunkBytes-sized chunks, each aligned to its own size
+// so destroy() can find a slot's chunk by masking the pointer. Free slots are
+// linked intrusively (the link lives in the slot itself) and handed around in
+// batches ("magazines") of up to MagazineSize slots:
+//   - each thread keeps a private magazine; create/destroy normally touch
+//     only that, with no atomics at all;
+//   - an empty magazine is refilled with one CAS from a shared lock-free
+//     stack of batches; a magazine that grows to 2x MagazineSize gives half
+//     back the same way;
+//   - when the shared stack is empty a new chunk is appended (under a mutex,
+//     the only lock on the hot path) instead of failing;
+//   - when a thread exits its magazines go back to the shared stack and its
+//     magazine number is reused by the next thread.
+// The shared stack head packs {slot index, tag} into 64 bits; the tag is
+// bumped on every update so a stale head can't win a CAS (ABA).
+//
+// Like ObjectPool, the destructor releases storage but does not destroy
+// objects that are still live.
+template <class T, std::size_t ChunkBytes = (1u << 16), std::size_t MagazineSize = 64>
+class ConcurrentObjectPool
+{
+public:
+    ConcurrentObjectPool() noexcept
+    {
+        for (auto &c : _chunks)
+            c = nullptr;
+        _overflow.guard = &_overflow_mutex;
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lk(r.mu);
+        _next_pool = r.pools;
+        if (r.pools != nullptr)
+            r.pools->_prev_pool = this;
+        r.pools = this;
+    }
+
+    ConcurrentObjectPool(const ConcurrentObjectPool &) = delete;
+    ConcurrentObjectPool &operator=(const ConcurrentObjectPool &) = delete;
+    ConcurrentObjectPool(ConcurrentObjectPool &&) = delete;
+    ConcurrentObjectPool &operator=(ConcurrentObjectPool &&) = delete;
+
+    ~ConcurrentObjectPool() noexcept
+    {
+        {
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lk(r.mu);
+            (_prev_pool != nullptr ? _prev_pool->_next_pool : r.pools) = _next_pool;
+            if (_next_pool != nullptr)
+                _next_pool->_prev_pool = _prev_pool;
+        }
+        const std::uint32_t n = _chunk_count.load(std::memory_order_acquire);
+        for (std::uint32_t i = 0; i < n; ++i)
+            ::operator delete(_chunks[i], std::align_val_t(ChunkBytes));
+    }
+
+    template <class... Args>
+    T *create(Args &&...args)
+    {
+        Magazine &mag = local_magazine();
+        std::uint32_t index = allocate_index(mag);
+        void *addr = slot_addr(index);
+        try
+        {
+            return ::new (addr) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            release_index(mag, index);
+            throw;
+        }
+    }
+
+    void destroy(T *p) noexcept(std::is_nothrow_destructible<T>::value)
+    {
+        assert(p != nullptr);
+        std::uint32_t index = index_from_ptr(p);
+        p->~T();
+        release_index(local_magazine(), index);
+    }
+
+    // Slots currently backed by chunks (grows, never shrinks).
+    std::size_t capacity() const noexcept
+    {
+        return static_cast<std::size_t>(_chunk_count.load(std::memory_order_acquire)) * kSlotsPerChunk;
+    }
+
+    static constexpr std::size_t slots_per_chunk() noexcept { return kSlotsPerChunk; }
+
+private:
+    // Free-slot view of a slot's bytes.
+    struct FreeLink
+    {
+        std::uint32_t next;                   // next slot in this batch
+        std::atomic<std::uint32_t> next_batch; // next batch on the shared stack
+    };
+
+    struct ChunkHeader
+    {
+        std::uint32_t id;
+    };
+
+    static constexpr std::size_t cmax(std::size_t a, std::size_t b) { return a > b ? a : b; }
+
+    static constexpr std::size_t kSlotAlign = cmax(alignof(T), alignof(FreeLink));
+    static constexpr std::size_t kSlotSize =
+        (cmax(sizeof(T), sizeof(FreeLink)) + kSlotAlign - 1) / kSlotAlign * kSlotAlign;
+    static constexpr std::size_t kHeaderBytes =
+        (sizeof(ChunkHeader) + kSlotAlign - 1) / kSlotAlign * kSlotAlign;
+    static constexpr std::size_t kSlotsPerChunk = (ChunkBytes - kHeaderBytes) / kSlotSize;
+    static constexpr std::size_t kMaxChunks = 4096;
+    static constexpr std::size_t kMaxThreads = 128;
+    static constexpr std::uint32_t kNil = 0xFFFFFFFFu;
+
+    static_assert((ChunkBytes & (ChunkBytes - 1)) == 0, "ChunkBytes must be a power of two");
+    static_assert(kSlotsPerChunk >= MagazineSize, "ChunkBytes too small for one magazine of T");
+    static_assert(MagazineSize > 0, "MagazineSize must be greater than 0");
+    static_assert(kMaxChunks * kSlotsPerChunk < kNil, "slot indices must fit in 32 bits");
+
+    // A thread's private chain of free slots.
+    struct alignas(64) Magazine
+    {
+        std::uint32_t head = kNil;
+        std::uint32_t count = 0;
+        std::mutex *guard = nullptr; // set only for the shared overflow magazine
+    };
+
+    static std::uint64_t pack(std::uint32_t index, std::uint32_t tag) noexcept
+    {
+        return (static_cast<std::uint64_t>(tag) << 32) | index;
+    }
+    static std::uint32_t index_of(std::uint64_t v) noexcept { return static_cast<std::uint32_t>(v); }
+    static std::uint32_t tag_of(std::uint64_t v) noexcept { return static_cast<std::uint32_t>(v >> 32); }
+
+    char *chunk_base(std::uint32_t c) const noexcept { return _chunks[c]; }
+
+    void *slot_addr(std::uint32_t index) const noexcept
+    {
+        std::uint32_t c = index / kSlotsPerChunk;
+        std::uint32_t off = index % kSlotsPerChunk;
+        return chunk_base(c) + kHeaderBytes + off * kSlotSize;
+    }
+
+    FreeLink *link(std::uint32_t index) const noexcept
+    {
+        return static_cast<FreeLink *>(slot_addr(index));
+    }
+
+    std::uint32_t index_from_ptr(const T *p) const noexcept
+    {
+        auto addr = reinterpret_cast<std::uintptr_t>(static_cast<const void *>(p));
+        auto base = addr & ~(static_cast<std::uintptr_t>(ChunkBytes) - 1);
+        const ChunkHeader *h = reinterpret_cast<const ChunkHeader *>(base);
+        std::uintptr_t bytes = addr - base - kHeaderBytes;
+        assert(bytes % kSlotSize == 0);
+        assert(_chunks[h->id] == reinterpret_cast<const char *>(base));
+        return static_cast<std::uint32_t>(h->id * kSlotsPerChunk + bytes / kSlotSize);
+    }
+
+    // Shared by every pool of this type: the live pools, and the magazine
+    // numbers not held by a running thread.
+    struct Registry
+    {
+        std::mutex mu;
+        ConcurrentObjectPool *pools = nullptr;
+        std::uint32_t next_id = 0;
+        std::uint32_t free_count = 0;
+        std::uint32_t free_ids[kMaxThreads];
+    };
+
+    static Registry &registry() noexcept
+    {
+        static Registry r;
+        return r;
+    }
+
+    // Holds a thread's magazine number (kMaxThreads: the overflow magazine)
+    // for the thread's lifetime. On exit the thread's magazine in every live
+    // pool is flushed to the shared stack before the number is handed out
+    // again, so dead threads neither strand slots nor use up numbers.
+    struct ThreadSlot
+    {
+        std::uint32_t id;
+
+        ThreadSlot() noexcept
+        {
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lk(r.mu);
+            if (r.free_count > 0)
+                id = r.free_ids[--r.free_count];
+            else
+                id = r.next_id < kMaxThreads ? r.next_id++ : static_cast<std::uint32_t>(kMaxThreads);
+        }
+
+        ~ThreadSlot()
+        {
+            if (id >= kMaxThreads)
+                return;
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lk(r.mu);
+            for (ConcurrentObjectPool *p = r.pools; p != nullptr; p = p->_next_pool)
+                p->flush(p->_magazines[id]);
+            r.free_ids[r.free_count++] = id;
+        }
+    };
+
+    static std::uint32_t thread_number() noexcept
+    {
+        thread_local ThreadSlot slot;
+        return slot.id;
+    }
+
+    Magazine &local_magazine() noexcept
+    {
+        std::uint32_t id = thread_number();
+        if (id < kMaxThreads)
+            return _magazines[id];
+        return _overflow; // beyond kMaxThreads threads share one guarded magazine
+    }
+
+    std::uint32_t allocate_index(Magazine &mag)
+    {
+        if (mag.guard)
+        {
+            std::lock_guard<std::mutex> lk(*mag.guard);
+            return allocate_local(mag);
+        }
+        return allocate_local(mag);
+    }
+
+    void release_index(Magazine &mag, std::uint32_t index) noexcept
+    {
+        if (mag.guard)
+        {
+            std::lock_guard<std::mutex> lk(*mag.guard);
+            release_local(mag, index);
+            return;
+        }
+        release_local(mag, index);
+    }
+
+    std::uint32_t allocate_local(Magazine &mag)
+    {
+        if (mag.head == kNil)
+            refill(mag);
+        std::uint32_t index = mag.head;
+        mag.head = link(index)->next;
+        --mag.count;
+        return index;
+    }
+
+    void release_local(Magazine &mag, std::uint32_t index) noexcept
+    {
+        FreeLink *l = ::new (slot_addr(index)) FreeLink;
+        l->next = mag.head;
+        mag.head = index;
+        if (++mag.count >= 2 * MagazineSize)
+        {
+            // Give the first MagazineSize slots back as one batch.
+            std::uint32_t batch = mag.head;
+            std::uint32_t tail = batch;
+            for (std::size_t i = 1; i < MagazineSize; ++i)
+                tail = link(tail)->next;
+            mag.head = link(tail)->next;
+            link(tail)->next = kNil;
+            mag.count -= static_cast<std::uint32_t>(MagazineSize);
+            push_batch(batch);
+        }
+    }
+
+    // Every slot in mag back to the shared stack, in batches of at most
+    // MagazineSize.
+    void flush(Magazine &mag) noexcept
+    {
+        while (mag.head != kNil)
+        {
+            std::uint32_t batch = mag.head;
+            std::uint32_t tail = batch;
+            for (std::size_t i = 1; i < MagazineSize && link(tail)->next != kNil; ++i)
+                tail = link(tail)->next;
+            mag.head = link(tail)->next;
+            link(tail)->next = kNil;
+            push_batch(batch);
+        }
+        mag.count = 0;
+    }
+
+    void refill(Magazine &mag)
+    {
+        std::uint32_t batch = pop_batch();
+        if (batch == kNil)
+            batch = grow();
+        std::uint32_t n = 0;
+        for (std::uint32_t i = batch; i != kNil; i = link(i)->next)
+            ++n;
+        mag.head = batch;
+        mag.count = n;
+    }
+
+    void push_batch(std::uint32_t batch) noexcept
+    {
+        FreeLink *l = link(batch);
+        std::uint64_t old = _central.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            l->next_batch.store(index_of(old), std::memory_order_relaxed);
+            if (_central.compare_exchange_weak(old, pack(batch, tag_of(old) + 1),
+                                               std::memory_order_release, std::memory_order_relaxed))
+                return;
+        }
+    }
+
+    std::uint32_t pop_batch() noexcept
+    {
+        std::uint64_t old = _central.load(std::memory_order_acquire);
+        for (;;)
+        {
+            std::uint32_t top = index_of(old);
+            if (top == kNil)
+                return kNil;
+            // May read a slot another thread just took; the tag makes that CAS fail.
+            std::uint32_t next = link(top)->next_batch.load(std::memory_order_relaxed);
+            if (_central.compare_exchange_weak(old, pack(next, tag_of(old) + 1),
+                                               std::memory_order_acquire, std::memory_order_acquire))
+                return top;
+        }
+    }
+
+    // Appends a chunk; returns a batch for the caller, pushes the rest.
+    std::uint32_t grow()
+    {
+        std::lock_guard<std::mutex> lk(_grow_mutex);
+
+        // Someone else may have grown while we waited for the lock.
+        std::uint32_t batch = pop_batch();
+        if (batch != kNil)
+            return batch;
+
+        std::uint32_t c = _chunk_count.load(std::memory_order_relaxed);
+        if (c >= kMaxChunks)
+            throw std::bad_alloc();
+
+        char *mem = static_cast<char *>(::operator new(ChunkBytes, std::align_val_t(ChunkBytes)));
+        ::new (mem) ChunkHeader{c};
+        _chunks[c] = mem;
+        _chunk_count.store(c + 1, std::memory_order_release);
+
+        // Carve the chunk into batches of MagazineSize linked slots.
+        const std::uint32_t first = static_cast<std::uint32_t>(c * kSlotsPerChunk);
+        const std::uint32_t end = static_cast<std::uint32_t>(first + kSlotsPerChunk);
+        for (std::uint32_t i = first; i < end; ++i)
+        {
+            FreeLink *l = ::new (slot_addr(i)) FreeLink;
+            bool batch_end = ((i - first + 1) % MagazineSize == 0) || (i + 1 == end);
+            l->next = batch_end ? kNil : i + 1;
+            l->next_batch.store(kNil, std::memory_order_relaxed);
+        }
+        for (std::uint32_t b = first + MagazineSize; b < end; b += MagazineSize)
+            push_batch(b);
+        return first;
+    }
+
+    Magazine _magazines[kMaxThreads];
+    Magazine _overflow;
+    std::mutex _overflow_mutex;
+
+    alignas(64) std::atomic<std::uint64_t> _central{pack(kNil, 0)};
+
+    alignas(64) std::mutex _grow_mutex;
+    std::atomic<std::uint32_t> _chunk_count{0};
+    char *_chunks[kMaxChunks];
+
+    ConcurrentObjectPool *_prev_pool = nullptr, *_next_pool = nullptr; // Registry::pools
+};
@@ -0,0 +1,152 @@
+#include "ConcurrentObjectPool.hpp"
+
+#include "bench/Harness.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Multi-threaded alloc/free throughput: ConcurrentObjectPool vs new/delete vs
+// std::pmr::synchronized_pool_resource. Each thread repeatedly allocates a
+// burst of order-book-sized nodes, then frees them in a scrambled order.
+// Threads are pinned and released together from a start gate; each row is
+// one warm-up and BENCH_REPS timed runs (default 3) on the same allocator.
+//
+// Usage: pool_bench [rounds] [burst] [max_threads]
+
+struct OrderNode
+{
+    std::uint64_t id;
+    std::int64_t price;
+    std::int64_t qty;
+    OrderNode *prev, *next;
+    std::uint32_t flags;
+    OrderNode(std::uint64_t i, std::int64_t p, std::int64_t q) noexcept
+        : id(i), price(p), qty(q), prev(nullptr), next(nullptr), flags(0) {}
+};
+
+struct NewDelete
+{
+    OrderNode *create(std::uint64_t i) { return new OrderNode(i, 1, 1); }
+    void destroy(OrderNode *p) { delete p; }
+};
+
+struct PmrSync
+{
+    std::pmr::synchronized_pool_resource res;
+    OrderNode *create(std::uint64_t i)
+    {
+        void *p = res.allocate(sizeof(OrderNode), alignof(OrderNode));
+        return ::new (p) OrderNode(i, 1, 1);
+    }
+    void destroy(OrderNode *p)
+    {
+        p->~OrderNode();
+        res.deallocate(p, sizeof(OrderNode), alignof(OrderNode));
+    }
+};
+
+struct Pool
+{
+    ConcurrentObjectPool<OrderNode> pool;
+    OrderNode *create(std::uint64_t i) { return pool.create(i, 1, 1); }
+    void destroy(OrderNode *p) { pool.destroy(p); }
+};
+
+// One gated run, in ns per op (alloc + free each count as one).
+template <class Alloc>
+static double run_once(Alloc &a, unsigned threads, std::size_t rounds, std::size_t burst)
+{
+    std::atomic<unsigned> ready(0);
+    std::atomic<bool> go(false);
+    std::atomic<std::uint64_t> check(0);
+    std::vector<std::thread> ts;
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        ts.emplace_back([&, t]
+                        {
+            bench::pin_this_thread(bench::nth_cpu(t));
+            std::vector<OrderNode *> live(burst);
+            std::uint64_t sum = 0;
+            ready.fetch_add(1, std::memory_order_release);
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield(); // more threads than CPUs must still all arrive
+            for (std::size_t r = 0; r < rounds; ++r) {
+                for (std::size_t k = 0; k < burst; ++k)
+                    live[k] = a.create(t * rounds + r + k);
+                // stride through the burst so frees don't mirror allocation order
+                for (std::size_t k = 0, j = 0; k < burst; ++k, j = (j + 7) % burst) {
+                    sum += live[j]->id;
+                    a.destroy(live[j]);
+                }
+            }
+            check.fetch_add(sum, std::memory_order_relaxed); });
+    }
+    while (ready.load(std::memory_order_acquire) < threads)
+        std::this_thread::yield();
+    const std::int64_t t0 = bench::now_ns();
+    go.store(true, std::memory_order_release);
+    for (auto &th : ts)
+        th.join();
+    const double ns = static_cast<double>(bench::now_ns() - t0);
+    bench::do_not_optimize(check.load(std::memory_order_relaxed));
+    return ns / (2.0 * static_cast<double>(threads) * static_cast<double>(rounds * burst));
+}
+
+// Samples are ns per op, so the result is comparable across rounds/burst
+// settings (and a regression shows as a larger number). Returns M ops/s of
+// the median run.
+template <class Alloc>
+static double run(const std::string &name, Alloc &a, unsigned threads, std::size_t rounds, std::size_t burst)
+{
+    const bench::Options opt = bench::Options::from_env(3, 1);
+    for (std::size_t w = 0; w < opt.warmup_max; ++w)
+        run_once(a, threads, rounds, burst);
+    std::vector<double> ns;
+    for (std::size_t r = 0; r < opt.reps; ++r)
+        ns.push_back(run_once(a, threads, rounds, burst));
+    const bench::Stats st = bench::summarize(std::move(ns));
+    const double mops = 1e3 / st.median_ns;
+    bench::record("pool_bench/" + name + "/threads=" + std::to_string(threads), st, {{"mops", mops}});
+    return mops;
+}
+
+int main(int argc, char **argv)
+{
+    const std::size_t rounds = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 20000;
+    std::size_t burst = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 256;
+    unsigned max_threads = (argc > 3) ? static_cast<unsigned>(std::strtoul(argv[3], nullptr, 10))
+                                      : std::thread::hardware_concurrency();
+    if (max_threads == 0)
+        max_threads = 1;
+    // j = (j + 7) % burst visits every element only if gcd(7, burst) == 1
+    if (burst % 7 == 0)
+        ++burst;
+
+    std::cout << "rounds: " << rounds << " | burst: " << burst
+              << " | sizeof(OrderNode): " << sizeof(OrderNode) << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (unsigned th = 1; th <= max_threads; th *= 2)
+    {
+        NewDelete nd;
+        PmrSync pmr;
+        Pool pool;
+        double a = run("new_delete", nd, th, rounds, burst);
+        double b = run("pmr_synchronized", pmr, th, rounds, burst);
+        double c = run("concurrent_pool", pool, th, rounds, burst);
+        std::cout << "threads=" << std::setw(3) << th
+                  << " | new/delete: " << std::setw(8) << a << " Mops/s"
+                  << " | pmr::synchronized: " << std::setw(8) << b << " Mops/s"
+                  << " | ConcurrentObjectPool: " << std::setw(8) << c << " Mops/s"
+                  << " (slots: " << pool.pool.capacity() << ")\n";
+    }
+    return 0;
+}
@@ -1,11 +1,33 @@
+#pragma once
+
 #include <type_traits>
 #include <new>
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <cassert>
 #include <limits>
 
-template <class T, std::size_t N>
+#include "bench/CacheLine.hpp"
+
+// Where the freelist links live.
+//   Separate:         std::array<int, N> next to the slots (two cache lines
+//                     per create/destroy: the slot and its link)
+//   Intrusive:        the link is stored in the free slot itself
+//   IntrusiveAligned: intrusive, and every slot is padded to bench::kPadSize
+//                     (BENCH_PAD_BYTES) so objects used by different
+//                     threads never share a line
+// Intrusive layouts also hand out never-used slots from a bump index, so the
+// constructor doesn't have to touch the whole buffer.
+enum class PoolLayout
+{
+    Separate,
+    Intrusive,
+    IntrusiveAligned
+};
+
+template <class T, std::size_t N, PoolLayout Layout = PoolLayout::Separate>
 class ObjectPool
 {
 public:
@@ -13,11 +35,18 @@ public:
     {
         static_assert(N <= static_cast<std::size_t>(std::numeric_limits<int>::max()), "N too large for int-based freelist");
 
-        for (std::size_t i = 0; i < N - 1; ++i)
+        if constexpr (!kIntrusive)
         {
-            _next_free[i] = static_cast<int>(i + 1);
+            for (std::size_t i = 0; i < N - 1; ++i)
+            {
+                _next_free[i] = static_cast<int>(i + 1);
+            }
+            _next_free[N - 1] = _kEmpty; // Last slot points to no next free slot
+        }
+        else
+        {
+            _head = _kEmpty; // freelist starts empty; slots come from _untouched
         }
-        _next_free[N - 1] = _kEmpty; // Last slot points to no next free slot
     }
 
     ObjectPool(const ObjectPool &) = delete;
@@ -57,6 +86,58 @@ public:
         release_index(index); // Release the slot back to the pool
     }
 
+    // Constructs up to n objects from the same arguments and stores their
+    // addresses in out. Returns how many were created (fewer than n only when
+    // the pool runs out). If a constructor throws, the objects created by this
+    // call are destroyed again before the exception propagates.
+    template <class... Args>
+    std::size_t create_n(T **out, std::size_t n, const Args &...args)
+    {
+        std::size_t done = 0;
+        try
+        {
+            for (; done < n; ++done)
+            {
+                int index = allocate_index();
+                if (index == _kEmpty)
+                {
+                    break;
+                }
+                try
+                {
+                    out[done] = ::new (static_cast<void *>(ptr_from_index(index))) T(args...);
+                }
+                catch (...)
+                {
+                    release_index(index);
+                    throw;
+                }
+            }
+        }
+        catch (...)
+        {
+            destroy_n(out, done);
+            throw;
+        }
+        return done;
+    }
+
+    // Destroys n objects and splices their slots onto the freelist in one go.
+    void destroy_n(T *const *ps, std::size_t n) noexcept(std::is_nothrow_destructible<T>::value)
+    {
+        int head = _head;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            assert(ps[i] != nullptr);
+            int index = index_from_ptr(ps[i]);
+            ps[i]->~T();
+            set_next(index, head);
+            head = index;
+        }
+        _head = head;
+        _free_count += n;
+    }
+
     constexpr std::size_t capacity() const noexcept
     {
         return N;
@@ -67,13 +148,46 @@ public:
         return _free_count;
     }
 
+    // Raw slot API for allocator adapters: hands out / takes back slot storage
+    // without constructing or destroying a T.
+    void *allocate_slot() noexcept
+    {
+        int index = allocate_index();
+        return index == _kEmpty ? nullptr : ptr_from_index(index);
+    }
+
+    void deallocate_slot(void *p) noexcept
+    {
+        assert(owns(p));
+        release_index(index_from_ptr(static_cast<const T *>(p)));
+    }
+
+    bool owns(const void *p) const noexcept
+    {
+        auto base = reinterpret_cast<const char *>(static_cast<const void *>(&_buf[0]));
+        auto pc = static_cast<const char *>(p);
+        return pc >= base && pc < base + sizeof(_buf);
+    }
+
+    static constexpr std::size_t slot_size() noexcept
+    {
+        return sizeof(Slot);
+    }
+
 private:
-    using Slot = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+    static constexpr bool kIntrusive = Layout != PoolLayout::Separate;
+    static constexpr std::size_t kSlotAlign =
+        Layout == PoolLayout::IntrusiveAligned && alignof(T) < bench::kPadSize ? bench::kPadSize : alignof(T);
+    static constexpr std::size_t kSlotBytes =
+        kIntrusive && sizeof(T) < sizeof(int) ? sizeof(int) : sizeof(T);
+
+    using Slot = typename std::aligned_storage<kSlotBytes, kSlotAlign>::type;
 
     Slot _buf[N];
-    std::array<int, N> _next_free{};
+    std::array<int, kIntrusive ? 0 : N> _next_free{};
     int _head = 0;               // Initialize head to the first slot
     std::size_t _free_count = N; // All slots are initially free
+    std::size_t _untouched = 0;  // Intrusive: slots [_untouched, N) never handed out
     static constexpr int _kEmpty = -1;
 
     static_assert(N > 0, "Pool capacity N must be greater than 0");
@@ -108,7 +222,15 @@ private:
         }
 
         int index = _head;
-        _head = _next_free[index];
+        if constexpr (kIntrusive)
+        {
+            if (index == _kEmpty)
+            {
+                --_free_count;
+                return static_cast<int>(_untouched++);
+            }
+        }
+        _head = next_of(index);
         --_free_count;
 
         return index;
@@ -117,8 +239,34 @@ private:
     void release_index(int i)
     {
         assert(i >= 0 && i < static_cast<int>(N));
-        _next_free[i] = _head; // Link the released slot to the head
-        _head = i;             // Update head to the newly freed slot
-        ++_free_count;         // Increase free count
+        set_next(i, _head); // Link the released slot to the head
+        _head = i;          // Update head to the newly freed slot
+        ++_free_count;      // Increase free count
+    }
+
+    int next_of(int i)
+    {
+        if constexpr (kIntrusive)
+        {
+            int next;
+            std::memcpy(&next, &_buf[i], sizeof(int));
+            return next;
+        }
+        else
+        {
+            return _next_free[i];
+        }
+    }
+
+    void set_next(int i, int next)
+    {
+        if constexpr (kIntrusive)
+        {
+            std::memcpy(&_buf[i], &next, sizeof(int));
+        }
+        else
+        {
+            _next_free[i] = next;
+        }
     }
 };
\ No newline at end of file
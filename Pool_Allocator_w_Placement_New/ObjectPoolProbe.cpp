@@ -1,5 +1,14 @@
 #include "ObjectPool.hpp"
+#include "ConcurrentObjectPool.hpp"
+#include "SlotMap.hpp"
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <iostream>
+#include <stdexcept>
+
+#define BENCH_ALLOC_HOOKS
+#include "bench/AllocTracker.hpp"
 
 struct Probe
 {
@@ -10,6 +19,12 @@ struct Probe
         ++live;
         ++ctors;
     }
+    Probe(const Probe &o) noexcept : v(o.v)
+    {
+        ++live;
+        ++ctors;
+    }
+    Probe &operator=(const Probe &) noexcept = default;
     ~Probe() noexcept
     {
         --live;
@@ -18,6 +33,22 @@ struct Probe
 };
 int Probe::live = 0, Probe::ctors = 0, Probe::dtors = 0;
 
+// Move assignment throws while `fail` is set.
+struct Fragile
+{
+    static bool fail;
+    int v;
+    explicit Fragile(int x) : v(x) {}
+    Fragile &operator=(Fragile &&o)
+    {
+        if (fail)
+            throw std::runtime_error("move");
+        v = o.v;
+        return *this;
+    }
+};
+bool Fragile::fail = false;
+
 struct Suite
 {
     static constexpr int N = 1000;
@@ -74,10 +105,260 @@ struct Suite
     }
 };
 
+struct LayoutSuite
+{
+    // Same LIFO/exhaustion contract in every layout, plus the bulk calls.
+    template <PoolLayout L>
+    static void bulk_and_reuse()
+    {
+        constexpr int N = 100;
+        ObjectPool<Probe, N, L> pool;
+        Probe *ps[N + 1];
+        std::size_t made = pool.create_n(ps, N + 1, 5);
+        assert(made == N); // stops at capacity
+        assert(pool.free_slots() == 0 && Probe::live == N);
+        for (int i = 0; i < N; ++i)
+            assert(ps[i]->v == 5);
+
+        pool.destroy(ps[10]);
+        auto *d = pool.create(6); // LIFO reuse
+        assert(d == ps[10]);
+        ps[10] = d;
+
+        pool.destroy_n(ps, N);
+        assert(pool.free_slots() == N && Probe::live == 0);
+        if (L == PoolLayout::IntrusiveAligned)
+            assert(pool.slot_size() % 64 == 0);
+        (void)made;
+        (void)d;
+    }
+};
+
+struct ConcurrentSuite
+{
+    // Runs past the first chunk: the pool must grow instead of returning nullptr.
+    static void growth()
+    {
+        ConcurrentObjectPool<Probe, 4096, 16> pool;
+        const std::size_t n = 3 * pool.slots_per_chunk() + 1;
+        std::vector<Probe *> ps;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            auto *p = pool.create(static_cast<int>(i));
+            assert(p != nullptr);
+            ps.push_back(p);
+        }
+        assert(pool.capacity() >= n);
+        for (std::size_t i = 0; i < n; ++i)
+            assert(ps[i]->v == static_cast<int>(i));
+        for (auto *p : ps)
+            pool.destroy(p);
+        assert(Probe::live == 0 && Probe::ctors == Probe::dtors);
+    }
+
+    // Objects created on worker threads, verified and destroyed on main.
+    static void cross_thread_free()
+    {
+        struct Item
+        {
+            int owner, seq;
+        };
+        ConcurrentObjectPool<Item, 4096, 16> pool;
+        std::vector<Item *> all;
+        std::mutex mu;
+        std::vector<std::thread> ts;
+        for (int t = 0; t < 4; ++t)
+        {
+            ts.emplace_back([&, t]
+                            {
+                std::vector<Item *> mine;
+                for (int i = 0; i < 5000; ++i)
+                    mine.push_back(pool.create(Item{t, i}));
+                std::lock_guard<std::mutex> lk(mu);
+                all.insert(all.end(), mine.begin(), mine.end()); });
+        }
+        for (auto &t : ts)
+            t.join();
+        std::vector<int> next(4, 0);
+        for (auto *p : all)
+        {
+            assert(p->seq == next[p->owner]++); // no slot handed out twice
+            pool.destroy(p);
+        }
+        // Freed slots are reused rather than growing the pool again.
+        const std::size_t cap = pool.capacity();
+        for (int i = 0; i < 1000; ++i)
+            pool.destroy(pool.create(Item{0, i}));
+        assert(pool.capacity() == cap);
+        (void)cap;
+    }
+
+    // Many more short-lived threads than there are magazines, a few at a
+    // time: exited threads give their slots and magazine numbers back, so
+    // the pool stays at the size a few live threads need.
+    static void thread_churn()
+    {
+        ConcurrentObjectPool<Probe, 4096, 16> pool;
+        auto wave = [&]
+        {
+            std::vector<std::thread> ts;
+            for (int t = 0; t < 4; ++t)
+                ts.emplace_back([&]
+                                {
+                    std::vector<Probe *> mine;
+                    for (int i = 0; i < 40; ++i) // leaves a part-full magazine behind
+                        mine.push_back(pool.create(i));
+                    for (auto *p : mine)
+                        pool.destroy(p); });
+            for (auto &t : ts)
+                t.join();
+        };
+        wave();
+        const std::size_t cap = pool.capacity();
+        for (int w = 0; w < 100; ++w) // 400 threads in all
+            wave();
+        assert(pool.capacity() == cap);
+        assert(Probe::live == 0 && Probe::ctors == Probe::dtors);
+        (void)cap;
+    }
+};
+
+struct SlotMapSuite
+{
+    // Stale handles are rejected after their slot is reused.
+    static void generations()
+    {
+        SlotMap<Probe, 200> m;
+        std::vector<Handle> hs;
+        for (int i = 0; i < 200; ++i)
+            hs.push_back(m.create(i));
+        assert(m.create(0) == kNullHandle); // full
+        Handle old = hs[70];
+        assert(m.destroy(old));
+        assert(!m.destroy(old) && m.get(old) == nullptr);
+        Handle fresh = m.create(7);
+        assert(fresh.index == old.index && fresh != old);
+        assert(m.get(fresh)->v == 7 && m.get(old) == nullptr);
+
+        // Leave every third object live; iteration sees exactly those.
+        for (int i = 0; i < 200; ++i)
+            if (i % 3 != 0 && i != 70)
+                m.destroy(hs[i]);
+        int seen = 0;
+        m.for_each_live([&](Probe &p)
+                        { seen += (p.v % 3 == 0 || p.v == 7); });
+        assert(seen == static_cast<int>(m.size()) && seen == 68);
+        (void)old;
+        (void)fresh;
+    }
+
+    // Swap-with-last keeps objects packed and handles pointing at the right one.
+    static void dense_compaction()
+    {
+        {
+            DenseSlotMap<Probe, 64> m;
+            std::vector<Handle> hs;
+            for (int i = 0; i < 64; ++i)
+                hs.push_back(m.create(i));
+            for (int i = 0; i < 64; i += 2)
+                assert(m.destroy(hs[i]));
+            assert(m.size() == 32 && Probe::live == 32);
+            for (int i = 1; i < 64; i += 2)
+                assert(m.get(hs[i])->v == i);
+            for (std::size_t d = 0; d < m.size(); ++d)
+                assert(m.data()[d].v % 2 == 1);
+            assert(m.get(hs[0]) == nullptr);
+            Handle h = m.create(100);
+            assert(m.get(h)->v == 100 && m.get(hs[62]) == nullptr);
+            (void)h;
+        }
+        assert(Probe::live == 0 && Probe::ctors == Probe::dtors);
+    }
+
+    // A throwing move during destroy leaves the map unchanged: every object
+    // is still alive, counted, and reachable through its handle.
+    static void dense_throwing_move()
+    {
+        DenseSlotMap<Fragile, 8> m;
+        Handle a = m.create(1), b = m.create(2), c = m.create(3);
+        Fragile::fail = true;
+        bool threw = false;
+        try
+        {
+            m.destroy(a);
+        }
+        catch (const std::runtime_error &)
+        {
+            threw = true;
+        }
+        assert(threw && m.size() == 3);
+        assert(m.get(a)->v == 1 && m.get(b)->v == 2 && m.get(c)->v == 3);
+        Fragile::fail = false;
+        assert(m.destroy(a) && m.size() == 2 && m.get(c)->v == 3);
+        (void)threw;
+        (void)b;
+        (void)c;
+    }
+};
+
+struct AllocSuite
+{
+    // The same create/destroy churn through a pool and through new/delete.
+    // Once the pool exists it never touches the heap; ConcurrentObjectPool
+    // allocates only its first chunk. Counts are checked when the hooks are
+    // in (always here) and printed either way.
+    static void heap_traffic()
+    {
+        constexpr int K = 10000;
+        ObjectPool<Probe, 1000> pool;
+        bench::AllocScope pool_scope;
+        for (int i = 0; i < K; ++i)
+            pool.destroy(pool.create(i));
+        const bench::AllocSample in_pool = pool_scope.sample();
+
+        bench::AllocScope heap_scope;
+        for (int i = 0; i < K; ++i)
+        {
+            Probe *p = new Probe(i);
+            bench::do_not_optimize(p); // keep the new/delete pair from being elided
+            delete p;
+        }
+        const bench::AllocSample on_heap = heap_scope.sample();
+
+        bench::AllocScope cpool_scope;
+        {
+            ConcurrentObjectPool<Probe, 4096, 16> cpool;
+            for (int i = 0; i < K; ++i)
+                cpool.destroy(cpool.create(i));
+        }
+        const bench::AllocSample in_cpool = cpool_scope.sample();
+
+        if (in_pool.any())
+        {
+            assert(in_pool.allocs == 0 && in_pool.peak_bytes == 0);
+            assert(on_heap.allocs == K && on_heap.frees == K && on_heap.peak_bytes == sizeof(Probe));
+            assert(in_cpool.allocs == in_cpool.frees && in_cpool.allocs < 4);
+        }
+        std::cout << "ObjectPool create/destroy x" << K << ":" << in_pool.format() << "\n"
+                  << "new/delete x" << K << ":" << on_heap.format() << "\n"
+                  << "ConcurrentObjectPool (incl. setup) x" << K << ":" << in_cpool.format() << "\n";
+    }
+};
+
 int main()
 {
     Suite::construct_destroy();
     Suite::exhaustion();
     Suite::recycle_lifo();
+    LayoutSuite::bulk_and_reuse<PoolLayout::Separate>();
+    LayoutSuite::bulk_and_reuse<PoolLayout::Intrusive>();
+    LayoutSuite::bulk_and_reuse<PoolLayout::IntrusiveAligned>();
+    ConcurrentSuite::growth();
+    ConcurrentSuite::cross_thread_free();
+    ConcurrentSuite::thread_churn();
+    SlotMapSuite::generations();
+    SlotMapSuite::dense_compaction();
+    SlotMapSuite::dense_throwing_move();
+    AllocSuite::heap_traffic();
     return 0;
 }
\ No newline at end of file
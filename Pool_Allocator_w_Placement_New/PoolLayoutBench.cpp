@@ -0,0 +1,125 @@
+#include "ObjectPool.hpp"
+
+#include "bench/PerfCounters.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// ObjectPool freelist layouts under churn: random destroy/create pairs on a
+// half-full pool, so the freelist is scattered across the buffer. Reports
+// ns/op for single and bulk (create_n/destroy_n) calls at N = 1K, 64K and
+// 1M, with hardware counters per op when built with -DBENCH_PERF_COUNTERS=ON
+// (bench/PerfCounters.hpp).
+//
+// Usage: pool_layout
+
+struct Order
+{
+    std::uint64_t id;
+    double price;
+    std::uint32_t qty;
+    std::uint32_t side;
+    Order(std::uint64_t i) noexcept : id(i), price(1.0), qty(1), side(0) {}
+};
+
+static constexpr std::size_t kBatch = 32;
+
+template <std::size_t N, PoolLayout L>
+static void run(const char *name)
+{
+    typedef ObjectPool<Order, N, L> Pool;
+    std::unique_ptr<Pool> pool(new Pool());
+    std::mt19937_64 rng(1234);
+
+    // Fill completely, then free a random half so free slots are scattered.
+    std::vector<Order *> live(N);
+    for (std::size_t i = 0; i < N; ++i)
+        live[i] = pool->create(i);
+    std::shuffle(live.begin(), live.end(), rng);
+    pool->destroy_n(live.data() + N / 2, N - N / 2);
+    live.resize(N / 2);
+
+    const std::size_t ops = N < 1000000 ? 4000000 : 8000000; // destroy+create pairs
+    std::vector<std::uint32_t> pick(ops / kBatch);
+    for (auto &p : pick)
+        p = static_cast<std::uint32_t>(rng() % (live.size() - kBatch));
+
+    // Every run leaves the pool half full, so runs can repeat.
+    const bench::Options opt = bench::Options::from_env(3, 1);
+    std::uint64_t check = 0;
+
+    // Single: destroy one random live object, create one in its place.
+    bench::PerfSample pmc_single;
+    const bench::Stats single = bench::measure([&]
+                                               {
+        for (std::size_t k = 0; k < pick.size(); ++k)
+        {
+            std::size_t base = pick[k];
+            for (std::size_t j = 0; j < kBatch; ++j)
+            {
+                pool->destroy(live[base + j]);
+                live[base + j] = pool->create(k);
+            }
+            check += live[base]->id;
+        }
+        bench::do_not_optimize(check); },
+                                               opt, pmc_single);
+
+    // Bulk: release a run of kBatch objects and recreate them in one call each.
+    bench::PerfSample pmc_bulk;
+    const bench::Stats bulk = bench::measure([&]
+                                             {
+        for (std::size_t k = 0; k < pick.size(); ++k)
+        {
+            std::size_t base = pick[k];
+            pool->destroy_n(live.data() + base, kBatch);
+            std::size_t made = pool->create_n(live.data() + base, kBatch, static_cast<std::uint64_t>(k));
+            check += made + live[base]->id;
+        }
+        bench::do_not_optimize(check); },
+                                             opt, pmc_bulk);
+
+    pool->destroy_n(live.data(), live.size());
+
+    const double n_ops = 2.0 * static_cast<double>(pick.size() * kBatch);
+    const std::string tag = "pool_layout/N=" + std::to_string(N) + "/" + name;
+    auto report = [&](const char *kind, const bench::Stats &st, const bench::PerfSample &pmc)
+    {
+        std::vector<bench::Metric> m = pmc.metrics(n_ops);
+        m.push_back({"ns_per_op", st.median_ns / n_ops});
+        bench::record(tag + "/" + kind, st, std::move(m));
+        std::cout << " | " << kind << " " << std::setw(6) << st.median_ns / n_ops << " ns/op"
+                  << pmc.format("op", n_ops);
+    };
+
+    std::cout << std::left << std::setw(8) << N << std::setw(18) << name << std::right
+              << " slot=" << std::setw(3) << Pool::slot_size() << "B"
+              << std::fixed << std::setprecision(2);
+    report("single", single, pmc_single);
+    report("bulk", bulk, pmc_bulk);
+    std::cout << (check == 0 ? " !" : "") << "\n";
+}
+
+template <std::size_t N>
+static void run_all()
+{
+    run<N, PoolLayout::Separate>("separate");
+    run<N, PoolLayout::Intrusive>("intrusive");
+    run<N, PoolLayout::IntrusiveAligned>("intrusive+aligned");
+}
+
+int main()
+{
+    std::cout << "sizeof(Order): " << sizeof(Order) << " | churn in runs of " << kBatch << "\n";
+    run_all<1024>();
+    run_all<65536>();
+    run_all<1048576>();
+    return 0;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "ObjectPool.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+
+// std::pmr::memory_resource over a set of ObjectPools, one per size class
+// (16, 32, 64, 128, 256 bytes). A request is rounded up to its class and
+// served from that pool's freelist; oversized or over-aligned requests, and
+// requests that find their class exhausted, go to the upstream resource.
+// Node-based containers (std::list, std::map, std::unordered_map) allocate
+// one fixed-size node at a time, which is exactly what these pools are for.
+//
+// Each pool keeps its SlotsPerClass slots inline, so this object is large;
+// put it on the heap. Not thread-safe (neither is ObjectPool). The pools use
+// the intrusive layout, so untouched slots cost no memory until first use.
+template <std::size_t SlotsPerClass = 4096>
+class PoolResource final : public std::pmr::memory_resource
+{
+public:
+    static constexpr std::size_t kMaxBlock = 256;
+    static constexpr std::size_t kAlign = alignof(std::max_align_t);
+
+    explicit PoolResource(std::pmr::memory_resource *upstream = std::pmr::new_delete_resource()) noexcept
+        : _upstream(upstream)
+    {
+    }
+
+    PoolResource(const PoolResource &) = delete;
+    PoolResource &operator=(const PoolResource &) = delete;
+
+    // Non-virtual entry points, shared with PoolAllocator.
+    void *allocate_block(std::size_t bytes, std::size_t align)
+    {
+        if (bytes <= kMaxBlock && align <= kAlign)
+        {
+            void *p = allocate_from_class(bytes);
+            if (p != nullptr)
+                return p;
+            ++_fallbacks;
+        }
+        return _upstream->allocate(bytes, align);
+    }
+
+    void deallocate_block(void *p, std::size_t bytes, std::size_t align) noexcept
+    {
+        if (bytes <= kMaxBlock && align <= kAlign && deallocate_to_class(p, bytes))
+            return;
+        _upstream->deallocate(p, bytes, align);
+    }
+
+    // Number of small requests that found their size class full.
+    std::size_t fallbacks() const noexcept { return _fallbacks; }
+
+private:
+    template <std::size_t Size>
+    using Block = typename std::aligned_storage<Size, kAlign>::type;
+
+    void *do_allocate(std::size_t bytes, std::size_t align) override
+    {
+        return allocate_block(bytes, align);
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t align) override
+    {
+        deallocate_block(p, bytes, align);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    void *allocate_from_class(std::size_t bytes) noexcept
+    {
+        if (bytes <= 16)
+            return _p16.allocate_slot();
+        if (bytes <= 32)
+            return _p32.allocate_slot();
+        if (bytes <= 64)
+            return _p64.allocate_slot();
+        if (bytes <= 128)
+            return _p128.allocate_slot();
+        return _p256.allocate_slot();
+    }
+
+    // False if p didn't come from its class pool (i.e. it was a fallback).
+    bool deallocate_to_class(void *p, std::size_t bytes) noexcept
+    {
+        if (bytes <= 16)
+            return release(_p16, p);
+        if (bytes <= 32)
+            return release(_p32, p);
+        if (bytes <= 64)
+            return release(_p64, p);
+        if (bytes <= 128)
+            return release(_p128, p);
+        return release(_p256, p);
+    }
+
+    template <class Pool>
+    static bool release(Pool &pool, void *p) noexcept
+    {
+        if (!pool.owns(p))
+            return false;
+        pool.deallocate_slot(p);
+        return true;
+    }
+
+    std::pmr::memory_resource *_upstream;
+    std::size_t _fallbacks = 0;
+    ObjectPool<Block<16>, SlotsPerClass, PoolLayout::Intrusive> _p16;
+    ObjectPool<Block<32>, SlotsPerClass, PoolLayout::Intrusive> _p32;
+    ObjectPool<Block<64>, SlotsPerClass, PoolLayout::Intrusive> _p64;
+    ObjectPool<Block<128>, SlotsPerClass, PoolLayout::Intrusive> _p128;
+    ObjectPool<Block<256>, SlotsPerClass, PoolLayout::Intrusive> _p256;
+};
+
+// Classic (non-polymorphic) allocator over a PoolResource, for containers
+// that take an Allocator template argument: no virtual call per node.
+template <class T, class Resource>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(Resource *r) noexcept : _res(r) {}
+
+    template <class U>
+    PoolAllocator(const PoolAllocator<U, Resource> &o) noexcept : _res(o.resource()) {}
+
+    T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(_res->allocate_block(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+        _res->deallocate_block(p, n * sizeof(T), alignof(T));
+    }
+
+    Resource *resource() const noexcept { return _res; }
+
+    template <class U>
+    bool operator==(const PoolAllocator<U, Resource> &o) const noexcept { return _res == o.resource(); }
+    template <class U>
+    bool operator!=(const PoolAllocator<U, Resource> &o) const noexcept { return _res != o.resource(); }
+
+private:
+    Resource *_res;
+};
@@ -0,0 +1,139 @@
+#include "PoolResource.hpp"
+
+#include "bench/Harness.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+// Node-container throughput and memory: default allocator vs PoolResource
+// (as a std::pmr resource and through the classic PoolAllocator adapter).
+// Each round inserts n shuffled keys and erases them in another order and is
+// one sample: one warm-up round (BENCH_WARMUP), then `rounds` timed rounds
+// (BENCH_REPS overrides). RSS is the peak over all of them.
+//
+// Usage: pool_pmr [n] [rounds]
+
+static constexpr std::size_t kSlots = 1u << 18; // per size class
+typedef PoolResource<kSlots> Resource;
+
+// Resident set size in KiB, or 0 where we can't read it.
+static std::size_t rss_kib()
+{
+#if defined(__linux__)
+    std::ifstream f("/proc/self/statm");
+    std::size_t pages = 0, resident = 0;
+    if (f >> pages >> resident)
+        return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE)) / 1024;
+#endif
+    return 0;
+}
+
+// make() builds an empty container; it and its resource are created after the
+// RSS baseline so the pool's own footprint is part of the measurement.
+template <class Make>
+static void run(const char *name, const std::vector<int> &ins, const std::vector<int> &del,
+                std::size_t rounds, Make make)
+{
+    const std::size_t rss0 = rss_kib();
+    auto holder = make();
+    auto &m = *holder.second;
+    std::size_t rss_peak = rss0;
+    std::uint64_t sum = 0;
+    const double ops = 2.0 * static_cast<double>(ins.size());
+
+    auto round = [&]
+    {
+        const std::int64_t t0 = bench::now_ns();
+        for (int k : ins)
+            m.emplace(k, k);
+        rss_peak = std::max(rss_peak, rss_kib());
+        for (int k : del)
+        {
+            auto it = m.find(k);
+            sum += static_cast<std::uint64_t>(it->second);
+            m.erase(it);
+        }
+        return static_cast<double>(bench::now_ns() - t0) / ops;
+    };
+    const bench::Options opt = bench::Options::from_env(rounds, 1);
+    for (std::size_t w = 0; w < opt.warmup_max; ++w)
+        round();
+    std::vector<double> ns;
+    for (std::size_t r = 0; r < opt.reps; ++r)
+        ns.push_back(round());
+    const bench::Stats st = bench::summarize(std::move(ns));
+    const double mops = 1e3 / st.median_ns;
+
+    std::cout << std::left << std::setw(30) << name << std::right
+              << " | " << std::setw(8) << std::fixed << std::setprecision(2) << mops << " M ops/s"
+              << " | RSS +" << std::setw(7) << (rss_peak - rss0) << " KiB";
+    if (holder.first)
+        std::cout << " | pool fallbacks: " << holder.first->fallbacks();
+    std::cout << (sum == 0 ? " (empty?)" : "") << "\n";
+
+    // Samples are ns per insert or erase.
+    bench::record(std::string("pool_pmr/") + name, st,
+                  {{"mops", mops}, {"rss_kib", static_cast<double>(rss_peak - rss0)}});
+}
+
+int main(int argc, char **argv)
+{
+    const std::size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    const std::size_t rounds = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 10;
+
+    std::vector<int> ins(n), del(n);
+    for (std::size_t i = 0; i < n; ++i)
+        ins[i] = static_cast<int>(i) + 1;
+    del = ins;
+    std::mt19937 rng(42);
+    std::shuffle(ins.begin(), ins.end(), rng);
+    std::shuffle(del.begin(), del.end(), rng);
+
+    std::cout << "n: " << n << " | rounds: " << rounds << " | slots per size class: " << kSlots << "\n";
+
+    typedef std::pair<const int, int> V;
+    typedef PoolAllocator<V, Resource> A;
+
+    // Each factory returns {resource (or null), container}, both heap-owned.
+    run("std::map", ins, del, rounds, []
+        { return std::make_pair(std::shared_ptr<Resource>(), std::make_shared<std::map<int, int>>()); });
+    run("std::map + PoolAllocator", ins, del, rounds, []
+        {
+        auto res = std::make_shared<Resource>();
+        typedef std::map<int, int, std::less<int>, A> M;
+        return std::make_pair(res, std::make_shared<M>(A(res.get()))); });
+    run("std::pmr::map + PoolResource", ins, del, rounds, []
+        {
+        auto res = std::make_shared<Resource>();
+        return std::make_pair(res, std::make_shared<std::pmr::map<int, int>>(res.get())); });
+
+    run("std::unordered_map", ins, del, rounds, []
+        { return std::make_pair(std::shared_ptr<Resource>(), std::make_shared<std::unordered_map<int, int>>()); });
+    run("unordered_map + PoolAllocator", ins, del, rounds, []
+        {
+        auto res = std::make_shared<Resource>();
+        typedef std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, A> M;
+        return std::make_pair(res, std::make_shared<M>(0, std::hash<int>(), std::equal_to<int>(), A(res.get()))); });
+    run("pmr::unordered_map + Pool", ins, del, rounds, []
+        {
+        auto res = std::make_shared<Resource>();
+        return std::make_pair(res, std::make_shared<std::pmr::unordered_map<int, int>>(res.get())); });
+    return 0;
+}
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Slot-map flavours of ObjectPool: objects are addressed by a Handle
+// (32-bit slot index + 32-bit generation) instead of a raw T*. Destroying an
+// object bumps its slot's generation, so a stale handle is detected by get()
+// and destroy() rather than silently aliasing whatever reuses the slot.
+//
+//   SlotMap<T, N>       objects stay where they were created (stable
+//                       addresses); an occupancy bitmap lets for_each_live()
+//                       skip 64 empty slots per word with a bit scan.
+//   DenseSlotMap<T, N>  live objects are kept packed in [0, size()): destroy
+//                       moves the last object into the hole (swap-with-last),
+//                       so iteration is a plain linear scan. Addresses are
+//                       not stable; hold handles, not pointers.
+
+struct Handle
+{
+    std::uint32_t index;
+    std::uint32_t generation;
+
+    bool operator==(const Handle &o) const noexcept { return index == o.index && generation == o.generation; }
+    bool operator!=(const Handle &o) const noexcept { return !(*this == o); }
+};
+
+static constexpr Handle kNullHandle{0xFFFFFFFFu, 0};
+
+inline unsigned ctz64(std::uint64_t w) noexcept
+{
+    assert(w != 0);
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward64(&i, w);
+    return static_cast<unsigned>(i);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(w));
+#endif
+}
+
+// --------------------------- SlotMap ---------------------------
+template <class T, std::size_t N>
+class SlotMap
+{
+public:
+    SlotMap() noexcept
+    {
+        static_assert(N > 0, "SlotMap capacity N must be greater than 0");
+        static_assert(N < 0xFFFFFFFFu, "N too large for 32-bit handles");
+        std::memset(_gen, 0, sizeof(_gen));
+        std::memset(_occupied, 0, sizeof(_occupied));
+    }
+
+    SlotMap(const SlotMap &) = delete;
+    SlotMap &operator=(const SlotMap &) = delete;
+    SlotMap(SlotMap &&) = delete;
+    SlotMap &operator=(SlotMap &&) = delete;
+
+    ~SlotMap() noexcept
+    {
+        for_each_live([](T &obj)
+                      { obj.~T(); });
+    }
+
+    // Returns kNullHandle when full.
+    template <class... Args>
+    Handle create(Args &&...args)
+    {
+        std::uint32_t i = allocate_index();
+        if (i == kNil)
+            return kNullHandle;
+        try
+        {
+            ::new (static_cast<void *>(&_buf[i])) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            release_index(i);
+            throw;
+        }
+        _occupied[i / 64] |= std::uint64_t(1) << (i % 64);
+        ++_size;
+        return Handle{i, _gen[i]};
+    }
+
+    // nullptr if h is stale (its object was destroyed) or was never valid.
+    T *get(Handle h) noexcept
+    {
+        return valid(h) ? ptr(h.index) : nullptr;
+    }
+
+    bool valid(Handle h) const noexcept
+    {
+        return h.index < N && _gen[h.index] == h.generation &&
+               (_occupied[h.index / 64] >> (h.index % 64)) & 1u;
+    }
+
+    // False (and nothing happens) if h is stale.
+    bool destroy(Handle h) noexcept(std::is_nothrow_destructible<T>::value)
+    {
+        if (!valid(h))
+            return false;
+        const std::uint32_t i = h.index;
+        ptr(i)->~T();
+        _occupied[i / 64] &= ~(std::uint64_t(1) << (i % 64));
+        ++_gen[i]; // invalidates every outstanding handle to this slot
+        --_size;
+        release_index(i);
+        return true;
+    }
+
+    // f(T&) for every live object, in slot order.
+    template <class F>
+    void for_each_live(F &&f)
+    {
+        for (std::size_t w = 0; w < kWords; ++w)
+        {
+            std::uint64_t bits = _occupied[w];
+            while (bits != 0)
+            {
+                f(*ptr(static_cast<std::uint32_t>(w * 64 + ctz64(bits))));
+                bits &= bits - 1; // clear lowest set bit
+            }
+        }
+    }
+
+    std::size_t size() const noexcept { return _size; }
+    constexpr std::size_t capacity() const noexcept { return N; }
+
+private:
+    using Slot = typename std::aligned_storage<(sizeof(T) < sizeof(std::uint32_t) ? sizeof(std::uint32_t) : sizeof(T)),
+                                               alignof(T)>::type;
+    static constexpr std::size_t kWords = (N + 63) / 64;
+    static constexpr std::uint32_t kNil = 0xFFFFFFFFu;
+
+    T *ptr(std::uint32_t i) noexcept { return reinterpret_cast<T *>(&_buf[i]); }
+
+    // Intrusive freelist as in ObjectPool's Intrusive layout.
+    std::uint32_t allocate_index() noexcept
+    {
+        if (_head != kNil)
+        {
+            std::uint32_t i = _head;
+            std::memcpy(&_head, &_buf[i], sizeof(_head));
+            return i;
+        }
+        return _untouched < N ? _untouched++ : kNil;
+    }
+
+    void release_index(std::uint32_t i) noexcept
+    {
+        std::memcpy(&_buf[i], &_head, sizeof(_head));
+        _head = i;
+    }
+
+    Slot _buf[N];
+    std::uint32_t _gen[N];
+    std::uint64_t _occupied[kWords];
+    std::uint32_t _head = kNil;
+    std::uint32_t _untouched = 0;
+    std::size_t _size = 0;
+};
+
+// --------------------------- DenseSlotMap ---------------------------
+template <class T, std::size_t N>
+class DenseSlotMap
+{
+public:
+    DenseSlotMap() noexcept
+    {
+        static_assert(N > 0, "DenseSlotMap capacity N must be greater than 0");
+        static_assert(N < 0xFFFFFFFFu, "N too large for 32-bit handles");
+    }
+
+    DenseSlotMap(const DenseSlotMap &) = delete;
+    DenseSlotMap &operator=(const DenseSlotMap &) = delete;
+    DenseSlotMap(DenseSlotMap &&) = delete;
+    DenseSlotMap &operator=(DenseSlotMap &&) = delete;
+
+    ~DenseSlotMap() noexcept
+    {
+        for (std::size_t d = 0; d < _size; ++d)
+            value(d)->~T();
+    }
+
+    // Returns kNullHandle when full.
+    template <class... Args>
+    Handle create(Args &&...args)
+    {
+        if (_size == N)
+            return kNullHandle;
+        const bool reuse = _free_head != kNil;
+        const std::uint32_t s = reuse ? _free_head : _untouched;
+        const std::uint32_t d = static_cast<std::uint32_t>(_size);
+        ::new (static_cast<void *>(value(d))) T(std::forward<Args>(args)...); // may throw: nothing changed yet
+        if (reuse)
+            _free_head = _sparse[s].dense; // freelist link reuses the dense field
+        else
+            _sparse[_untouched++].generation = 0;
+        _sparse[s].dense = d;
+        _dense_to_sparse[d] = s;
+        ++_size;
+        return Handle{s, _sparse[s].generation};
+    }
+
+    T *get(Handle h) noexcept
+    {
+        return valid(h) ? value(_sparse[h.index].dense) : nullptr;
+    }
+
+    bool valid(Handle h) const noexcept
+    {
+        return h.index < _untouched && _sparse[h.index].generation == h.generation &&
+               _sparse[h.index].dense < _size && _dense_to_sparse[_sparse[h.index].dense] == h.index;
+    }
+
+    // Move-assigns the last live object over the destroyed one, so if that
+    // throws both are still alive and nothing has changed. False if h is stale.
+    bool destroy(Handle h) noexcept(std::is_nothrow_move_assignable<T>::value &&
+                                    std::is_nothrow_destructible<T>::value)
+    {
+        if (!valid(h))
+            return false;
+        const std::uint32_t d = _sparse[h.index].dense;
+        const std::uint32_t last = static_cast<std::uint32_t>(_size - 1);
+        if (d != last)
+            *value(d) = std::move(*value(last));
+        value(last)->~T();
+        if (d != last)
+        {
+            const std::uint32_t moved = _dense_to_sparse[last];
+            _sparse[moved].dense = d;
+            _dense_to_sparse[d] = moved;
+        }
+        --_size;
+        ++_sparse[h.index].generation;
+        _sparse[h.index].dense = _free_head;
+        _free_head = h.index;
+        return true;
+    }
+
+    // Linear scan of the packed objects.
+    template <class F>
+    void for_each_live(F &&f)
+    {
+        T *p = data();
+        for (std::size_t d = 0; d < _size; ++d)
+            f(p[d]);
+    }
+
+    T *data() noexcept { return value(0); }
+    std::size_t size() const noexcept { return _size; }
+    constexpr std::size_t capacity() const noexcept { return N; }
+
+private:
+    using Slot = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+    static constexpr std::uint32_t kNil = 0xFFFFFFFFu;
+
+    struct Sparse
+    {
+        std::uint32_t dense;      // position in _values (or next free entry)
+        std::uint32_t generation;
+    };
+
+    T *value(std::size_t d) noexcept { return reinterpret_cast<T *>(&_values[d]); }
+
+    Slot _values[N];
+    std::uint32_t _dense_to_sparse[N];
+    Sparse _sparse[N];
+    std::uint32_t _free_head = kNil;
+    std::uint32_t _untouched = 0;
+    std::size_t _size = 0;
+};
@@ -0,0 +1,131 @@
+#include "ObjectPool.hpp"
+#include "SlotMap.hpp"
+
+#include "bench/Harness.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Iterating every live object of a partly-empty pool. The pool is filled,
+// then a random (1 - fill) fraction is destroyed, and each container sums a
+// field over what's left:
+//   SlotMap        occupancy bitmap + bit scan, objects in slot order
+//   DenseSlotMap   packed array, linear scan
+//   vector<T*>     pointers into an ObjectPool, in address order and shuffled
+// Reports ns per live object (median of the timed passes).
+//
+// Usage: pool_iter
+
+struct Particle
+{
+    float x, y, z;
+    float vx, vy, vz;
+    std::uint32_t id;
+    std::uint32_t flags;
+    Particle(std::uint32_t i) noexcept : x(1), y(2), z(3), vx(0), vy(0), vz(0), id(i), flags(0) {}
+};
+
+static constexpr std::size_t kN = 1u << 20;
+static constexpr int kPasses = 20;
+
+// Times pass() (which adds into sum), records it as <tag>/<key> and prints
+// ns per live object.
+template <class F>
+static void time_pass(const std::string &tag, const char *key, const char *name, std::size_t live,
+                      std::uint64_t &sum, F &&pass)
+{
+    const bench::Stats st = bench::measure([&]
+                                           {
+        pass();
+        bench::do_not_optimize(sum); },
+                                           bench::Options::from_env(kPasses, 5));
+    const double ns = st.median_ns / static_cast<double>(live);
+    bench::record(tag + "/" + key, st, {{"ns_per_obj", ns}});
+    std::cout << "  " << std::left << std::setw(22) << name << std::right
+              << std::fixed << std::setprecision(3) << std::setw(8) << ns << " ns/obj"
+              << (sum == 0 ? " !" : "") << "\n";
+}
+
+static void run(double fill)
+{
+    std::mt19937_64 rng(42);
+    std::vector<std::uint32_t> order(kN);
+    for (std::uint32_t i = 0; i < kN; ++i)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+    const std::size_t kill = static_cast<std::size_t>(static_cast<double>(kN) * (1.0 - fill));
+    const std::size_t live = kN - kill;
+
+    std::cout << "fill " << std::setprecision(0) << std::fixed << fill * 100 << "% (" << live
+              << " of " << kN << " live, sizeof(Particle)=" << sizeof(Particle) << ")\n";
+
+    const std::string tag = "pool_iter/fill=" + std::to_string(static_cast<int>(fill * 100 + 0.5));
+
+    {
+        std::unique_ptr<SlotMap<Particle, kN>> m(new SlotMap<Particle, kN>());
+        std::vector<Handle> hs(kN);
+        for (std::uint32_t i = 0; i < kN; ++i)
+            hs[i] = m->create(i);
+        for (std::size_t k = 0; k < kill; ++k)
+            m->destroy(hs[order[k]]);
+        std::uint64_t sum = 0;
+        time_pass(tag, "slotmap", "SlotMap (bitmap)", live, sum, [&]
+                  { m->for_each_live([&](Particle &p)
+                                     { sum += p.id; }); });
+    }
+
+    {
+        std::unique_ptr<DenseSlotMap<Particle, kN>> m(new DenseSlotMap<Particle, kN>());
+        std::vector<Handle> hs(kN);
+        for (std::uint32_t i = 0; i < kN; ++i)
+            hs[i] = m->create(i);
+        for (std::size_t k = 0; k < kill; ++k)
+            m->destroy(hs[order[k]]);
+        std::uint64_t sum = 0;
+        time_pass(tag, "dense", "DenseSlotMap", live, sum, [&]
+                  { m->for_each_live([&](Particle &p)
+                                     { sum += p.id; }); });
+    }
+
+    {
+        typedef ObjectPool<Particle, kN, PoolLayout::Intrusive> Pool;
+        std::unique_ptr<Pool> pool(new Pool());
+        std::vector<Particle *> ps(kN);
+        for (std::uint32_t i = 0; i < kN; ++i)
+            ps[i] = pool->create(i);
+        for (std::size_t k = 0; k < kill; ++k)
+        {
+            pool->destroy(ps[order[k]]);
+            ps[order[k]] = nullptr;
+        }
+        ps.erase(std::remove(ps.begin(), ps.end(), nullptr), ps.end());
+
+        auto walk = [&](std::uint64_t &sum)
+        {
+            for (Particle *p : ps)
+                sum += p->id;
+        };
+        std::uint64_t sum = 0;
+        time_pass(tag, "ptrs_address", "vector<T*> (address)", live, sum, [&]
+                  { walk(sum); });
+        std::shuffle(ps.begin(), ps.end(), rng);
+        time_pass(tag, "ptrs_shuffled", "vector<T*> (shuffled)", live, sum, [&]
+                  { walk(sum); });
+        for (Particle *p : ps)
+            pool->destroy(p);
+    }
+}
+
+int main()
+{
+    run(0.5);
+    run(0.1);
+    return 0;
+}
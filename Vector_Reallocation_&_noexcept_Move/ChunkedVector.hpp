@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <utility>
+#include <vector>
+
+// ------------------------------- ChunkedVector -------------------------------
+// Elements in fixed blocks of B (a power of two), allocated one at a time as
+// the vector grows. Growth never moves or copies an element, so a push_back
+// costs at most one block allocation however large the vector is, and
+// pointers and references stay valid until the element is popped. Only the
+// table of block pointers reallocates (B times fewer entries, plain pointers).
+// Indexing is a shift, a mask and one extra load; the storage is contiguous
+// within a block only, so there is no data().
+template <class T, std::size_t B = 1024>
+class ChunkedVector
+{
+    static_assert(B > 0 && (B & (B - 1)) == 0, "block size must be a power of two");
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types need an aligned allocation");
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    static constexpr size_type block_size = B;
+
+    template <class V, class Vec>
+    class Iter
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = V *;
+        using reference = V &;
+
+        Iter(Vec *v, size_type i) noexcept : v_(v), i_(i) {}
+        reference operator*() const noexcept { return (*v_)[i_]; }
+        pointer operator->() const noexcept { return &(*v_)[i_]; }
+        Iter &operator++() noexcept
+        {
+            ++i_;
+            return *this;
+        }
+        bool operator==(const Iter &o) const noexcept { return i_ == o.i_; }
+        bool operator!=(const Iter &o) const noexcept { return i_ != o.i_; }
+
+    private:
+        Vec *v_;
+        size_type i_;
+    };
+    using iterator = Iter<T, ChunkedVector>;
+    using const_iterator = Iter<const T, const ChunkedVector>;
+
+    ChunkedVector() = default;
+
+    ChunkedVector(const ChunkedVector &o) : ChunkedVector()
+    {
+        for (const T &v : o)
+            push_back(v); // ~ChunkedVector cleans up on throw
+    }
+
+    ChunkedVector(ChunkedVector &&o) noexcept : blocks_(std::move(o.blocks_)), size_(o.size_) { o.size_ = 0; }
+
+    ChunkedVector &operator=(ChunkedVector o) noexcept
+    {
+        blocks_.swap(o.blocks_);
+        std::swap(size_, o.size_);
+        return *this;
+    }
+
+    ~ChunkedVector()
+    {
+        clear();
+        for (T *b : blocks_)
+            ::operator delete(static_cast<void *>(b));
+    }
+
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return blocks_.size() * B; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    T &operator[](size_type i) noexcept { return blocks_[i / B][i % B]; }
+    const T &operator[](size_type i) const noexcept { return blocks_[i / B][i % B]; }
+    T &back() noexcept { return (*this)[size_ - 1]; }
+    iterator begin() noexcept { return iterator(this, 0); }
+    iterator end() noexcept { return iterator(this, size_); }
+    const_iterator begin() const noexcept { return const_iterator(this, 0); }
+    const_iterator end() const noexcept { return const_iterator(this, size_); }
+
+    // Blocks for n elements now; nothing moves either way.
+    void reserve(size_type n)
+    {
+        blocks_.reserve((n + B - 1) / B);
+        while (capacity() < n)
+            add_block();
+    }
+
+    template <class... Args>
+    T &emplace_back(Args &&...args)
+    {
+        if (size_ == capacity())
+            add_block();
+        T *slot = &blocks_[size_ / B][size_ % B];
+        ::new (static_cast<void *>(slot)) T(std::forward<Args>(args)...);
+        ++size_;
+        return *slot;
+    }
+
+    void push_back(const T &v) { emplace_back(v); }
+    void push_back(T &&v) { emplace_back(std::move(v)); }
+
+    // Keeps the block, so the next push_back into it doesn't allocate.
+    void pop_back() noexcept { (*this)[--size_].~T(); }
+
+    void clear() noexcept
+    {
+        for (; size_ > 0; --size_)
+            (*this)[size_ - 1].~T();
+    }
+
+private:
+    void add_block()
+    {
+        void *b = ::operator new(B * sizeof(T));
+        try
+        {
+            blocks_.push_back(static_cast<T *>(b));
+        }
+        catch (...)
+        {
+            ::operator delete(b);
+            throw;
+        }
+    }
+
+    std::vector<T *> blocks_;
+    size_type size_ = 0;
+};
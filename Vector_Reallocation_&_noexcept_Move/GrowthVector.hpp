@@ -0,0 +1,353 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define GROWTH_HAVE_MREMAP 1
+#endif
+
+// The buffer comes from malloc/realloc/mmap, which operator new hooks (e.g.
+// bench/AllocTracker.hpp) don't see. To count it, define both before
+// including this header; they get the bytes obtained or given back. A realloc
+// or mremap is a free of the old size and an alloc of the new one (alloc
+// first when the buffer moved, since both existed for a moment).
+#ifndef GROWTH_VECTOR_NOTE_ALLOC
+#define GROWTH_VECTOR_NOTE_ALLOC(bytes) ((void)0)
+#define GROWTH_VECTOR_NOTE_FREE(bytes) ((void)0)
+#endif
+
+// ------------------------- is_trivially_relocatable -------------------------
+// True when moving a T to a new address and ending the old one's lifetime is
+// the same as copying its bytes: no pointers into itself, no registration of
+// its own address anywhere. Trivially copyable types qualify; specialise it
+// for others, e.g. a class holding a unique_ptr:
+//   template <> struct is_trivially_relocatable<Widget> : std::true_type {};
+// Not libstdc++'s std::string (its short-string pointer points into itself).
+template <class T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T>
+{
+};
+
+// ------------------------------ Growth policies ------------------------------
+// grow(cap) is the capacity after cap runs out. 2x reaches a size in fewer
+// reallocations; 1.5x wastes less at the end and lets a freed run of earlier
+// blocks fit a later one.
+struct Growth2x
+{
+    static std::size_t grow(std::size_t cap) noexcept { return cap == 0 ? 1 : 2 * cap; }
+};
+
+struct Growth1_5x
+{
+    static std::size_t grow(std::size_t cap) noexcept { return cap < 2 ? cap + 1 : cap + cap / 2; }
+};
+
+// -------------------------------- GrowthVector --------------------------------
+// A push_back/emplace_back vector for comparing reallocation strategies with
+// std::vector:
+//   - Growth:         growth policy above.
+//   - relocatable T:  growing moves the bytes (realloc), no move or copy
+//                     constructor runs, so a T whose move isn't noexcept is
+//                     not copied either. From kMapBytes up the buffer is its
+//                     own mapping, grown with mremap (Linux): pages are
+//                     remapped, not copied, however large the buffer.
+//   - other T:        as std::vector: a new buffer, elements moved if the move
+//                     is noexcept (or T can't be copied), copied otherwise.
+//   - reserve_hint(n): the expected final size; the first growth goes
+//                     straight to n, nothing is allocated before that.
+// Growth keeps the strong guarantee: if it throws, the vector is unchanged.
+template <class T, class Growth = Growth2x>
+class GrowthVector
+{
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types need an aligned allocation");
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    static constexpr bool relocatable = is_trivially_relocatable<T>::value;
+    static constexpr std::size_t kMapBytes = std::size_t(1) << 20;
+
+    GrowthVector() noexcept = default;
+
+    GrowthVector(const GrowthVector &o) : GrowthVector()
+    {
+        if (o.size_ == 0)
+            return;
+        allocate(o.size_);
+        for (; size_ < o.size_; ++size_)
+            ::new (static_cast<void *>(data_ + size_)) T(o.data_[size_]); // ~GrowthVector cleans up on throw
+    }
+
+    GrowthVector(GrowthVector &&o) noexcept { swap(o); }
+
+    GrowthVector &operator=(GrowthVector o) noexcept
+    {
+        swap(o);
+        return *this;
+    }
+
+    ~GrowthVector()
+    {
+        clear();
+        release();
+    }
+
+    void swap(GrowthVector &o) noexcept
+    {
+        std::swap(data_, o.data_);
+        std::swap(size_, o.size_);
+        std::swap(cap_, o.cap_);
+        std::swap(map_bytes_, o.map_bytes_);
+        std::swap(hint_, o.hint_);
+    }
+
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return cap_; }
+    bool empty() const noexcept { return size_ == 0; }
+    static size_type max_size() noexcept { return std::numeric_limits<size_type>::max() / sizeof(T); }
+
+    T *data() noexcept { return data_; }
+    const T *data() const noexcept { return data_; }
+    T &operator[](size_type i) noexcept { return data_[i]; }
+    const T &operator[](size_type i) const noexcept { return data_[i]; }
+    T &back() noexcept { return data_[size_ - 1]; }
+    iterator begin() noexcept { return data_; }
+    iterator end() noexcept { return data_ + size_; }
+    const_iterator begin() const noexcept { return data_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+
+    size_type hint() const noexcept { return hint_; }
+    void reserve_hint(size_type n) noexcept { hint_ = n; }
+
+    void reserve(size_type n)
+    {
+        if (n > cap_)
+            grow_to(n);
+    }
+
+    template <class... Args>
+    T &emplace_back(Args &&...args)
+    {
+        if (size_ == cap_)
+            return emplace_back_slow(std::forward<Args>(args)...);
+        ::new (static_cast<void *>(data_ + size_)) T(std::forward<Args>(args)...);
+        return data_[size_++];
+    }
+
+    void push_back(const T &v) { emplace_back(v); }
+    void push_back(T &&v) { emplace_back(std::move(v)); }
+
+    void pop_back() noexcept { data_[--size_].~T(); }
+
+    void clear() noexcept
+    {
+        for (; size_ > 0; --size_)
+            data_[size_ - 1].~T();
+    }
+
+private:
+    size_type next_capacity() const
+    {
+        if (size_ == max_size())
+            throw std::length_error("GrowthVector: too many elements");
+        if (hint_ > cap_)
+            return hint_;
+        const size_type g = Growth::grow(cap_);
+        return (g > cap_ && g <= max_size()) ? g : max_size();
+    }
+
+    // Buffer for n elements into data_/cap_/map_bytes_ of an empty vector.
+    void allocate(size_type n)
+    {
+        if (n > max_size())
+            throw std::length_error("GrowthVector: too many elements");
+        const std::size_t bytes = n * sizeof(T);
+#if defined(GROWTH_HAVE_MREMAP)
+        if (relocatable && bytes >= kMapBytes)
+        {
+            const std::size_t mb = round_to_pages(bytes);
+            void *p = ::mmap(nullptr, mb, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED)
+                throw std::bad_alloc();
+            data_ = static_cast<T *>(p);
+            map_bytes_ = mb;
+            cap_ = mb / sizeof(T);
+            GROWTH_VECTOR_NOTE_ALLOC(mb);
+            return;
+        }
+#endif
+        void *p = std::malloc(bytes);
+        if (p == nullptr)
+            throw std::bad_alloc();
+        data_ = static_cast<T *>(p);
+        map_bytes_ = 0;
+        cap_ = n;
+        GROWTH_VECTOR_NOTE_ALLOC(bytes);
+    }
+
+    // Bytes held by the buffer: the mapping, or what malloc/realloc was asked for.
+    std::size_t buffer_bytes() const noexcept { return map_bytes_ != 0 ? map_bytes_ : cap_ * sizeof(T); }
+
+    void release() noexcept
+    {
+        if (data_ == nullptr)
+            return;
+        GROWTH_VECTOR_NOTE_FREE(buffer_bytes());
+#if defined(GROWTH_HAVE_MREMAP)
+        if (map_bytes_ != 0)
+        {
+            ::munmap(data_, map_bytes_);
+            return;
+        }
+#endif
+        std::free(data_);
+    }
+
+    // A grown buffer replaced one of old_bytes (0: there was none).
+    static void note_regrow(std::size_t old_bytes, std::size_t new_bytes, bool moved) noexcept
+    {
+        if (old_bytes != 0 && !moved)
+            GROWTH_VECTOR_NOTE_FREE(old_bytes);
+        GROWTH_VECTOR_NOTE_ALLOC(new_bytes);
+        if (old_bytes != 0 && moved)
+            GROWTH_VECTOR_NOTE_FREE(old_bytes);
+        (void)old_bytes;
+        (void)new_bytes;
+        (void)moved;
+    }
+
+#if defined(GROWTH_HAVE_MREMAP)
+    static std::size_t round_to_pages(std::size_t bytes) noexcept
+    {
+        static const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        return (bytes + page - 1) / page * page;
+    }
+#endif
+
+    // Relocatable T: the same bytes in a buffer of n elements, moved by
+    // realloc/mremap (in place when the allocator or kernel can extend it).
+    void relocate_to(size_type n)
+    {
+        if (n > max_size())
+            throw std::length_error("GrowthVector: too many elements");
+        const std::size_t bytes = n * sizeof(T);
+        const std::size_t old_bytes = data_ != nullptr ? buffer_bytes() : 0;
+#if defined(GROWTH_HAVE_MREMAP)
+        if (map_bytes_ != 0 || bytes >= kMapBytes)
+        {
+            const std::size_t mb = round_to_pages(bytes);
+            void *p;
+            if (map_bytes_ != 0)
+            {
+                p = ::mremap(data_, map_bytes_, mb, MREMAP_MAYMOVE);
+                if (p == MAP_FAILED)
+                    throw std::bad_alloc();
+            }
+            else
+            {
+                p = ::mmap(nullptr, mb, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (p == MAP_FAILED)
+                    throw std::bad_alloc();
+                if (size_ > 0)
+                    std::memcpy(p, static_cast<const void *>(data_), size_ * sizeof(T));
+                std::free(data_);
+            }
+            // Remapped pages are not copied, so a moved mapping never exists twice.
+            note_regrow(old_bytes, mb, map_bytes_ == 0);
+            data_ = static_cast<T *>(p);
+            map_bytes_ = mb;
+            cap_ = mb / sizeof(T);
+            return;
+        }
+#endif
+        void *p = std::realloc(static_cast<void *>(data_), bytes);
+        if (p == nullptr)
+            throw std::bad_alloc();
+        note_regrow(old_bytes, bytes, p != static_cast<void *>(data_));
+        data_ = static_cast<T *>(p);
+        cap_ = n;
+    }
+
+    // Other T: a new buffer of n elements; when `emplace`, make(slot) first
+    // builds the new element at index size_, then the old elements are moved
+    // or copied across and destroyed.
+    template <class Make>
+    void reallocate_to(size_type n, bool emplace, Make make)
+    {
+        GrowthVector fresh;
+        fresh.allocate(n);
+        if (emplace)
+            make(fresh.data_ + size_);
+        try
+        {
+            for (; fresh.size_ < size_; ++fresh.size_)
+                ::new (static_cast<void *>(fresh.data_ + fresh.size_)) T(std::move_if_noexcept(data_[fresh.size_]));
+        }
+        catch (...)
+        {
+            if (emplace)
+                fresh.data_[size_].~T();
+            throw; // fresh's destructor drops the elements already moved across
+        }
+        for (size_type i = size_; i > 0; --i)
+            data_[i - 1].~T();
+        std::swap(data_, fresh.data_);
+        std::swap(cap_, fresh.cap_);
+        std::swap(map_bytes_, fresh.map_bytes_);
+        fresh.size_ = 0; // now the old, emptied buffer
+    }
+
+    void grow_to(size_type n)
+    {
+        if constexpr (relocatable)
+            relocate_to(n);
+        else
+            reallocate_to(n, false, [](T *) {});
+    }
+
+    template <class... Args>
+    T &emplace_back_slow(Args &&...args)
+    {
+        const size_type n = next_capacity();
+        if constexpr (relocatable)
+        {
+            // Built before the buffer moves, since args may refer into it.
+            alignas(T) unsigned char tmp[sizeof(T)];
+            T *t = ::new (static_cast<void *>(tmp)) T(std::forward<Args>(args)...);
+            try
+            {
+                relocate_to(n);
+            }
+            catch (...)
+            {
+                t->~T();
+                throw;
+            }
+            std::memcpy(static_cast<void *>(data_ + size_), tmp, sizeof(T));
+        }
+        else
+        {
+            reallocate_to(n, true, [&](T *slot)
+                          { ::new (static_cast<void *>(slot)) T(std::forward<Args>(args)...); });
+        }
+        return data_[size_++];
+    }
+
+    T *data_ = nullptr;
+    size_type size_ = 0;
+    size_type cap_ = 0;
+    std::size_t map_bytes_ = 0; // mapping length when data_ is mmapped, else 0
+    size_type hint_ = 0;
+};
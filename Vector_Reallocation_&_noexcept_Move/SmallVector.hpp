@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// -------------------------------- SmallVector --------------------------------
+// The first N elements live inside the object; only the (N+1)th goes to the
+// heap, after which it grows 2x like std::vector (moving if the move is
+// noexcept, copying otherwise, strong guarantee). A vector that stays within
+// N never allocates, which is the point for the many short vectors of a hot
+// path. The price: sizeof grows by N * sizeof(T), and moving an inline
+// SmallVector moves its elements one by one instead of stealing a pointer.
+template <class T, std::size_t N>
+class SmallVector
+{
+    static_assert(N > 0, "use std::vector for no inline capacity");
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types need an aligned allocation");
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    static constexpr size_type inline_capacity = N;
+
+    SmallVector() noexcept = default;
+
+    SmallVector(const SmallVector &o) : SmallVector()
+    {
+        reserve(o.size_);
+        for (const T &v : o)
+            emplace_back(v); // ~SmallVector cleans up on throw
+    }
+
+    SmallVector(SmallVector &&o) noexcept(std::is_nothrow_move_constructible<T>::value) { take(o); }
+
+    SmallVector &operator=(const SmallVector &o)
+    {
+        if (this != &o)
+        {
+            SmallVector tmp(o);
+            clear();
+            take(tmp);
+        }
+        return *this;
+    }
+
+    SmallVector &operator=(SmallVector &&o) noexcept(std::is_nothrow_move_constructible<T>::value)
+    {
+        if (this != &o)
+        {
+            clear();
+            take(o);
+        }
+        return *this;
+    }
+
+    ~SmallVector()
+    {
+        clear();
+        free_heap();
+    }
+
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return cap_; }
+    bool empty() const noexcept { return size_ == 0; }
+    bool is_inline() const noexcept { return data_ == inline_data(); }
+    static size_type max_size() noexcept { return std::numeric_limits<size_type>::max() / sizeof(T); }
+
+    T *data() noexcept { return data_; }
+    const T *data() const noexcept { return data_; }
+    T &operator[](size_type i) noexcept { return data_[i]; }
+    const T &operator[](size_type i) const noexcept { return data_[i]; }
+    T &back() noexcept { return data_[size_ - 1]; }
+    iterator begin() noexcept { return data_; }
+    iterator end() noexcept { return data_ + size_; }
+    const_iterator begin() const noexcept { return data_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+
+    void reserve(size_type n)
+    {
+        if (n > cap_)
+            reallocate_to(n, false, [](T *) {});
+    }
+
+    template <class... Args>
+    T &emplace_back(Args &&...args)
+    {
+        if (size_ == cap_)
+        {
+            if (size_ == max_size())
+                throw std::length_error("SmallVector: too many elements");
+            const size_type n = cap_ <= max_size() / 2 ? 2 * cap_ : max_size();
+            reallocate_to(n, true, [&](T *slot)
+                          { ::new (static_cast<void *>(slot)) T(std::forward<Args>(args)...); });
+            return data_[size_++];
+        }
+        ::new (static_cast<void *>(data_ + size_)) T(std::forward<Args>(args)...);
+        return data_[size_++];
+    }
+
+    void push_back(const T &v) { emplace_back(v); }
+    void push_back(T &&v) { emplace_back(std::move(v)); }
+
+    void pop_back() noexcept { data_[--size_].~T(); }
+
+    void clear() noexcept
+    {
+        for (; size_ > 0; --size_)
+            data_[size_ - 1].~T();
+    }
+
+private:
+    T *inline_data() noexcept { return reinterpret_cast<T *>(inline_); }
+    const T *inline_data() const noexcept { return reinterpret_cast<const T *>(inline_); }
+
+    void free_heap() noexcept
+    {
+        if (!is_inline())
+            ::operator delete(static_cast<void *>(data_));
+    }
+
+    // From o, left empty and inline: its heap buffer, or its inline elements
+    // one move each. *this must be empty.
+    void take(SmallVector &o)
+    {
+        free_heap();
+        data_ = inline_data();
+        cap_ = N;
+        if (!o.is_inline())
+        {
+            data_ = o.data_;
+            cap_ = o.cap_;
+            size_ = o.size_;
+            o.data_ = o.inline_data();
+            o.cap_ = N;
+            o.size_ = 0;
+            return;
+        }
+        for (; size_ < o.size_; ++size_)
+            ::new (static_cast<void *>(data_ + size_)) T(std::move(o.data_[size_]));
+        o.clear();
+    }
+
+    // A heap buffer of n elements; when `emplace`, make(slot) first builds
+    // the new element at index size_, then the old elements are moved or
+    // copied across and destroyed.
+    template <class Make>
+    void reallocate_to(size_type n, bool emplace, Make make)
+    {
+        T *fresh = static_cast<T *>(::operator new(n * sizeof(T)));
+        size_type done = 0;
+        try
+        {
+            if (emplace)
+                make(fresh + size_);
+            try
+            {
+                for (; done < size_; ++done)
+                    ::new (static_cast<void *>(fresh + done)) T(std::move_if_noexcept(data_[done]));
+            }
+            catch (...)
+            {
+                if (emplace)
+                    fresh[size_].~T();
+                throw;
+            }
+        }
+        catch (...)
+        {
+            for (; done > 0; --done)
+                fresh[done - 1].~T();
+            ::operator delete(static_cast<void *>(fresh));
+            throw;
+        }
+        for (size_type i = size_; i > 0; --i)
+            data_[i - 1].~T();
+        free_heap();
+        data_ = fresh;
+        cap_ = n;
+    }
+
+    T *data_ = inline_data();
+    size_type size_ = 0;
+    size_type cap_ = N;
+    alignas(T) unsigned char inline_[N * sizeof(T)];
+};
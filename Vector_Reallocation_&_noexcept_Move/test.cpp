@@ -1,8 +1,25 @@
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "bench/Harness.hpp"
+
+#define BENCH_ALLOC_HOOKS
+#include "bench/AllocTracker.hpp"
+
+// GrowthVector's malloc/realloc/mremap buffer, counted with operator new.
+#define GROWTH_VECTOR_NOTE_ALLOC(bytes) bench::detail::note_alloc(bytes)
+#define GROWTH_VECTOR_NOTE_FREE(bytes) bench::detail::note_free(bytes)
+
+#include "ChunkedVector.hpp"
+#include "GrowthVector.hpp"
+#include "SmallVector.hpp"
+
 static constexpr std::size_t M = 300000; // keep memory reasonable
 
 struct TNoNoexcept
@@ -23,60 +40,254 @@ struct TNoexcept
     TNoexcept(TNoexcept &&o) noexcept : s(std::move(o.s)) { ++moves; }
 };
 
+// Same payload and the same throwing move as TNoNoexcept, but held through a
+// unique_ptr, so nothing points into the object and its bytes can be moved.
+struct TRelocatable
+{
+    static std::size_t copies, moves;
+    std::unique_ptr<char[]> s;
+    TRelocatable() : s(new char[100]) { std::memset(s.get(), 'x', 100); }
+    TRelocatable(const TRelocatable &o) : s(new char[100]) { std::memcpy(s.get(), o.s.get(), 100), ++copies; }
+    TRelocatable(TRelocatable &&o) /* not noexcept */ : s(std::move(o.s)) { ++moves; }
+};
+
+template <>
+struct is_trivially_relocatable<TRelocatable> : std::true_type
+{
+};
+
 // out-of-class defs (required in C++)
 std::size_t TNoNoexcept::copies = 0;
 std::size_t TNoNoexcept::moves = 0;
 std::size_t TNoexcept::copies = 0;
 std::size_t TNoexcept::moves = 0;
+std::size_t TRelocatable::copies = 0;
+std::size_t TRelocatable::moves = 0;
 
-template <class T>
-void run_emplace(const char *label)
+// What the runners do before the first element: the others can only
+// reserve, GrowthVector takes a hint and allocates on first growth.
+template <class V>
+void apply_hint(V &v, std::size_t n) { v.reserve(n); }
+template <class T, class G>
+void apply_hint(GrowthVector<T, G> &v, std::size_t n) { v.reserve_hint(n); }
+
+// Counts below are from the last timed run; every run starts from an empty
+// vector (of type V, std::vector<T> by default, given `hint` if nonzero).
+// in_place counts growths that kept the first element's address (all of them
+// for ChunkedVector, whose growths add a block and move nothing). allocs,
+// alloc and peak are heap traffic (bench/AllocTracker.hpp), the elements'
+// strings included; GrowthVector reports its malloc/realloc/mremap buffer
+// through its GROWTH_VECTOR_NOTE_* hooks, so its rows compare like for like.
+template <class T, class V = std::vector<T>>
+void run_emplace(const std::string &label, std::size_t hint = 0)
 {
-    T::copies = 0;
-    T::moves = 0;
-    std::vector<T> v;
-    std::size_t reallocs = 0;
-    for (std::size_t i = 0; i < M; ++i)
-    {
-        std::size_t cap_before = v.capacity();
-        v.emplace_back(); // construct in-place; any copies/moves here come from reallocation only
-        if (v.capacity() != cap_before)
-            ++reallocs;
-    }
+    std::size_t size = 0, reallocs = 0, in_place = 0;
+    bench::AllocSample alloc;
+    const bench::Stats st = bench::measure([&]
+                                           {
+        T::copies = 0;
+        T::moves = 0;
+        bench::AllocScope scope;
+        V v;
+        if (hint != 0)
+            apply_hint(v, hint);
+        reallocs = 0;
+        in_place = 0;
+        for (std::size_t i = 0; i < M; ++i)
+        {
+            std::size_t cap_before = v.capacity();
+            const T *data_before = v.empty() ? nullptr : &v[0];
+            v.emplace_back(); // construct in-place; any copies/moves here come from reallocation only
+            if (v.capacity() != cap_before)
+            {
+                ++reallocs;
+                in_place += (data_before != nullptr && &v[0] == data_before);
+            }
+        }
+        size = v.size();
+        alloc = scope.sample(); });
+    bench::record("vector_moves/" + label + "/emplace", st, alloc.metrics());
     std::cout << label << " (emplace): "
-              << "size=" << v.size()
+              << "size=" << size
               << " reallocs=" << reallocs
+              << " in_place=" << in_place
               << " copies=" << T::copies
-              << " moves=" << T::moves << "\n";
+              << " moves=" << T::moves
+              << alloc.format()
+              << " time=" << st.median_ms() << " ms\n";
 }
 
-template <class T>
-void run_push(const char *label)
+template <class T, class V = std::vector<T>>
+void run_push(const std::string &label, std::size_t hint = 0)
 {
-    T::copies = 0;
-    T::moves = 0;
-    std::vector<T> v;
-    std::size_t reallocs = 0;
-    for (std::size_t i = 0; i < M; ++i)
-    {
-        std::size_t cap_before = v.capacity();
-        v.push_back(T()); // adds ~M extra moves from inserting temporaries
-        if (v.capacity() != cap_before)
-            ++reallocs;
-    }
+    std::size_t size = 0, reallocs = 0, in_place = 0;
+    bench::AllocSample alloc;
+    const bench::Stats st = bench::measure([&]
+                                           {
+        T::copies = 0;
+        T::moves = 0;
+        bench::AllocScope scope;
+        V v;
+        if (hint != 0)
+            apply_hint(v, hint);
+        reallocs = 0;
+        in_place = 0;
+        for (std::size_t i = 0; i < M; ++i)
+        {
+            std::size_t cap_before = v.capacity();
+            const T *data_before = v.empty() ? nullptr : &v[0];
+            v.push_back(T()); // adds ~M extra moves from inserting temporaries
+            if (v.capacity() != cap_before)
+            {
+                ++reallocs;
+                in_place += (data_before != nullptr && &v[0] == data_before);
+            }
+        }
+        size = v.size();
+        alloc = scope.sample(); });
+    bench::record("vector_moves/" + label + "/push_back", st, alloc.metrics());
     std::cout << label << " (push_back): "
-              << "size=" << v.size()
+              << "size=" << size
               << " reallocs=" << reallocs
+              << " in_place=" << in_place
               << " copies=" << T::copies
               << " moves=" << T::moves
+              << alloc.format()
+              << " time=" << st.median_ms() << " ms"
               << "  (insertion moves ~= " << M << ")\n";
 }
 
+template <class V>
+struct Tag
+{
+    using type = V;
+};
+
+// std::vector, then GrowthVector at 2x and 1.5x, SmallVector (past its
+// inline capacity it is one more std::vector) and ChunkedVector, then
+// std::vector and GrowthVector told the final size up front.
+template <class T>
+void run_all(const char *name, bool push)
+{
+    const std::string t = name;
+    auto run = [&](auto tag, const std::string &label, std::size_t hint)
+    {
+        using V = typename decltype(tag)::type;
+        if (push)
+            run_push<T, V>(label, hint);
+        else
+            run_emplace<T, V>(label, hint);
+    };
+    run(Tag<std::vector<T>>{}, t, 0);
+    run(Tag<GrowthVector<T, Growth2x>>{}, t + "/growth_2x", 0);
+    run(Tag<GrowthVector<T, Growth1_5x>>{}, t + "/growth_1.5x", 0);
+    run(Tag<SmallVector<T, 16>>{}, t + "/small_16", 0);
+    run(Tag<ChunkedVector<T>>{}, t + "/chunked", 0);
+    run(Tag<std::vector<T>>{}, t + "/reserve", M);
+    run(Tag<GrowthVector<T>>{}, t + "/growth_hint", M);
+}
+
+// Many short-lived vectors of `len` ints each, the case SmallVector is for:
+// ns per vector built, filled and destroyed, and reallocations per vector
+// (the first heap buffer counts as one).
+template <class V>
+void run_tiny(const std::string &label, std::size_t len)
+{
+    std::size_t reallocs = 0;
+    std::uint64_t sum = 0;
+    bench::AllocSample alloc;
+    const bench::Stats st = bench::measure([&]
+                                           {
+        reallocs = 0;
+        bench::AllocScope scope;
+        for (std::size_t k = 0; k < M; ++k)
+        {
+            V v;
+            for (std::size_t i = 0; i < len; ++i)
+            {
+                const std::size_t cap_before = v.capacity();
+                v.push_back(static_cast<int>(i + k));
+                reallocs += (v.capacity() != cap_before);
+            }
+            sum += static_cast<std::uint64_t>(v[len - 1]);
+            bench::do_not_optimize(sum);
+        }
+        alloc = scope.sample(); });
+    const double per = st.median_ns / static_cast<double>(M);
+    std::vector<bench::Metric> metrics = alloc.metrics();
+    metrics.push_back({"ns_per_vector", per});
+    bench::record("vector_moves/tiny/" + label + "/len=" + std::to_string(len), st, metrics);
+    std::cout << label << " (tiny, len=" << len << "): "
+              << "reallocs/vector=" << static_cast<double>(reallocs) / static_cast<double>(M);
+    if (alloc.any())
+        std::cout << " allocs/vector=" << static_cast<double>(alloc.allocs) / static_cast<double>(M);
+    std::cout << " time/vector=" << per << " ns\n";
+}
+
+// Latency of each of M push_backs into one growing vector: the median is
+// the common case, the tail is the pushes that reallocate. worst_at is the
+// size before the slowest push.
+template <class T, class V>
+void run_latency(const std::string &label)
+{
+    std::vector<double> ns(M);
+    std::size_t worst_at = 0;
+    for (int pass = 0; pass < 2; ++pass) // first pass warms the allocator
+    {
+        V v;
+        for (std::size_t i = 0; i < M; ++i)
+        {
+            const std::int64_t t0 = bench::now_ns();
+            v.push_back(T());
+            ns[i] = static_cast<double>(bench::now_ns() - t0);
+        }
+        bench::do_not_optimize(v[M - 1]);
+    }
+    worst_at = static_cast<std::size_t>(std::max_element(ns.begin(), ns.end()) - ns.begin());
+    std::vector<double> sorted = ns;
+    std::sort(sorted.begin(), sorted.end());
+    const double p999 = sorted[sorted.size() - 1 - sorted.size() / 1000];
+    const bench::Stats st = bench::summarize(std::move(ns));
+    bench::record("vector_moves/latency/" + label, st, {{"p999_ns", p999}, {"worst_at", static_cast<double>(worst_at)}});
+    std::cout << label << " (push_back latency): "
+              << "p50=" << st.median_ns << " p99=" << st.p99_ns << " p99.9=" << p999
+              << " max=" << st.max_ns / 1e3 << " us worst_at=" << worst_at << "\n";
+}
+
+template <class T>
+void run_latency_all(const char *name)
+{
+    const std::string t = name;
+    run_latency<T, std::vector<T>>(t);
+    run_latency<T, GrowthVector<T>>(t + "/growth_2x");
+    run_latency<T, ChunkedVector<T>>(t + "/chunked");
+}
+
 int main()
 {
-    run_emplace<TNoNoexcept>("TNoNoexcept"); // expect: copies > 0, moves ~ 0 (copies used on reallocation)
-    run_emplace<TNoexcept>("TNoexcept");     // expect: copies == 0, moves > 0 (moves used on reallocation)
+    // std::vector rows: TNoNoexcept copies on reallocation, TNoexcept moves,
+    // TRelocatable (throwing move) copies. GrowthVector rows: the same, except
+    // TRelocatable is relocated as bytes (0 copies, 0 moves from growth).
+    run_all<TNoNoexcept>("TNoNoexcept", false);
+    run_all<TNoexcept>("TNoexcept", false);
+    run_all<TRelocatable>("TRelocatable", false);
     std::cout << "----\n";
-    run_push<TNoNoexcept>("TNoNoexcept"); // expect: copies > 0, moves ≈ M + (realloc moves)
-    run_push<TNoexcept>("TNoexcept");     // expect: copies == 0, moves > M
-}
\ No newline at end of file
+    // push_back adds ~M moves from inserting temporaries on every row.
+    run_all<TNoNoexcept>("TNoNoexcept", true);
+    run_all<TNoexcept>("TNoexcept", true);
+    run_all<TRelocatable>("TRelocatable", true);
+    std::cout << "----\n";
+    // Tiny vectors: std::vector allocates 1, 2, 4, ...; SmallVector<int, 8>
+    // not at all up to 8, then once per doubling.
+    for (std::size_t len : {2, 8, 16})
+    {
+        run_tiny<std::vector<int>>("std::vector", len);
+        run_tiny<SmallVector<int, 8>>("small_8", len);
+    }
+    std::cout << "----\n";
+    // Tail latency: std::vector's slowest push copies or moves every element
+    // so far; ChunkedVector's allocates one block.
+    run_latency_all<TNoNoexcept>("TNoNoexcept");
+    run_latency_all<TNoexcept>("TNoexcept");
+    run_latency_all<TRelocatable>("TRelocatable");
+}
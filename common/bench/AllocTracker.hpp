@@ -0,0 +1,231 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "Harness.hpp"
+
+// Heap traffic around a region of code: operator new calls, bytes requested
+// and the peak of live bytes above the level at the start, to show what a
+// reallocation or a pool really saves next to the copy/move counts.
+//
+//   // in exactly one .cpp of the executable, before the include:
+//   #define BENCH_ALLOC_HOOKS
+//   #include "bench/AllocTracker.hpp"
+//
+//   bench::AllocScope scope;
+//   work();
+//   bench::AllocSample a = scope.sample(); // a.allocs, a.bytes, a.peak_bytes
+//
+// BENCH_ALLOC_HOOKS replaces the global operator new/delete (every form) with
+// malloc plus a small size header, counting on any thread. Without it every
+// count is -1 and format() prints nothing. malloc, realloc and mmap called
+// directly are not seen unless the caller reports them through
+// detail::note_alloc/note_free (as vector_moves does for GrowthVector's
+// buffer). Scopes may nest; while an inner scope is open the outer one's
+// peak is not updated.
+
+namespace bench
+{
+
+    struct AllocSample
+    {
+        std::int64_t allocs = -1, frees = -1, bytes = -1, peak_bytes = -1; // -1: hooks not compiled in
+
+        bool any() const noexcept { return allocs >= 0; }
+
+        std::vector<Metric> metrics() const
+        {
+            if (!any())
+                return {};
+            return {Metric{"allocs", static_cast<double>(allocs)}, Metric{"alloc_bytes", static_cast<double>(bytes)},
+                    Metric{"peak_bytes", static_cast<double>(peak_bytes)}};
+        }
+
+        // " allocs=20 alloc=18.9MB peak=14.2MB" (empty without the hooks).
+        std::string format() const
+        {
+            if (!any())
+                return std::string();
+            return " allocs=" + std::to_string(allocs) + " alloc=" + size_text(bytes) + " peak=" + size_text(peak_bytes);
+        }
+
+    private:
+        static std::string size_text(std::int64_t b)
+        {
+            char buf[32];
+            if (b >= 1000000)
+                std::snprintf(buf, sizeof(buf), "%.1fMB", static_cast<double>(b) / 1e6);
+            else if (b >= 1000)
+                std::snprintf(buf, sizeof(buf), "%.1fKB", static_cast<double>(b) / 1e3);
+            else
+                std::snprintf(buf, sizeof(buf), "%lldB", static_cast<long long>(b));
+            return buf;
+        }
+    };
+
+    namespace detail
+    {
+        struct AllocCounters
+        {
+            std::atomic<std::int64_t> allocs{0}, frees{0}, bytes{0}, live{0}, peak{0};
+            std::atomic<bool> hooked{false};
+        };
+
+        // Constant-initialised, so usable by allocations made before main().
+        inline AllocCounters g_alloc;
+
+        inline void raise_peak(std::int64_t v) noexcept
+        {
+            std::int64_t p = g_alloc.peak.load(std::memory_order_relaxed);
+            while (v > p && !g_alloc.peak.compare_exchange_weak(p, v, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        inline void note_alloc(std::size_t n) noexcept
+        {
+            g_alloc.allocs.fetch_add(1, std::memory_order_relaxed);
+            g_alloc.bytes.fetch_add(static_cast<std::int64_t>(n), std::memory_order_relaxed);
+            raise_peak(g_alloc.live.fetch_add(static_cast<std::int64_t>(n), std::memory_order_relaxed) +
+                       static_cast<std::int64_t>(n));
+        }
+
+        inline void note_free(std::size_t n) noexcept
+        {
+            g_alloc.frees.fetch_add(1, std::memory_order_relaxed);
+            g_alloc.live.fetch_sub(static_cast<std::int64_t>(n), std::memory_order_relaxed);
+        }
+    } // namespace detail
+
+    // Counts from construction to sample().
+    class AllocScope
+    {
+    public:
+        AllocScope() noexcept
+            : _allocs(detail::g_alloc.allocs.load(std::memory_order_relaxed)),
+              _frees(detail::g_alloc.frees.load(std::memory_order_relaxed)),
+              _bytes(detail::g_alloc.bytes.load(std::memory_order_relaxed)),
+              _live(detail::g_alloc.live.load(std::memory_order_relaxed)),
+              _outer_peak(detail::g_alloc.peak.exchange(_live, std::memory_order_relaxed))
+        {
+        }
+
+        ~AllocScope() { detail::raise_peak(_outer_peak); }
+
+        AllocScope(const AllocScope &) = delete;
+        AllocScope &operator=(const AllocScope &) = delete;
+
+        AllocSample sample() const noexcept
+        {
+            AllocSample s;
+            if (!detail::g_alloc.hooked.load(std::memory_order_relaxed))
+                return s;
+            s.allocs = detail::g_alloc.allocs.load(std::memory_order_relaxed) - _allocs;
+            s.frees = detail::g_alloc.frees.load(std::memory_order_relaxed) - _frees;
+            s.bytes = detail::g_alloc.bytes.load(std::memory_order_relaxed) - _bytes;
+            s.peak_bytes = detail::g_alloc.peak.load(std::memory_order_relaxed) - _live;
+            return s;
+        }
+
+    private:
+        std::int64_t _allocs, _frees, _bytes, _live, _outer_peak;
+    };
+
+} // namespace bench
+
+#if defined(BENCH_ALLOC_HOOKS)
+namespace bench
+{
+    namespace detail
+    {
+        // Block layout: [padding][u64 size][void *raw] user bytes; the two
+        // words sit just below the pointer handed out, which is aligned to
+        // max(align, 16).
+        inline void *hooked_malloc(std::size_t n, std::size_t align) noexcept
+        {
+            const std::size_t a = align < 16 ? 16 : align;
+            if (n > static_cast<std::size_t>(-1) - 2 * a)
+                return nullptr;
+            unsigned char *raw = static_cast<unsigned char *>(std::malloc(n + (a == 16 ? 16 : a + 16)));
+            if (raw == nullptr)
+                return nullptr;
+            const std::uintptr_t u = reinterpret_cast<std::uintptr_t>(raw) + 16;
+            unsigned char *p = reinterpret_cast<unsigned char *>((u + a - 1) & ~static_cast<std::uintptr_t>(a - 1));
+            reinterpret_cast<std::uint64_t *>(p)[-2] = n;
+            reinterpret_cast<void **>(p)[-1] = raw;
+            note_alloc(n);
+            return p;
+        }
+
+        inline void hooked_free(void *p) noexcept
+        {
+            if (p == nullptr)
+                return;
+            note_free(static_cast<std::size_t>(static_cast<std::uint64_t *>(p)[-2]));
+            std::free(static_cast<void **>(p)[-1]);
+        }
+
+        inline void *hooked_new(std::size_t n, std::size_t align)
+        {
+            for (;;)
+            {
+                if (void *p = hooked_malloc(n, align))
+                    return p;
+                std::new_handler h = std::get_new_handler();
+                if (h == nullptr)
+                    throw std::bad_alloc();
+                h();
+            }
+        }
+
+        inline void *hooked_new_nothrow(std::size_t n, std::size_t align) noexcept
+        {
+            try
+            {
+                return hooked_new(n, align);
+            }
+            catch (...)
+            {
+                return nullptr;
+            }
+        }
+
+        static const bool alloc_hooks_installed = (g_alloc.hooked.store(true), true);
+    } // namespace detail
+} // namespace bench
+
+void *operator new(std::size_t n) { return bench::detail::hooked_new(n, 16); }
+void *operator new[](std::size_t n) { return bench::detail::hooked_new(n, 16); }
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept { return bench::detail::hooked_new_nothrow(n, 16); }
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept { return bench::detail::hooked_new_nothrow(n, 16); }
+void *operator new(std::size_t n, std::align_val_t a) { return bench::detail::hooked_new(n, static_cast<std::size_t>(a)); }
+void *operator new[](std::size_t n, std::align_val_t a) { return bench::detail::hooked_new(n, static_cast<std::size_t>(a)); }
+void *operator new(std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept
+{
+    return bench::detail::hooked_new_nothrow(n, static_cast<std::size_t>(a));
+}
+void *operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept
+{
+    return bench::detail::hooked_new_nothrow(n, static_cast<std::size_t>(a));
+}
+
+void operator delete(void *p) noexcept { bench::detail::hooked_free(p); }
+void operator delete[](void *p) noexcept { bench::detail::hooked_free(p); }
+void operator delete(void *p, std::size_t) noexcept { bench::detail::hooked_free(p); }
+void operator delete[](void *p, std::size_t) noexcept { bench::detail::hooked_free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { bench::detail::hooked_free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { bench::detail::hooked_free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { bench::detail::hooked_free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { bench::detail::hooked_free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { bench::detail::hooked_free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { bench::detail::hooked_free(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { bench::detail::hooked_free(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { bench::detail::hooked_free(p); }
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+// kCacheLineSize: distance that keeps two independently written objects off the
+// same cache line, std::hardware_destructive_interference_size where the
+// library has it, else 64. GCC warns that the value depends on -mtune; it is
+// only used for padding inside this repo, never across an ABI boundary.
+
+namespace bench
+{
+
+#if defined(__cpp_lib_hardware_interference_size)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+    inline constexpr std::size_t kCacheLineSize = std::hardware_destructive_interference_size;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+    inline constexpr std::size_t kCacheLineSize = 64;
+#endif
+
+    static_assert((kCacheLineSize & (kCacheLineSize - 1)) == 0, "cache line size must be a power of two");
+
+    // Spacing for data written by different threads. Bigger than a line where
+    // that is not enough: Intel's adjacent-line prefetcher pulls 64-byte lines
+    // in pairs, and Apple M-series lines are 128 bytes. Override with the
+    // BENCH_PAD_BYTES CMake cache variable (-DBENCH_PAD_BYTES=64); measure
+    // with `false_sharing spacing` and `spsc spacing`.
+#if defined(BENCH_PAD_BYTES)
+    inline constexpr std::size_t kPadSize = BENCH_PAD_BYTES;
+#elif defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86) || \
+    (defined(__APPLE__) && defined(__aarch64__))
+    inline constexpr std::size_t kPadSize = 128;
+#else
+    inline constexpr std::size_t kPadSize = kCacheLineSize;
+#endif
+
+    static_assert((kPadSize & (kPadSize - 1)) == 0 && kPadSize >= 8, "padding must be a power of two >= 8");
+
+} // namespace bench
@@ -0,0 +1,424 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// Small statistical benchmark harness shared by every demo.
+//
+//   bench::Stats s = bench::measure([&] { kernel(); });
+//   bench::record("case1/soa", s, {{"GB/s", gbps}});
+//
+// measure() runs f until two consecutive warm-up timings agree (or a cap is
+// hit), then times `reps` more runs and summarises them. record() keeps the
+// result; when BENCH_FORMAT=json or csv is set the collected results are
+// written at exit (to BENCH_OUT, or stdout), tagged with the compiler and
+// build type so runs from different builds can be diffed.
+//
+// Environment: BENCH_REPS (timed runs), BENCH_WARMUP (max warm-up runs),
+// BENCH_FORMAT (text|json|csv), BENCH_OUT (output file).
+
+namespace bench
+{
+
+    inline std::int64_t now_ns() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // ----------------------------- optimiser fences -----------------------------
+    // do_not_optimize(v): v's value is treated as used (the computation producing
+    // it cannot be dropped) and, for lvalues, as possibly modified.
+    // clobber_memory(): all pending stores are treated as observed.
+
+#if defined(__GNUC__) || defined(__clang__)
+    template <class T>
+    inline void do_not_optimize(const T &v)
+    {
+        asm volatile("" : : "r,m"(v) : "memory");
+    }
+    template <class T>
+    inline void do_not_optimize(T &v)
+    {
+#if defined(__clang__)
+        asm volatile("" : "+r,m"(v) : : "memory");
+#else
+        // GCC can reject "+r,m" as impossible once v's producer is inlined.
+        asm volatile("" : "+m,r"(v) : : "memory");
+#endif
+    }
+    inline void clobber_memory() { asm volatile("" : : : "memory"); }
+#else
+    namespace detail
+    {
+        inline const volatile void *volatile g_sink = nullptr;
+    }
+    template <class T>
+    inline void do_not_optimize(const T &v)
+    {
+        detail::g_sink = &v;
+        _ReadWriteBarrier();
+    }
+    inline void clobber_memory() { _ReadWriteBarrier(); }
+#endif
+
+    // -------------------------------- CPU pinning -------------------------------
+
+    // CPUs this process may run on, in ascending order (empty if unknown).
+    inline std::vector<int> allowed_cpus()
+    {
+        std::vector<int> cpus;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        {
+            for (int c = 0; c < CPU_SETSIZE; ++c)
+                if (CPU_ISSET(c, &set))
+                    cpus.push_back(c);
+        }
+#elif defined(_WIN32)
+        DWORD_PTR proc = 0, sys = 0;
+        if (GetProcessAffinityMask(GetCurrentProcess(), &proc, &sys))
+        {
+            for (int c = 0; c < static_cast<int>(sizeof(DWORD_PTR) * 8); ++c)
+                if (proc & (DWORD_PTR(1) << c))
+                    cpus.push_back(c);
+        }
+#endif
+        return cpus;
+    }
+
+    // The i-th allowed CPU, wrapping when there are fewer CPUs than i (-1 if unknown).
+    inline int nth_cpu(std::size_t i)
+    {
+        const std::vector<int> cpus = allowed_cpus();
+        return cpus.empty() ? -1 : cpus[i % cpus.size()];
+    }
+
+    // Restrict the calling thread to one CPU; false if cpu < 0 or the OS refused.
+    // Pin worker threads, not main: threads created later inherit main's mask.
+    inline bool pin_this_thread(int cpu) noexcept
+    {
+        if (cpu < 0)
+            return false;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+        return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#else
+        return false;
+#endif
+    }
+
+    // --------------------------------- options ----------------------------------
+
+    namespace detail
+    {
+        inline std::size_t env_size(const char *name, std::size_t fallback)
+        {
+            const char *s = std::getenv(name);
+            if (s == nullptr || *s == '\0')
+                return fallback;
+            char *end = nullptr;
+            const unsigned long long v = std::strtoull(s, &end, 10);
+            return (end != s && *end == '\0') ? static_cast<std::size_t>(v) : fallback;
+        }
+
+        inline std::string env_string(const char *name)
+        {
+            const char *s = std::getenv(name);
+            return s == nullptr ? std::string() : std::string(s);
+        }
+    }
+
+    struct Options
+    {
+        std::size_t reps = 5;        // timed runs
+        std::size_t warmup_max = 5;  // warm-up runs at most (at least one is done)
+        double warmup_tol = 0.05;    // "stable": two runs within 5% of each other
+        bool until_stable = true;    // false: always exactly warmup_max warm-ups
+
+        // Defaults chosen by the caller, overridden by BENCH_REPS / BENCH_WARMUP.
+        static Options from_env(std::size_t reps = 5, std::size_t warmup_max = 5)
+        {
+            Options o;
+            o.reps = std::max<std::size_t>(1, detail::env_size("BENCH_REPS", reps));
+            o.warmup_max = std::max<std::size_t>(1, detail::env_size("BENCH_WARMUP", warmup_max));
+            return o;
+        }
+    };
+
+    // ---------------------------------- stats -----------------------------------
+
+    struct Stats
+    {
+        std::size_t reps = 0;
+        double min_ns = 0, median_ns = 0, mean_ns = 0, p99_ns = 0, max_ns = 0, stddev_ns = 0;
+
+        double median_ms() const noexcept { return median_ns * 1e-6; }
+        double min_ms() const noexcept { return min_ns * 1e-6; }
+        // Relative spread; above a few percent the numbers are noise-dominated.
+        double cv() const noexcept { return mean_ns > 0 ? stddev_ns / mean_ns : 0.0; }
+    };
+
+    inline Stats summarize(std::vector<double> ns)
+    {
+        Stats s;
+        if (ns.empty())
+            return s;
+        std::sort(ns.begin(), ns.end());
+        const std::size_t n = ns.size();
+        s.reps = n;
+        s.min_ns = ns.front();
+        s.max_ns = ns.back();
+        s.median_ns = (n % 2) ? ns[n / 2] : 0.5 * (ns[n / 2 - 1] + ns[n / 2]);
+        const std::size_t rank = static_cast<std::size_t>(std::ceil(0.99 * static_cast<double>(n))); // nearest rank
+        s.p99_ns = ns[rank == 0 ? 0 : rank - 1];
+        double sum = 0;
+        for (double v : ns)
+            sum += v;
+        s.mean_ns = sum / static_cast<double>(n);
+        double sq = 0;
+        for (double v : ns)
+            sq += (v - s.mean_ns) * (v - s.mean_ns);
+        s.stddev_ns = std::sqrt(sq / static_cast<double>(n));
+        return s;
+    }
+
+    namespace detail
+    {
+        template <class F>
+        void warm_up(F &f, const Options &opt)
+        {
+            double prev = -1;
+            for (std::size_t w = 0; w < opt.warmup_max; ++w)
+            {
+                const std::int64_t t0 = now_ns();
+                f();
+                clobber_memory();
+                const double t = static_cast<double>(now_ns() - t0);
+                if (opt.until_stable && prev > 0 && std::fabs(t - prev) <= opt.warmup_tol * prev)
+                    break;
+                prev = t;
+            }
+        }
+
+        template <class F>
+        Stats timed_runs(F &f, const Options &opt)
+        {
+            std::vector<double> ns;
+            ns.reserve(opt.reps);
+            for (std::size_t r = 0; r < opt.reps; ++r)
+            {
+                const std::int64_t t0 = now_ns();
+                f();
+                clobber_memory();
+                ns.push_back(static_cast<double>(now_ns() - t0));
+            }
+            return summarize(std::move(ns));
+        }
+    }
+
+    // Warm up until two consecutive runs agree within warmup_tol, then time reps
+    // runs. Kernels that update their data in place should set until_stable =
+    // false so that every run of them does the same number of passes.
+    template <class F>
+    Stats measure(F &&f, const Options &opt = Options::from_env())
+    {
+        detail::warm_up(f, opt);
+        return detail::timed_runs(f, opt);
+    }
+
+    // Time one call of f (for runs that are too long, or too stateful, to repeat).
+    template <class F>
+    double time_once_ns(F &&f)
+    {
+        const std::int64_t t0 = now_ns();
+        f();
+        clobber_memory();
+        return static_cast<double>(now_ns() - t0);
+    }
+
+    // --------------------------------- results ----------------------------------
+
+    struct Metric
+    {
+        const char *name;
+        double value;
+    };
+
+    class Results
+    {
+    public:
+        static Results &get()
+        {
+            static Results r;
+            return r;
+        }
+
+        void add(std::string name, const Stats &s, std::vector<Metric> metrics)
+        {
+            _rows.push_back(Row{std::move(name), s, std::move(metrics)});
+        }
+
+        // Write everything recorded so far in BENCH_FORMAT (no-op for text/unset).
+        void flush()
+        {
+            const std::string fmt = detail::env_string("BENCH_FORMAT");
+            if ((fmt != "json" && fmt != "csv") || _rows.empty())
+                return;
+            const std::string path = detail::env_string("BENCH_OUT");
+            std::FILE *out = path.empty() ? stdout : std::fopen(path.c_str(), "w");
+            if (out == nullptr)
+            {
+                std::fprintf(stderr, "bench: cannot open %s\n", path.c_str());
+                return;
+            }
+            if (fmt == "json")
+                write_json(out);
+            else
+                write_csv(out);
+            if (out != stdout)
+                std::fclose(out);
+            _rows.clear();
+        }
+
+        ~Results() { flush(); }
+
+    private:
+        struct Row
+        {
+            std::string name;
+            Stats stats;
+            std::vector<Metric> metrics;
+        };
+
+        Results() = default;
+
+        static const char *compiler() noexcept
+        {
+#if defined(__clang__)
+            return "clang " __clang_version__;
+#elif defined(__GNUC__)
+            return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+            return "msvc";
+#else
+            return "unknown";
+#endif
+        }
+
+        static const char *build_type() noexcept
+        {
+#if defined(NDEBUG)
+            return "release";
+#else
+            return "debug";
+#endif
+        }
+
+        static void put_json_string(std::FILE *out, const std::string &s)
+        {
+            std::fputc('"', out);
+            for (char c : s)
+            {
+                if (c == '"' || c == '\\')
+                    std::fputc('\\', out);
+                std::fputc(c, out);
+            }
+            std::fputc('"', out);
+        }
+
+        // JSON has no inf/nan (e.g. a rate from a zero-length run): write null.
+        static void put_json_number(std::FILE *out, const char *fmt, double v)
+        {
+            if (std::isfinite(v))
+                std::fprintf(out, fmt, v);
+            else
+                std::fputs("null", out);
+        }
+
+        void write_json(std::FILE *out) const
+        {
+            std::fprintf(out, "{\n  \"context\": {\"compiler\": ");
+            put_json_string(out, compiler());
+            std::fprintf(out, ", \"build\": \"%s\", \"cpus\": %zu},\n  \"results\": [\n",
+                         build_type(), allowed_cpus().size());
+            for (std::size_t i = 0; i < _rows.size(); ++i)
+            {
+                const Row &r = _rows[i];
+                std::fprintf(out, "    {\"name\": ");
+                put_json_string(out, r.name);
+                std::fprintf(out, ", \"reps\": %zu", r.stats.reps);
+                const std::pair<const char *, double> stats[] = {
+                    {"min_ns", r.stats.min_ns}, {"median_ns", r.stats.median_ns},
+                    {"mean_ns", r.stats.mean_ns}, {"p99_ns", r.stats.p99_ns},
+                    {"max_ns", r.stats.max_ns}, {"stddev_ns", r.stats.stddev_ns}};
+                for (const auto &st : stats)
+                {
+                    std::fprintf(out, ", \"%s\": ", st.first);
+                    put_json_number(out, "%.1f", st.second);
+                }
+                for (const Metric &m : r.metrics)
+                {
+                    std::fprintf(out, ", ");
+                    put_json_string(out, m.name);
+                    std::fprintf(out, ": ");
+                    put_json_number(out, "%.6g", m.value);
+                }
+                std::fprintf(out, "}%s\n", i + 1 < _rows.size() ? "," : "");
+            }
+            std::fprintf(out, "  ]\n}\n");
+        }
+
+        // One row per result; extra metrics go in a trailing "name=value;..." column.
+        void write_csv(std::FILE *out) const
+        {
+            std::fprintf(out, "name,reps,min_ns,median_ns,mean_ns,p99_ns,max_ns,stddev_ns,metrics,compiler,build\n");
+            for (const Row &r : _rows)
+            {
+                std::fprintf(out, "%s,%zu,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,", r.name.c_str(), r.stats.reps,
+                             r.stats.min_ns, r.stats.median_ns, r.stats.mean_ns, r.stats.p99_ns,
+                             r.stats.max_ns, r.stats.stddev_ns);
+                for (std::size_t i = 0; i < r.metrics.size(); ++i)
+                    std::fprintf(out, "%s%s=%.6g", i ? ";" : "", r.metrics[i].name, r.metrics[i].value);
+                std::fprintf(out, ",\"%s\",%s\n", compiler(), build_type());
+            }
+        }
+
+        std::vector<Row> _rows;
+    };
+
+    inline void record(std::string name, const Stats &s, std::vector<Metric> metrics = {})
+    {
+        Results::get().add(std::move(name), s, std::move(metrics));
+    }
+
+} // namespace bench
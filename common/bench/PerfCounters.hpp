@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Harness.hpp"
+
+#if defined(BENCH_PERF_COUNTERS) && defined(__linux__)
+#define BENCH_PERF_LINUX 1
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#endif
+
+// Hardware event counts around a timed region, to explain the wall-time
+// numbers: cycles, instructions, L1D and LLC load misses, HITM loads (lines
+// fetched from another core's modified copy: the false-sharing signature) and
+// loads served from a remote NUMA node.
+//
+// Compiled in with -DBENCH_PERF_COUNTERS=ON (Linux perf_event_open); otherwise,
+// or when the kernel refuses (perf_event_paranoid, containers), every count is
+// -1 and format() prints nothing. Counters are per process: threads created
+// after start() are included once they have exited, threads that already
+// existed (a pre-started pool) are not.
+//
+// HITM has no generic perf event. On Intel CPUs the raw event 0x04d2
+// (MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM, Skylake..Ice Lake) is used; set
+// BENCH_PERF_HITM=<raw config, hex> for other models, or 0 to skip it.
+
+namespace bench
+{
+
+    enum PerfEvent : unsigned
+    {
+        kPerfCycles,
+        kPerfInstructions,
+        kPerfL1DMisses,
+        kPerfLLCMisses,
+        kPerfHITM,
+        kPerfRemote,
+        kPerfEventCount
+    };
+
+    struct PerfSample
+    {
+        std::int64_t count[kPerfEventCount] = {-1, -1, -1, -1, -1, -1}; // -1: not available
+
+        bool any() const noexcept
+        {
+            for (std::int64_t c : count)
+                if (c >= 0)
+                    return true;
+            return false;
+        }
+
+        // Counts divided by `per` (e.g. elements processed), for record().
+        std::vector<Metric> metrics(double per) const
+        {
+            static const char *const names[kPerfEventCount] = {
+                "cycles", "instructions", "l1d_misses", "llc_misses", "hitm", "remote"};
+            std::vector<Metric> m;
+            for (unsigned e = 0; e < kPerfEventCount; ++e)
+                if (count[e] >= 0)
+                    m.push_back(Metric{names[e], static_cast<double>(count[e]) / per});
+            return m;
+        }
+
+        // " | cyc/op 3.1 IPC 1.20 L1D/op 0.02 LLC/op 0.00 HITM/op 0.50 remote/op n/a"
+        // (empty when counters are compiled out).
+        std::string format(const char *unit, double per) const
+        {
+#if defined(BENCH_PERF_COUNTERS)
+            if (!any())
+                return " | perf: unavailable";
+            static const char *const labels[kPerfEventCount] = {"cyc", "ins", "L1D", "LLC", "HITM", "remote"};
+            std::string s = " | perf";
+            char buf[64];
+            for (unsigned e = 0; e < kPerfEventCount; ++e)
+            {
+                if (e == kPerfInstructions)
+                {
+                    if (count[kPerfCycles] > 0 && count[kPerfInstructions] >= 0)
+                        std::snprintf(buf, sizeof(buf), " IPC %.2f",
+                                      static_cast<double>(count[kPerfInstructions]) / static_cast<double>(count[kPerfCycles]));
+                    else
+                        std::snprintf(buf, sizeof(buf), " IPC n/a");
+                }
+                else if (count[e] >= 0)
+                    std::snprintf(buf, sizeof(buf), " %s/%s %.3g", labels[e], unit, static_cast<double>(count[e]) / per);
+                else
+                    std::snprintf(buf, sizeof(buf), " %s/%s n/a", labels[e], unit);
+                s += buf;
+            }
+            return s;
+#else
+            (void)unit;
+            (void)per;
+            return std::string();
+#endif
+        }
+    };
+
+    class PerfCounters
+    {
+    public:
+        PerfCounters()
+        {
+#if defined(BENCH_PERF_LINUX)
+            open(kPerfCycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+            open(kPerfInstructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+            open(kPerfL1DMisses, PERF_TYPE_HW_CACHE, cache_config(PERF_COUNT_HW_CACHE_L1D));
+            open(kPerfLLCMisses, PERF_TYPE_HW_CACHE, cache_config(PERF_COUNT_HW_CACHE_LL));
+            open(kPerfRemote, PERF_TYPE_HW_CACHE, cache_config(PERF_COUNT_HW_CACHE_NODE));
+            if (const std::uint64_t hitm = hitm_config())
+                open(kPerfHITM, PERF_TYPE_RAW, hitm);
+#endif
+        }
+
+        ~PerfCounters()
+        {
+#if defined(BENCH_PERF_LINUX)
+            for (int fd : _fd)
+                if (fd >= 0)
+                    ::close(fd);
+#endif
+        }
+
+        PerfCounters(const PerfCounters &) = delete;
+        PerfCounters &operator=(const PerfCounters &) = delete;
+
+        void start() noexcept
+        {
+#if defined(BENCH_PERF_LINUX)
+            for (int fd : _fd)
+                if (fd >= 0)
+                {
+                    ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                    ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+#endif
+        }
+
+        // Counts since start(), scaled up if the kernel had to multiplex events.
+        PerfSample stop() noexcept
+        {
+            PerfSample s;
+#if defined(BENCH_PERF_LINUX)
+            for (unsigned e = 0; e < kPerfEventCount; ++e)
+            {
+                if (_fd[e] < 0)
+                    continue;
+                ::ioctl(_fd[e], PERF_EVENT_IOC_DISABLE, 0);
+                std::uint64_t v[3] = {0, 0, 0}; // value, time enabled, time running
+                if (::read(_fd[e], v, sizeof(v)) != static_cast<ssize_t>(sizeof(v)) || v[2] == 0)
+                    continue;
+                const double scale = static_cast<double>(v[1]) / static_cast<double>(v[2]);
+                s.count[e] = static_cast<std::int64_t>(static_cast<double>(v[0]) * scale);
+            }
+#endif
+            return s;
+        }
+
+    private:
+#if defined(BENCH_PERF_LINUX)
+        static std::uint64_t cache_config(std::uint64_t cache) noexcept
+        {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        }
+
+        static std::uint64_t hitm_config() noexcept
+        {
+            const char *env = std::getenv("BENCH_PERF_HITM");
+            if (env != nullptr && *env != '\0')
+                return std::strtoull(env, nullptr, 16);
+#if defined(__x86_64__) || defined(__i386__)
+            unsigned a = 0, b = 0, c = 0, d = 0;
+            if (__get_cpuid(0, &a, &b, &c, &d))
+            {
+                char vendor[13];
+                std::memcpy(vendor, &b, 4);
+                std::memcpy(vendor + 4, &d, 4);
+                std::memcpy(vendor + 8, &c, 4);
+                vendor[12] = '\0';
+                if (std::strcmp(vendor, "GenuineIntel") == 0)
+                    return 0x04d2;
+            }
+#endif
+            return 0;
+        }
+
+        void open(unsigned slot, std::uint32_t type, std::uint64_t config) noexcept
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.inherit = 1; // count threads spawned inside the region too
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            _fd[slot] = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+
+        int _fd[kPerfEventCount] = {-1, -1, -1, -1, -1, -1};
+#endif
+    };
+
+    // One set of counters for the whole process (opening them is not free).
+    inline PerfCounters &process_counters()
+    {
+        static PerfCounters pmc;
+        return pmc;
+    }
+
+    // measure() with the counters running over the timed runs only (not the
+    // warm-up); `sample` receives the per-run average.
+    template <class F>
+    Stats measure(F &&f, const Options &opt, PerfSample &sample)
+    {
+        detail::warm_up(f, opt);
+        PerfCounters &pmc = process_counters();
+        pmc.start();
+        Stats s = detail::timed_runs(f, opt);
+        sample = pmc.stop();
+        for (std::int64_t &c : sample.count)
+            if (c >= 0)
+                c /= static_cast<std::int64_t>(opt.reps);
+        return s;
+    }
+
+} // namespace bench
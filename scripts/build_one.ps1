@@ -1,5 +1,5 @@
 param(
-  [Parameter(Mandatory=$true)][ValidateSet("aos_soa","false_sharing","sizes","spsc","pool_probe","vector_moves")] [string]$target,
+  [Parameter(Mandatory=$true)][ValidateSet("aos_soa","false_sharing","sizes","serialize_nodes","spsc","mpmc","pool_probe","pool_bench","pool_pmr","arena_probe","pool_layout","pool_iter","vector_moves","bench")] [string]$target,
   [switch]$debug,
   [switch]$clean,
   [switch]$run,
@@ -16,9 +16,17 @@ switch ($target) {
   "aos_soa"        { $src="AoS_vs_SoA_Traversal"; $exe="aos_soa" }
   "false_sharing"  { $src="False_Sharing_Demo"; $exe="false_sharing" }
   "sizes"          { $src="LP64_vs_LLP64"; $exe="sizes" }
+  "serialize_nodes" { $src="LP64_vs_LLP64"; $exe="serialize_nodes" }
   "spsc"           { $src="Lock_Free_Ring_Buffer"; $exe="spsc" }
+  "mpmc"           { $src="Lock_Free_Ring_Buffer"; $exe="mpmc" }
   "pool_probe"     { $src="Pool_Allocator_w_Placement_New"; $exe="pool_probe" }
+  "pool_bench"     { $src="Pool_Allocator_w_Placement_New"; $exe="pool_bench" }
+  "pool_pmr"       { $src="Pool_Allocator_w_Placement_New"; $exe="pool_pmr" }
+  "arena_probe"    { $src="Pool_Allocator_w_Placement_New"; $exe="arena_probe" }
+  "pool_layout"    { $src="Pool_Allocator_w_Placement_New"; $exe="pool_layout" }
+  "pool_iter"      { $src="Pool_Allocator_w_Placement_New"; $exe="pool_iter" }
   "vector_moves"   { $src="Vector_Reallocation_&_noexcept_Move"; $exe="vector_moves" }
+  "bench"          { $src="Bench_Driver"; $exe="bench" }
 }
 
 if (!(Test-Path $src)) { Write-Error "Expected folder '$src' not found. Run this from the repo root." }
@@ -4,7 +4,7 @@ set -euo pipefail
 # build_one.sh — build (and optionally run) a single demo in this repo.
 # Usage:
 #   scripts/build_one.sh <target> [--debug] [--clean] [--run [args...]]
-# Targets: aos_soa | false_sharing | sizes | spsc | pool_probe | vector_moves
+# Targets: aos_soa | false_sharing | sizes | serialize_nodes | spsc | mpmc | pool_probe | pool_bench | pool_pmr | arena_probe | pool_layout | pool_iter | vector_moves | bench
 
 if [[ $# -lt 1 ]]; then
   echo "Usage: $0 <target> [--debug] [--clean] [--run [args...]]" >&2
@@ -18,9 +18,17 @@ case "$TARGET" in
   aos_soa)        SRC_DIR="AoS_vs_SoA_Traversal";                EXE="aos_soa" ;;
   false_sharing)  SRC_DIR="False_Sharing_Demo";                   EXE="false_sharing" ;;
   sizes)          SRC_DIR="LP64_vs_LLP64";                        EXE="sizes" ;;
+  serialize_nodes) SRC_DIR="LP64_vs_LLP64";                       EXE="serialize_nodes" ;;
   spsc)           SRC_DIR="Lock_Free_Ring_Buffer";                EXE="spsc" ;;
+  mpmc)           SRC_DIR="Lock_Free_Ring_Buffer";                EXE="mpmc" ;;
   pool_probe)     SRC_DIR="Pool_Allocator_w_Placement_New";       EXE="pool_probe" ;;
+  pool_bench)     SRC_DIR="Pool_Allocator_w_Placement_New";       EXE="pool_bench" ;;
+  pool_pmr)       SRC_DIR="Pool_Allocator_w_Placement_New";       EXE="pool_pmr" ;;
+  arena_probe)    SRC_DIR="Pool_Allocator_w_Placement_New";       EXE="arena_probe" ;;
+  pool_layout)    SRC_DIR="Pool_Allocator_w_Placement_New";       EXE="pool_layout" ;;
+  pool_iter)      SRC_DIR="Pool_Allocator_w_Placement_New";       EXE="pool_iter" ;;
   vector_moves)   SRC_DIR="Vector_Reallocation_&_noexcept_Move";  EXE="vector_moves" ;;
+  bench)          SRC_DIR="Bench_Driver";                         EXE="bench" ;;
   *) echo "Unknown target: $TARGET" >&2; exit 2;;
 esac
 